@@ -0,0 +1,303 @@
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../include/linux_parser.h"
+#include "../include/linux_system.h"
+#include "../include/process.h"
+
+/*
+Process churn stress harness.
+
+Runs `LinuxSystem` against the real /proc while child processes churn it:
+short-lived forks, exec chains, long-lived CPU burners and a many-threaded
+process. Every tick collects the processes as a display would and checks the
+result against the kernel, then the run is summarised:
+
+  - tick latency percentiles of `Processes()`,
+  - exceptions escaping the collection,
+  - misattributed pids, listed with the start time of an earlier process,
+  - processes seen against those forked, from the `processes` counter,
+  - CPU time captured by the listed processes against the active jiffies of
+    /proc/stat.
+
+Forked children are reaped by the kernel, so their CPU time is not charged to
+the parent and the captured fraction counts only what the scan saw.
+
+Usage: monitor_stress [--seconds N] [--interval-ms N] [--fork-rate N]
+                      [--exec-rate N] [--exec-depth N] [--burners N]
+                      [--threads N]
+*/
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::string kStatFilePath =
+    LinuxParser::kProcDirectory + LinuxParser::kStatFilename;
+// Run by the children of an exec chain, ahead of the harness options.
+const std::string kExecLinkArg = "--exec-link";
+
+struct Settings {
+  int seconds{10};
+  int interval_ms{100};
+  // Short-lived children forked per second.
+  int fork_rate{1000};
+  // Exec chains started per second, and the execs in each.
+  int exec_rate{20};
+  int exec_depth{8};
+  int burners{2};
+  // Threads of the many-threaded process, 0 for none.
+  int threads{64};
+};
+
+void Spin(std::chrono::microseconds duration) {
+  const auto end = Clock::now() + duration;
+  while (Clock::now() < end) {
+  }
+}
+
+// Starts a workload in a process group of its own, which dies with the
+// harness.
+pid_t StartWorkload(void (*workload)(const Settings&),
+                    const Settings& settings) {
+  const pid_t pid = fork();
+  if (pid < 0) {
+    throw std::runtime_error("could not fork a workload");
+  }
+  if (pid == 0) {
+    setpgid(0, 0);
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    workload(settings);
+    _exit(0);
+  }
+  setpgid(pid, pid);
+  return pid;
+}
+
+// Forks children at a steady rate, each busy for a millisecond. The kernel
+// reaps them, as SIGCHLD is ignored.
+void ForkStorm(const Settings& settings) {
+  signal(SIGCHLD, SIG_IGN);
+  const auto period = std::chrono::nanoseconds(1'000'000'000) /
+                      std::max(settings.fork_rate, 1);
+  for (auto next = Clock::now();; next += period) {
+    std::this_thread::sleep_until(next);
+    if (fork() == 0) {
+      Spin(std::chrono::milliseconds(1));
+      _exit(0);
+    }
+  }
+}
+
+// Starts chains of processes that exec themselves `exec_depth` times.
+void ExecChains(const Settings& settings) {
+  signal(SIGCHLD, SIG_IGN);
+  const std::string depth = std::to_string(settings.exec_depth);
+  const auto period = std::chrono::nanoseconds(1'000'000'000) /
+                      std::max(settings.exec_rate, 1);
+  for (auto next = Clock::now();; next += period) {
+    std::this_thread::sleep_until(next);
+    if (fork() == 0) {
+      execl("/proc/self/exe", "monitor_stress", kExecLinkArg.c_str(),
+            depth.c_str(), nullptr);
+      _exit(1);
+    }
+  }
+}
+
+void ExecLink(int depth) {
+  Spin(std::chrono::milliseconds(1));
+  if (depth > 0) {
+    const std::string next = std::to_string(depth - 1);
+    execl("/proc/self/exe", "monitor_stress", kExecLinkArg.c_str(),
+          next.c_str(), nullptr);
+  }
+  _exit(0);
+}
+
+void Burner(const Settings&) {
+  while (true) {
+  }
+}
+
+// Threads that are busy half of the time.
+void Threaded(const Settings& settings) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < settings.threads; ++i) {
+    threads.emplace_back([] {
+      while (true) {
+        Spin(std::chrono::milliseconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+Settings Parse(const std::vector<std::string>& args) {
+  Settings settings;
+  const std::vector<std::pair<std::string, int*>> flags{
+      {"--seconds", &settings.seconds},
+      {"--interval-ms", &settings.interval_ms},
+      {"--fork-rate", &settings.fork_rate},
+      {"--exec-rate", &settings.exec_rate},
+      {"--exec-depth", &settings.exec_depth},
+      {"--burners", &settings.burners},
+      {"--threads", &settings.threads}};
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const auto flag =
+        std::find_if(flags.begin(), flags.end(),
+                     [&](const auto& flag) { return flag.first == args[i]; });
+    if (flag == flags.end() || i + 1 == args.size()) {
+      throw std::invalid_argument("unknown or incomplete option " + args[i]);
+    }
+    *flag->second = std::stoi(args[++i]);
+  }
+  return settings;
+}
+
+double Percentile(std::vector<double> values, double percentile) {
+  if (values.empty()) {
+    return 0;
+  }
+  const std::size_t rank = std::min(
+      values.size() - 1, std::size_t(percentile / 100 * values.size()));
+  std::nth_element(values.begin(), values.begin() + rank, values.end());
+  return values[rank];
+}
+
+// A process told apart from earlier ones with the same pid.
+struct Key {
+  int pid;
+  long start_time;
+  bool operator==(const Key& other) const {
+    return pid == other.pid && start_time == other.start_time;
+  }
+};
+
+struct KeyHash {
+  std::size_t operator()(const Key& key) const {
+    return std::hash<long>()(key.start_time) * 31 + key.pid;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc == 3 && argv[1] == kExecLinkArg) {
+    ExecLink(std::atoi(argv[2]));
+  }
+  Settings settings;
+  try {
+    settings = Parse(std::vector<std::string>(argv + 1, argv + argc));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+
+  std::vector<pid_t> workloads;
+  if (settings.fork_rate > 0) {
+    workloads.push_back(StartWorkload(ForkStorm, settings));
+  }
+  if (settings.exec_rate > 0 && settings.exec_depth > 0) {
+    workloads.push_back(StartWorkload(ExecChains, settings));
+  }
+  for (int i = 0; i < settings.burners; ++i) {
+    workloads.push_back(StartWorkload(Burner, settings));
+  }
+  if (settings.threads > 0) {
+    workloads.push_back(StartWorkload(Threaded, settings));
+  }
+
+  LinuxSystem system;
+  std::vector<double> latencies;
+  long exceptions{0};
+  std::string first_exception;
+  long misattributed{0};
+  std::unordered_set<Key, KeyHash> seen;
+  // The CPU ticks of each listed process at the previous tick.
+  std::unordered_map<Key, long, KeyHash> previous_ticks;
+  long captured_ticks{0};
+  const long first_forks = LinuxParser::TotalProcesses(kStatFilePath);
+  const long first_active = LinuxParser::ActiveJiffies(kStatFilePath);
+  const auto interval = std::chrono::milliseconds(settings.interval_ms);
+  const auto end = Clock::now() + std::chrono::seconds(settings.seconds);
+  // Ticks that overrun the interval are followed at once by the next one.
+  for (auto next = Clock::now(); Clock::now() < end; next += interval) {
+    std::this_thread::sleep_until(next);
+    const auto start = Clock::now();
+    std::vector<Process>* processes;
+    try {
+      processes = &system.Processes();
+    } catch (const std::exception& e) {
+      if (exceptions++ == 0) {
+        first_exception = e.what();
+      }
+      continue;
+    }
+    latencies.push_back(
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count());
+
+    std::unordered_map<Key, long, KeyHash> ticks;
+    for (Process& proc : *processes) {
+      const Key key{proc.Pid(), proc.StartTime()};
+      std::string comm;
+      long start_time;
+      if (LinuxParser::ProcessIdentity(
+              std::filesystem::path(LinuxParser::kProcDirectory) /
+                  std::to_string(key.pid) / LinuxParser::kProcStatFilePath,
+              comm, start_time) &&
+          start_time != key.start_time) {
+        ++misattributed;
+      }
+      seen.insert(key);
+      ticks[key] = proc.TotalTicks();
+      const auto previous = previous_ticks.find(key);
+      if (previous != previous_ticks.end()) {
+        captured_ticks += ticks[key] - previous->second;
+      }
+    }
+    previous_ticks.swap(ticks);
+  }
+  const long forks = LinuxParser::TotalProcesses(kStatFilePath) - first_forks;
+  const long active = LinuxParser::ActiveJiffies(kStatFilePath) - first_active;
+
+  for (const pid_t workload : workloads) {
+    kill(-workload, SIGKILL);
+  }
+  for (const pid_t workload : workloads) {
+    waitpid(workload, nullptr, 0);
+  }
+
+  std::printf("ticks: %zu of %d ms over %d s\n", latencies.size(),
+              settings.interval_ms, settings.seconds);
+  std::printf("tick latency ms: p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+              Percentile(latencies, 50), Percentile(latencies, 90),
+              Percentile(latencies, 99), Percentile(latencies, 100));
+  std::printf("exceptions: %ld%s%s\n", exceptions,
+              exceptions ? ", first: " : "", first_exception.c_str());
+  std::printf("misattributed pids: %ld\n", misattributed);
+  std::printf("processes seen: %zu of %ld forked (%.1f%%)\n", seen.size(),
+              forks, forks > 0 ? 100.0 * seen.size() / forks : 0);
+  std::printf("cpu captured: %.1f%% of %ld active jiffies\n",
+              active > 0 ? 100.0 * captured_ticks / active : 0, active);
+  return exceptions || misattributed ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "../include/headless_display.h"
+#include "../include/linux_system.h"
+#include "../include/ncurses_display.h"
+
+using std::filesystem::path;
+
+/*
+Time to first paint against the full process scan.
+
+The first frame shows the system panel, then the processes found within one
+scan slice. The synthetic /proc copies the fixture process under as many pids
+as requested; run the benchmarks from the repository root so the fixtures are
+found.
+*/
+
+namespace {
+
+const path kTestDataDirPath =
+    std::filesystem::current_path() / "test" / "testdata";
+const int kFirstPid = 1000;
+
+// Discards whatever is written, standing in for the terminal.
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+};
+
+// Synthetic /proc directories, removed when the benchmarks end.
+class ProcDirs {
+ public:
+  ~ProcDirs() {
+    std::error_code error;
+    std::filesystem::remove_all(Root(), error);
+  }
+  const path& Get(int numProcesses) {
+    const auto found = this->dirs_.find(numProcesses);
+    if (found != this->dirs_.end()) {
+      return found->second;
+    }
+    const path dir = Root() / std::to_string(numProcesses);
+    std::filesystem::create_directories(dir);
+    // The fixture process, re-parented to init so the copies are siblings.
+    std::string stat;
+    std::getline(std::ifstream(kTestDataDirPath / "103" / "stat"), stat);
+    stat = stat.substr(stat.find(' '));
+    const std::size_t ppid = stat.find(") ") + 4;
+    stat.replace(ppid, stat.find(' ', ppid) - ppid, "1");
+    for (const char* file : {"recent_stat", "recent_meminfo", "recent_uptime",
+                             "fake_os_release", "fake_proc_version",
+                             "fake_etc_passwd"}) {
+      std::filesystem::copy_file(kTestDataDirPath / file, dir / file);
+    }
+    for (int pid = kFirstPid; pid < kFirstPid + numProcesses; ++pid) {
+      const path pidDir = dir / std::to_string(pid);
+      std::filesystem::create_directory(pidDir);
+      for (const char* file : {"status", "cmdline"}) {
+        std::filesystem::copy_file(kTestDataDirPath / "103" / file,
+                                   pidDir / file);
+      }
+      std::ofstream(pidDir / "stat") << pid << stat;
+    }
+    return this->dirs_[numProcesses] = dir;
+  }
+
+ private:
+  static path Root() {
+    return std::filesystem::temp_directory_path() /
+           ("monitor_bench_" + std::to_string(getpid()));
+  }
+  std::map<int, path> dirs_;
+};
+
+ProcDirs proc_dirs;
+
+LinuxSystem SyntheticSystem(const path& dir) {
+  return LinuxSystem(dir.string(), dir.string(), (dir / "recent_meminfo").string(),
+                     (dir / "fake_os_release").string(), dir.string(),
+                     (dir / "recent_stat").string(),
+                     (dir / "recent_uptime").string(),
+                     (dir / "fake_proc_version").string(),
+                     (dir / "fake_etc_passwd").string());
+}
+
+// The work before the first frame: the system panel, then one scan slice.
+void FirstPaint(System& system, std::ostream& out) {
+  HeadlessDisplay::DisplaySystem(system, out);
+  benchmark::DoNotOptimize(system.Processes(std::chrono::steady_clock::now() +
+                                            NCursesDisplay::kScanSlice));
+}
+
+void BM_SyntheticFirstPaint(benchmark::State& state) {
+  const path& dir = proc_dirs.Get(state.range(0));
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      LinuxSystem system = SyntheticSystem(dir);
+      state.ResumeTiming();
+      FirstPaint(system, out);
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_SyntheticFirstPaint)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_SyntheticFullScan(benchmark::State& state) {
+  const path& dir = proc_dirs.Get(state.range(0));
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      LinuxSystem system = SyntheticSystem(dir);
+      state.ResumeTiming();
+      HeadlessDisplay::DisplaySystem(system, out);
+      benchmark::DoNotOptimize(system.Processes());
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_SyntheticFullScan)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ProcFirstPaint(benchmark::State& state) {
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      LinuxSystem system;
+      state.ResumeTiming();
+      FirstPaint(system, out);
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ProcFirstPaint)->Unit(benchmark::kMillisecond);
+
+void BM_ProcFullScan(benchmark::State& state) {
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      LinuxSystem system;
+      state.ResumeTiming();
+      HeadlessDisplay::DisplaySystem(system, out);
+      benchmark::DoNotOptimize(system.Processes());
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ProcFullScan)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../include/linux_parser.h"
+#include "../include/stat_splitter.h"
+
+using std::filesystem::path;
+
+/*
+Splitting /proc/<pid>/stat lines, by each version of `StatSplitter` and
+through the schema the collection parses them with. The lines are captured
+from /proc, and from the fixtures, when the benchmarks start.
+*/
+
+namespace {
+
+std::vector<std::string> CaptureLines() {
+  std::vector<std::string> lines;
+  for (const path& root :
+       {path(LinuxParser::kProcDirectory),
+        std::filesystem::current_path() / "test" / "testdata"}) {
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(root, error), end;
+         !error && it != end; it.increment(error)) {
+      std::string line;
+      if (std::getline(std::ifstream(it->path() / "stat"), line) &&
+          line.find(')') != std::string::npos) {
+        lines.push_back(line);
+      }
+    }
+  }
+  return lines;
+}
+
+const std::vector<std::string>& Lines() {
+  static const std::vector<std::string> lines = CaptureLines();
+  return lines;
+}
+
+void BM_StatSplit(benchmark::State& state, StatSplitter::Isa isa) {
+  if (!StatSplitter::Supported(isa)) {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+  const std::vector<std::string>& lines = Lines();
+  StatSplitter::Fields fields;
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& line : lines) {
+      StatSplitter::Split(isa, line, StatSplitter::kMaxFields, fields);
+      benchmark::DoNotOptimize(fields);
+      bytes += line.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK_CAPTURE(BM_StatSplit, Scalar, StatSplitter::Isa::kScalar);
+BENCHMARK_CAPTURE(BM_StatSplit, Sse2, StatSplitter::Isa::kSse2);
+BENCHMARK_CAPTURE(BM_StatSplit, Avx2, StatSplitter::Isa::kAvx2);
+
+// The fields a collection takes from each line, up to the start time.
+void BM_ProcessStatSchema(benchmark::State& state) {
+  const std::vector<std::string>& lines = Lines();
+  LinuxParser::ProcessStatSchema::Values values;
+  for (auto _ : state) {
+    for (const std::string& line : lines) {
+      LinuxParser::ProcessStatSchema::Extract(line, values);
+      benchmark::DoNotOptimize(values);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_ProcessStatSchema);
+
+}  // namespace
@@ -0,0 +1,51 @@
+#ifndef CGROUP_VIEW_H
+#define CGROUP_VIEW_H
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Usage of a single cgroup, as read from its own cgroupfs interface files.
+struct CgroupStats {
+  std::string path;
+  int num_processes{0};
+  // Share of the group's CPU capacity used since the previous update, where
+  // the capacity is the `cpu.max` quota or, for unlimited groups, every CPU.
+  float cpu_utilization{0};
+  // The `cpu.max` quota in CPUs, or 0 when the group is unlimited.
+  float cpu_limit{0};
+  long memory_bytes{0};
+};
+
+/*
+Aggregates resource usage per cgroup v2 group.
+Each process is mapped to its group once (the mapping is cached per pid) and
+every group's counters are then read a single time per update, rather than
+summing the per-process counters of its members.
+*/
+class CgroupView {
+ public:
+  CgroupView(std::filesystem::path procsDirPath,
+             std::filesystem::path cgroupRootPath, int numCpus);
+  std::vector<CgroupStats>& Update(const std::vector<int>& pids);
+  std::vector<CgroupStats>& Update(
+      const std::vector<int>& pids,
+      std::chrono::steady_clock::time_point now);
+  std::vector<CgroupStats>& Groups();
+
+ private:
+  struct Sample {
+    long usage_usec{0};
+    std::chrono::steady_clock::time_point sampled_at;
+  };
+  std::filesystem::path procs_dir_path_;
+  std::filesystem::path cgroup_root_path_;
+  int num_cpus_;
+  std::unordered_map<int, std::string> pid_cgroups_;
+  std::unordered_map<std::string, Sample> samples_;
+  std::vector<CgroupStats> groups_;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+A single threaded epoll loop.
+File descriptors are registered with a handler that receives the ready epoll
+events. Ticks come from a timerfd and signals from a signalfd, so the loop
+sleeps in `epoll_wait` until there is something to do and reacts to input
+within milliseconds.
+*/
+class EventLoop {
+ public:
+  using Handler = std::function<void(uint32_t events)>;
+
+  EventLoop();
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+  ~EventLoop();
+  void Add(int fd, uint32_t events, Handler handler);
+  void Remove(int fd);
+  // Calls `onTick` every `interval`, replacing any previous interval.
+  void SetTimer(std::chrono::milliseconds interval, std::function<void()> onTick);
+  std::chrono::milliseconds Interval() const;
+  // Runs `task` once the ready events have been handled, so that long work
+  // split into deferred slices does not hold up input.
+  void Defer(std::function<void()> task);
+  // Blocks the signals and delivers them to `onSignal` instead.
+  void HandleSignals(const std::vector<int>& signals,
+                     std::function<void(int)> onSignal);
+  // Dispatches the events that become ready within `timeout`.
+  int RunOnce(std::chrono::milliseconds timeout);
+  void Run();
+  void Stop();
+
+ private:
+  int epoll_fd_{-1};
+  int timer_fd_{-1};
+  int signal_fd_{-1};
+  bool running_{false};
+  std::chrono::milliseconds interval_{0};
+  std::function<void()> on_tick_;
+  std::function<void(int)> on_signal_;
+  std::deque<std::function<void()>> deferred_;
+  // Handlers are shared so that one may remove itself while it runs.
+  std::unordered_map<int, std::shared_ptr<Handler>> handlers_;
+};
+
+#endif
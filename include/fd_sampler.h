@@ -0,0 +1,74 @@
+#ifndef FD_SAMPLER_H
+#define FD_SAMPLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// The number of open file descriptors of a process, as last counted.
+struct FdCount {
+  using Clock = std::chrono::steady_clock;
+  // -1 when not counted yet, or when the fd directory cannot be read, e.g.
+  // for processes of other users.
+  long count{-1};
+  // When it was counted, the epoch of the clock if never.
+  Clock::time_point time{};
+  bool Known() const { return this->count >= 0; }
+};
+
+/*
+Counts the open file descriptors of processes on a background thread, which
+runs at SCHED_IDLE so that it only takes CPU time nobody else wants.
+Counting the entries of /proc/<pid>/fd takes milliseconds for processes with
+100k descriptors, so each tick only counts for `budget`. Processes not
+counted yet go first; the others take turns by pid, starting after the last
+one counted by the previous tick, so large processes are refreshed
+round-robin and the counts are cached meanwhile.
+Entries are counted with getdents64 into a reused buffer, without a readlink
+per descriptor, so sockets are not told apart from other files.
+*/
+class FdSampler {
+ public:
+  static constexpr std::chrono::milliseconds kDefaultBudget{20};
+  explicit FdSampler(std::string procsDirPath,
+                     std::chrono::milliseconds budget = kDefaultBudget);
+  ~FdSampler();
+  FdSampler(const FdSampler&) = delete;
+  FdSampler& operator=(const FdSampler&) = delete;
+  // Starts the background thread. Without it, `Step` counts on the caller's
+  // thread.
+  void Start();
+  // Hands over the processes to count, whose earlier counts are kept, and
+  // wakes the thread. Counts of other pids are dropped.
+  void Tick(const std::vector<int>& pids);
+  FdCount Get(int pid) const;
+  // Counts for one tick, until `deadline`.
+  void Step(FdCount::Clock::time_point deadline);
+  // The entries of a directory, without `.` and `..`, or -1 if it cannot be
+  // read.
+  static long Count(const char* dirPath, std::vector<char>& buffer);
+
+ private:
+  void Run();
+  void CountOne(int pid);
+  std::string procs_dir_path_;
+  std::chrono::milliseconds budget_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  bool ticked_{false};
+  bool stop_{false};
+  std::vector<int> pids_;
+  std::unordered_map<int, FdCount> counts_;
+  // Owned by the counting thread.
+  std::vector<int> ticked_pids_;
+  std::vector<char> buffer_;
+  int last_pid_{0};
+  std::thread thread_;
+};
+
+#endif
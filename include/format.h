@@ -2,9 +2,13 @@
 #define FORMAT_H
 
 #include <string>
+#include <vector>
 
 namespace Format {
 std::string ElapsedTime(long times);  // TODO: See src/format.cpp
-};                                    // namespace Format
+// One UTF-8 block character per value, from 0 up to `max`. NaN values, i.e.
+// no data, are blank.
+std::string Sparkline(const std::vector<float>& values, float max);
+};  // namespace Format
 
 #endif
\ No newline at end of file
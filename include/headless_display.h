@@ -0,0 +1,35 @@
+#ifndef HEADLESS_DISPLAY_H
+#define HEADLESS_DISPLAY_H
+
+#include <ostream>
+#include <vector>
+
+#include "io_monitor.h"
+#include "low_impact.h"
+#include "options.h"
+#include "pressure_monitor.h"
+#include "process_groups.h"
+#include "process.h"
+#include "system.h"
+
+// Plain text output for non-interactive use, e.g. logging to a file.
+namespace HeadlessDisplay {
+// Prints a frame every `Options::interval` until SIGINT or SIGTERM.
+void Display(System& system, PressureMonitor& pressure, IoMonitor& io,
+             const Options& options = Options(),
+             CollectionHandler onCollect = nullptr);
+void DisplaySystem(System& system, std::ostream& out);
+void DisplayPressure(std::vector<PressureStats>& pressure, std::ostream& out);
+// The paging rates, and a line per disk and per interface.
+void DisplayIo(const IoStats& io, std::ostream& out);
+void DisplayOverhead(const SelfMonitor::Overhead& overhead, std::ostream& out);
+// With `sched`, adds the scheduler columns of `SchedRates`, with `fds` the
+// open file descriptors, and with `blocked` the share of time in D state.
+void DisplayProcesses(std::vector<Process>& processes, std::ostream& out,
+                      int n, bool sched = false, bool fds = false,
+                      bool blocked = false);
+void DisplayGroups(std::vector<ProcessGroups::Row>& rows, std::ostream& out,
+                   GroupBy by);
+};  // namespace HeadlessDisplay
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+const std::chrono::seconds kHistoryWindow(600);
+const std::size_t kMaxHistoryBytes = 1 << 20;
+
+// Identifies a series of the history: a metric of the system or a process.
+struct SeriesKey {
+  enum class Metric : uint8_t { kCpu, kMemory };
+  // 0 for the system.
+  int pid{0};
+  // Tells a process apart from an earlier one with the same pid.
+  long start_time{0};
+  Metric metric{Metric::kCpu};
+  bool operator==(const SeriesKey& other) const;
+};
+
+struct SeriesKeyHash {
+  std::size_t operator()(const SeriesKey& key) const;
+};
+
+/*
+The recent values of the system and of processes, for sparklines.
+
+Each series is compressed the way Gorilla (Pelkonen et al., VLDB 2015) does
+it: times as deltas of the previous delta, and values XORed with the previous
+value, which leaves few meaningful bits when values repeat or change little.
+Points go into fixed size blocks that each start with a raw point, so blocks
+are decoded and dropped on their own. Times are kept in tenths of a second and
+values rounded to 8 significant bits, which is more than a sparkline shows. A
+series sampled every second then takes about 2 bits a point while it is flat
+and 10 to 12 while it changes, i.e. 15 to 90 bytes a minute.
+
+Blocks older than the window are dropped by `Retain`, and once the store holds
+`maxBytes` the oldest block of all makes room for a new one.
+*/
+class History {
+ public:
+  using Clock = std::chrono::steady_clock;
+  struct Point {
+    Clock::time_point time;
+    float value;
+  };
+  static constexpr std::size_t kBlockBytes = 64;
+
+  explicit History(std::chrono::seconds window = kHistoryWindow,
+                   std::size_t maxBytes = kMaxHistoryBytes);
+  // Points older than the last one of the series are ignored.
+  void Add(const SeriesKey& key, Clock::time_point time, float value);
+  // The points of a series, oldest first, with the rounded values.
+  std::vector<Point> Points(const SeriesKey& key) const;
+  // Splits the window ending at `end` into `width` equal spans, giving the
+  // largest value within each span, or NaN for spans without points.
+  std::vector<float> Resample(const SeriesKey& key, Clock::time_point end,
+                              std::size_t width) const;
+  // Drops the series of processes whose pid is not in `pids`, and the blocks
+  // that ended before the window.
+  void Retain(const std::unordered_set<int>& pids, Clock::time_point now);
+  // The memory held by the blocks.
+  std::size_t Bytes() const;
+  std::size_t NumSeries() const;
+
+ private:
+  struct Block {
+    std::array<uint8_t, kBlockBytes> bits{};
+    uint16_t num_bits{0};
+    // In tenths of a second.
+    uint32_t first_time{0};
+    uint32_t last_time{0};
+  };
+  struct Series {
+    std::deque<Block> blocks;
+    // The encoder state after the last point.
+    uint32_t last_time{0};
+    int64_t last_delta{0};
+    uint32_t last_value{0};
+    // The meaningful bits of the last XOR written with a new window, or
+    // `kNoWindow`.
+    uint8_t leading{kNoWindow};
+    uint8_t trailing{0};
+  };
+  static constexpr uint8_t kNoWindow = 0xff;
+  void EvictOldest(const Series& keep);
+  static std::vector<Point> Decode(const Block& block);
+  std::chrono::seconds window_;
+  std::size_t max_blocks_;
+  std::size_t num_blocks_{0};
+  std::unordered_map<SeriesKey, Series, SeriesKeyHash> series_;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef IO_MONITOR_H
+#define IO_MONITOR_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+
+// The rates of a block device since the previous update.
+struct DiskRates {
+  std::string name;
+  // Completed requests and bytes per second.
+  double reads{0};
+  double writes{0};
+  double read_bytes{0};
+  double write_bytes{0};
+  // The share of the interval with requests in flight, from 0 to 1.
+  double utilization{0};
+  // The average time a request took, queueing included, in milliseconds.
+  double await_ms{0};
+};
+
+// The rates of a network interface since the previous update, per second.
+struct NetRates {
+  std::string name;
+  double rx_bytes{0};
+  double tx_bytes{0};
+  double rx_packets{0};
+  double tx_packets{0};
+  double rx_drops{0};
+  double tx_drops{0};
+};
+
+// Paging rates since the previous update, in pages per second.
+struct VmRates {
+  double faults{0};
+  double major_faults{0};
+  double swap_in{0};
+  double swap_out{0};
+  // Pages scanned and reclaimed by kswapd and by direct reclaim.
+  double scanned{0};
+  double stolen{0};
+};
+
+struct IoStats {
+  // Devices that have done no I/O since boot are left out.
+  std::vector<DiskRates> disks;
+  std::vector<NetRates> interfaces;
+  VmRates vm;
+};
+
+/*
+Reports interval rates of the block devices (/proc/diskstats), the network
+interfaces (/proc/net/dev) and the paging activity (/proc/vmstat).
+Each file is opened once, read with pread from the start into a buffer that
+is kept, and parsed in a single pass into the counters of each device, which
+are kept from one update to the next and found again by name. Once the
+devices are known an update allocates nothing. A device shows no rates on its
+first update, or when it is active again after an idle one.
+*/
+class IoMonitor {
+ public:
+  explicit IoMonitor(std::string diskstatsPath = LinuxParser::kDiskstatsPath,
+                     std::string netDevPath = LinuxParser::kNetDevPath,
+                     std::string vmstatPath = LinuxParser::kVmstatPath);
+  IoMonitor(const IoMonitor&) = delete;
+  IoMonitor& operator=(const IoMonitor&) = delete;
+  ~IoMonitor();
+  // The rates since the previous update, all 0 on the first one. The
+  // devices of a file that cannot be read are left out, and updates within
+  // `kMinSampleInterval` return the previous rates.
+  const IoStats& Update();
+  const IoStats& Update(std::chrono::steady_clock::time_point now);
+
+ private:
+  struct File {
+    std::string path;
+    int fd{-1};
+  };
+  // Cumulative counters, in the units of the files.
+  struct DiskCounters {
+    unsigned long long reads{0};
+    unsigned long long sectors_read{0};
+    unsigned long long read_ms{0};
+    unsigned long long writes{0};
+    unsigned long long sectors_written{0};
+    unsigned long long write_ms{0};
+    unsigned long long io_ms{0};
+  };
+  struct NetCounters {
+    unsigned long long rx_bytes{0};
+    unsigned long long rx_packets{0};
+    unsigned long long rx_drops{0};
+    unsigned long long tx_bytes{0};
+    unsigned long long tx_packets{0};
+    unsigned long long tx_drops{0};
+  };
+  enum VmCounter {
+    kFaults,
+    kMajorFaults,
+    kSwapIn,
+    kSwapOut,
+    kScanned,
+    kStolen,
+    kNumVmCounters
+  };
+  using VmCounters = std::array<unsigned long long, kNumVmCounters>;
+  bool Read(File& file);
+  void ParseDisks(double seconds);
+  void ParseInterfaces(double seconds);
+  void ParseVm(double seconds);
+  File diskstats_;
+  File net_dev_;
+  File vmstat_;
+  // The contents of the file read last, `length_` bytes of it.
+  std::vector<char> buffer_;
+  std::size_t length_{0};
+  bool updated_{false};
+  std::chrono::steady_clock::time_point last_update_;
+  IoStats stats_;
+  // Parallel to the devices of `stats_`, with whether they have a previous
+  // value.
+  std::vector<DiskCounters> disk_counters_;
+  std::vector<bool> disk_known_;
+  std::vector<NetCounters> net_counters_;
+  std::vector<bool> net_known_;
+  VmCounters vm_counters_{};
+  bool vm_known_{false};
+};
+
+#endif
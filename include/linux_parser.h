@@ -1,12 +1,20 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <dirent.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
+#include "proc_schema.h"
+
 namespace LinuxParser {
 // Paths
 const std::string kProcDirectory{"/proc/"};
@@ -19,35 +27,121 @@ const std::string kMeminfoFilename{"/meminfo"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
+const std::string kCgroupRootPath{"/sys/fs/cgroup"};
+const std::string kPressureDirPath{"/proc/pressure"};
+const std::string kDiskstatsPath{"/proc/diskstats"};
+const std::string kNetDevPath{"/proc/net/dev"};
+const std::string kVmstatPath{"/proc/vmstat"};
 
-const std::string kTotalProcsKey{"processes"};
-const std::string kNumRunningProcsKey{"procs_running"};
-const std::string kMemTotalKey{"MemTotal:"};
-const std::string kMemFreeKey{"MemFree:"};
-const std::string kUidKey{"Uid:"};
-const std::string kMemoryUtilizationKey{"VmSize:"};
+constexpr std::string_view kTotalProcsKey{"processes"};
+constexpr std::string_view kNumRunningProcsKey{"procs_running"};
+constexpr std::string_view kNumBlockedProcsKey{"procs_blocked"};
+constexpr std::string_view kMemTotalKey{"MemTotal:"};
+constexpr std::string_view kMemFreeKey{"MemFree:"};
+constexpr std::string_view kUidKey{"Uid:"};
+constexpr std::string_view kVoluntarySwitchesKey{"voluntary_ctxt_switches:"};
+constexpr std::string_view kInvoluntarySwitchesKey{
+    "nonvoluntary_ctxt_switches:"};
+constexpr std::string_view kMemoryUtilizationKey{"VmSize:"};
+constexpr std::string_view kCgroupUsageUsecKey{"usage_usec"};
+const std::string kCgroupUnlimitedValue{"max"};
+const std::string kPressureSomeKey{"some"};
+const std::string kPressureFullKey{"full"};
 
 const std::filesystem::path kCmdlineFilePath("cmdline");
 const std::filesystem::path kUidFilePath("status");
 const std::filesystem::path kMemoryUtilizationFilePath("status");
 const std::filesystem::path kProcStatFilePath("stat");
+const std::filesystem::path kSchedStatFilePath("schedstat");
+const std::filesystem::path kStatusFilePath("status");
+const std::filesystem::path kCgroupFilePath("cgroup");
+const std::filesystem::path kBootIdFilePath("sys/kernel/random/boot_id");
+const std::filesystem::path kLoadavgFilePath("loadavg");
+const std::filesystem::path kCgroupCpuStatFilePath("cpu.stat");
+const std::filesystem::path kCgroupCpuMaxFilePath("cpu.max");
+const std::filesystem::path kCgroupMemoryCurrentFilePath("memory.current");
 
+const int kStateStatIndex = 2;
+const int kPpidStatIndex = 3;
 const int kUtimeStatIndex = 13;
 const int kStimeStatIndex = 14;
 const int kCutimeStatIndex = 15;
 const int kCstimeStatIndex = 16;
+const int kNumThreadsStatIndex = 19;
 const int kStarttimeStatIndex = 21;
+const int kVsizeStatIndex = 22;
+
+// Schemas
+// The /proc/<pid>/stat fields a `Process` needs.
+using ProcessStatSchema =
+    ProcSchema::Stat<kStateStatIndex, kPpidStatIndex, kUtimeStatIndex,
+                     kStimeStatIndex, kCutimeStatIndex, kCstimeStatIndex,
+                     kNumThreadsStatIndex, kStarttimeStatIndex,
+                     kVsizeStatIndex>;
+// /proc/<pid>/schedstat: the time on a CPU and waiting on a run queue, in
+// nanoseconds, and the number of timeslices run.
+using SchedStatSchema = ProcSchema::Positional<0, 1, 2>;
+struct MeminfoKeys {
+  static constexpr std::array<std::string_view, 2> kKeys{kMemTotalKey,
+                                                         kMemFreeKey};
+};
+struct StatProcessesKeys {
+  static constexpr std::array<std::string_view, 3> kKeys{
+      kTotalProcsKey, kNumRunningProcsKey, kNumBlockedProcsKey};
+};
+struct StatusUidKeys {
+  static constexpr std::array<std::string_view, 1> kKeys{kUidKey};
+};
+struct StatusSwitchKeys {
+  static constexpr std::array<std::string_view, 2> kKeys{
+      kVoluntarySwitchesKey, kInvoluntarySwitchesKey};
+};
+struct StatusVmSizeKeys {
+  static constexpr std::array<std::string_view, 1> kKeys{
+      kMemoryUtilizationKey};
+};
+struct CgroupCpuStatKeys {
+  static constexpr std::array<std::string_view, 1> kKeys{
+      kCgroupUsageUsecKey};
+};
 
 // System
 float MemoryUtilization(const std::filesystem::path &filePath);
 long UpTime(const std::filesystem::path &filePath);
 std::vector<int> Pids(const std::string &dirPath);
+// Replaces `pids` with the pids in `dirPath`, in ascending order, without
+// allocating once `pids` has grown to the number of processes.
+void Pids(const std::string &dirPath, std::vector<int> &pids);
+// Calls `onEntry` with every `dirent64` of the directory open at `fd`, read
+// with getdents64 into `buffer`, where opendir would allocate a buffer and a
+// directory_iterator an entry per name. Returns false on a read error.
+template <typename OnEntry>
+bool ForEachEntry(int fd, char *buffer, std::size_t size, OnEntry &&onEntry) {
+  ssize_t read;
+  while ((read = getdents64(fd, buffer, size)) > 0) {
+    for (ssize_t offset = 0; offset < read;) {
+      const auto *entry = reinterpret_cast<const dirent64 *>(buffer + offset);
+      offset += entry->d_reclen;
+      onEntry(*entry);
+    }
+  }
+  return read == 0;
+}
 int TotalProcesses(const std::filesystem::path &filePath);
 int RunningProcesses(const std::filesystem::path &filePath);
+int BlockedProcesses(const std::filesystem::path &filePath);
+// The pid most recently handed out, from /proc/loadavg, or -1 if it cannot
+// be read.
+long LastPid(const std::filesystem::path &filePath);
 std::string OperatingSystem(const std::filesystem::path &filePath);
 std::string Kernel(const std::filesystem::path &filePath);
 std::unordered_map<std::string, std::string> UserIdMap(const std::filesystem::path &filePath);
 std::vector<std::string> Stats(const std::filesystem::path &filePath);
+bool ReadFile(const std::filesystem::path &filePath, std::string &contents);
+// As above, without converting the name to a path, which allocates.
+bool ReadFile(const char *filePath, std::string &contents);
+std::string BootId(const std::filesystem::path &procsDirPath);
+double BootTime();
 
 // CPU
 enum CPUStates {
@@ -67,13 +161,37 @@ long Jiffies(const std::filesystem::path &filePath);
 long ActiveJiffies(const std::filesystem::path &filePath);
 long ActiveJiffies(int pid);
 long IdleJiffies(const std::filesystem::path &filePath);
+// Both of the above from a single read. Returns whether the file was read.
+bool CpuJiffies(const std::filesystem::path &filePath, long &active,
+                long &idle);
 
 // Processes
+bool ProcessStats(const std::filesystem::path &filePath,
+                  ProcessStatSchema::Values &values);
+// The command name and start time from a stat file, which change when the
+// process execs or its pid is reused.
+bool ProcessIdentity(const std::filesystem::path &filePath, std::string &comm,
+                     long &startTime);
+bool SchedStats(const std::filesystem::path &filePath,
+                SchedStatSchema::Values &values);
+// The voluntary and involuntary context switches from a status file.
+bool ContextSwitches(const std::filesystem::path &filePath,
+                     ProcSchema::Keyed<StatusSwitchKeys>::Values &values);
 std::string Command(const std::filesystem::path &filePathRoot, int pid);
 std::string Ram(const std::filesystem::path &filePathRoot, int pid);
 std::string Uid(const std::filesystem::path &filePathRoot, int pid);
 std::string User(int pid);
 long int UpTime(int pid);
+
+// Control groups (v2 unified hierarchy)
+std::string Cgroup(const std::filesystem::path &filePathRoot, int pid);
+long CgroupCpuUsage(const std::filesystem::path &cgroupPath);
+long CgroupMemoryCurrent(const std::filesystem::path &cgroupPath);
+std::pair<long, long> CgroupCpuMax(const std::filesystem::path &cgroupPath);
+
+// Pressure stall information
+std::vector<double> Pressure(const std::filesystem::path &filePath,
+                             const std::string &key);
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
@@ -2,18 +2,29 @@
 #define MONITOR_LINUX_SYSTEM_H
 
 #include <chrono>
+#include <filesystem>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "cgroup_view.h"
+#include "fd_sampler.h"
 #include "linux_parser.h"
 #include "process.h"
+#include "process_filter.h"
+#include "process_groups.h"
+#include "process_tree.h"
+#include "process_watch.h"
+#include "state_sampler.h"
 #include "system.h"
+#include "warm_state.h"
 
 using std::string;
 
 const string kDefaultProcessorStatsFilePath =
     LinuxParser::kProcDirectory + LinuxParser::kStatFilename;
 
-class LinuxSystem : public System {
+class LinuxSystem final : public System {
  public:
   // The default constructor uses the standard location for the Linux system
   // files, using the constants defined in the linux_parser.h header file.
@@ -24,30 +35,127 @@ class LinuxSystem : public System {
               string memInfoFilePath, string osVersionFilePath,
               string statusFilePath, string statsFilePath,
               string uptimeFilePath, string kernelInfoFilePath,
-              string etcPasswdFilePath);
+              string etcPasswdFilePath,
+              string cgroupRootPath = LinuxParser::kCgroupRootPath);
   ~LinuxSystem();
   Processor& Cpu() override;
   std::vector<Process>& Processes() override;
+  std::vector<Process>& Processes(
+      std::chrono::steady_clock::time_point deadline) override;
+  ScanProgress Progress() override;
   float MemoryUtilization() override;
   long UpTime() override;
   int TotalProcesses() override;
   int RunningProcesses() override;
-  std::string Kernel() override;
-  std::string OperatingSystem() override;
+  int BlockedProcesses() override;
+  const std::string& Kernel() override;
+  const std::string& OperatingSystem() override;
+  std::vector<CgroupStats>& Cgroups() override;
+  ProcessTree& Tree() override;
+  ProcessGroups& Groups() override;
   void SortDescending(vector<Process>&);
+  // Restricts `Processes` to those accepted by the filter.
+  void SetFilter(ProcessFilter filter) override;
+  // Lists only the targeted processes and their descendants, without
+  // enumerating /proc. An empty target watches every process again.
+  void SetWatch(WatchTarget target);
+  // How long the values read from a process are reused, `kUpdateInterval` by
+  // default. Refreshing faster than that needs a shorter interval.
+  void SetSampleInterval(std::chrono::milliseconds interval);
+  std::chrono::milliseconds SampleInterval() const {
+    return this->sample_interval_;
+  }
+  // The sampler state to save for a warm start of a later run.
+  WarmState Capture();
+  // Continues from the state saved by an earlier run during the same boot,
+  // so that the first `Processes` call measures real rates and reuses the
+  // saved users and commands. Returns false, doing nothing, for a state from
+  // another boot or one older than `WarmStart::kMaxAgeSeconds`.
+  bool Restore(const WarmState& state);
+  // The open descriptors of a process. The first call starts counting them
+  // for every listed process, on a background thread.
+  FdCount Fds(int pid);
+  // The run states of a process over the last refresh. The first call
+  // starts sampling them on a background thread, for the processes that
+  // were blocked or active at their last sample.
+  RunStates States(int pid);
 
  private:
+  struct Rejection {
+    std::string comm;
+    long start_time;
+  };
+  // How many pids are added between checks of the deadline.
+  static constexpr std::size_t kScanDeadlineStride = 16;
+  // /proc is walked at least this often, even when no fork was seen.
+  static constexpr std::chrono::seconds kFullScanInterval{10};
+  void StartScan();
+  bool Quiet();
+  void List(Process& proc);
+  bool StillRejected(int pid, const Rejection& rejection);
+  void TickFdSampler();
+  void TickStateSampler();
+  // Forgets the listed processes, for a new filter or watch.
+  void Reset();
+  std::unordered_map<std::string, std::string>& UserIdMap();
   string procs_dir_path_;
   string cpu_info_file_path_;
   string status_file_path_;
-  string mem_info_file_path_;
-  string stats_file_path_;
-  string uptime_file_path_;
+  string cgroup_root_path_;
+  // The files read on every refresh are kept as paths, which would otherwise
+  // be converted, and allocated, on every read.
+  std::filesystem::path procs_dir_;
+  std::filesystem::path mem_info_file_path_;
+  std::filesystem::path stats_file_path_;
+  std::filesystem::path uptime_file_path_;
+  std::filesystem::path loadavg_file_path_;
   string os_version_file_path_;
   string kernel_info_file_path_;
   std::vector<Process> processes_;
+  // The pids listed by the current scan, reused by every scan.
+  std::vector<int> pids_;
+  // The fork counter and last pid at the last walk of /proc, -1 to walk it
+  // on the next scan.
+  long forks_{-1};
+  long last_pid_{-1};
+  std::chrono::steady_clock::time_point last_full_scan_;
+  // Listed pids whose files could not be read, dropped from `pids_` by a scan
+  // that does not walk /proc.
+  std::vector<int> exited_pids_;
+  // Processes that are not listed because they are rejected by a stat
+  // predicate of the filter, or not identified yet.
+  std::vector<Process> hidden_;
+  // Pids rejected by a pid predicate.
+  std::unordered_set<int> rejected_pids_;
+  // Processes rejected by a user or command predicate, by pid. A child still
+  // shows the command of its parent until it execs, and pids are reused, so
+  // the rejection only holds while the command name and start time match.
+  std::unordered_map<int, Rejection> rejected_;
+  ProcessFilter filter_;
+  ProcessWatch watch_;
+  std::chrono::milliseconds sample_interval_{kUpdateInterval};
+  CgroupView cgroup_view_;
+  string passwd_file_path_;
+  // Read when first needed, unless restored from a warm start.
   std::unordered_map<std::string, std::string> uid_map_;
-  std::unordered_map<std::string, Process&> proc_map_;
+  bool uid_map_loaded_{false};
+  // Saved processes by pid, consumed by the first `Processes` call.
+  std::unordered_map<int, WarmProcess> warm_processes_;
+  std::unordered_set<int> known_pids_;
+  // The new pids of the collection in progress, and how many are added.
+  std::vector<int> pending_pids_;
+  std::size_t num_pending_added_{0};
+  ScanProgress progress_;
+  ProcessTree tree_;
+  ProcessGroups groups_;
+  // Started by the first `Fds` call, and handed the listed pids after every
+  // collection.
+  std::unique_ptr<FdSampler> fd_sampler_;
+  std::vector<int> fd_pids_;
+  // Started by the first `States` call, and handed the candidates after
+  // every collection.
+  std::unique_ptr<StateSampler> state_sampler_;
+  std::vector<int> state_pids_;
   long uptime_{0};
   std::chrono::time_point<std::chrono::system_clock> uptime_last_updated_;
 };
@@ -0,0 +1,43 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "process.h"
+#include "system.h"
+
+/*
+Serves the monitor's numbers in the OpenMetrics text format on a loopback
+port, for a local Prometheus agent to scrape.
+The response is rendered once per collection by `Publish`; scrapes only copy
+the cached response to the socket, so they never trigger a collection however
+many there are.
+*/
+class MetricsServer {
+ public:
+  // Listens on 127.0.0.1:port, where port 0 picks a free port.
+  MetricsServer(int port);
+  ~MetricsServer();
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+  int Port() const;
+  void Publish(const std::string& body);
+  static std::string Render(System& system, float cpuUtilization,
+                            std::vector<Process>& processes, int k);
+
+ private:
+  void Serve();
+  void Respond(int client);
+  int listen_fd_{-1};
+  int stop_fd_{-1};
+  int port_{0};
+  std::mutex mutex_;
+  std::shared_ptr<const std::string> response_;
+  std::thread thread_;
+};
+
+#endif
@@ -3,14 +3,70 @@
 
 #include <curses.h>
 
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "cgroup_view.h"
+#include "history.h"
+#include "io_monitor.h"
+#include "low_impact.h"
+#include "options.h"
+#include "pressure_monitor.h"
 #include "process.h"
+#include "process_sort.h"
+#include "process_groups.h"
+#include "process_tree.h"
 #include "system.h"
 
 namespace NCursesDisplay {
-void Display(System& system, int n = 10);
-void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
-std::string ProgressBar(float percent);
+const std::chrono::milliseconds kMinRefreshInterval(125);
+const std::chrono::milliseconds kMaxRefreshInterval(8000);
+// How long one slice of the first process scan may take before drawing.
+const std::chrono::milliseconds kScanSlice(50);
+// Columns of the history sparklines of a process row, and the most of the
+// system panel.
+const int kRowSparklineWidth = 12;
+const int kSystemSparklineWidth = 40;
+// The most disks, and interfaces, listed by `--io`.
+const int kIoDeviceRows = 4;
+
+// Runs the interactive interface until `q`, SIGINT or SIGTERM.
+void Display(System& system, PressureMonitor& pressure, IoMonitor& io,
+             const Options& options = Options(),
+             CollectionHandler onCollect = nullptr);
+// With a `history`, follows the CPU and memory bars with their sparklines.
+void DisplaySystem(System& system, WINDOW* window,
+                   const History* history = nullptr);
+// The cost of the monitor itself, on one row.
+void DisplayOverhead(const SelfMonitor::Overhead& overhead, WINDOW* window,
+                     int row);
+void DisplayPressure(std::vector<PressureStats>& pressure,
+                     PressureMonitor& monitor, WINDOW* window, int row);
+// The paging rates, then up to `kIoDeviceRows` disks and interfaces each, on
+// at most `rows` rows.
+void DisplayIo(const IoStats& io, WINDOW* window, int row, int rows);
+// With `sched`, adds the scheduler columns of `SchedRates`, with `fds` the
+// open file descriptors, with `blocked` the share of time in D state, and
+// with a `history`, CPU and memory sparklines when the window is wide enough.
+void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n,
+                      bool sched = false, bool fds = false,
+                      bool blocked = false, const History* history = nullptr);
+// Records the system, and the first `n` processes, in `history`.
+void Record(System& system, std::vector<Process>* processes, int n,
+            History& history);
+// Highlights the row of the `selected` pid.
+void DisplayTree(std::vector<ProcessTree::Row>& rows, WINDOW* window,
+                 int selected = -1);
+void DisplayCgroups(std::vector<CgroupStats>& cgroups, WINDOW* window, int n);
+void DisplayGroups(std::vector<ProcessGroups::Row>& rows, WINDOW* window,
+                   GroupBy by);
+// Draws the bar of a share from 0 to 1 at the cursor.
+void ProgressBar(WINDOW* window, float percent);
+std::string StatusLine(bool paused, SortKey sortKey,
+                       std::chrono::milliseconds interval,
+                       ScanProgress progress = ScanProgress(),
+                       GroupBy groupBy = GroupBy::kProcess);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "process_groups.h"
+#include "process_watch.h"
+#include "snapshot.h"
+
+// The CPU budget of --low-impact, in percent of one CPU.
+const int kLowImpactCpuBudget = 5;
+const std::chrono::milliseconds kDefaultRefreshInterval(1000);
+// The bounds of --interval. 10ms samples a watched service at 100 Hz.
+const std::chrono::milliseconds kFastestRefreshInterval(10);
+const std::chrono::milliseconds kSlowestRefreshInterval(8000);
+
+// Runtime configuration, populated from the command line.
+struct Options {
+  // Number of rows shown in the process (or cgroup) panel.
+  int num_processes{10};
+  // Show per-cgroup usage instead of individual processes.
+  bool show_cgroups{false};
+  // Show processes as a tree with per-subtree totals.
+  bool show_tree{false};
+  // Show totals per user or per command instead of individual processes.
+  GroupBy group_by{GroupBy::kProcess};
+  // Show the run-queue latency, run-queue wait and context switch columns.
+  bool show_sched{false};
+  // Show the open file descriptors, counted in the background.
+  bool show_fds{false};
+  // Show the share of time each process spent in D state, sampled many times
+  // per refresh.
+  bool show_blocked{false};
+  // Show the disk, network and paging rates in the system panel.
+  bool show_io{false};
+  // Print plain text to stdout instead of running the ncurses interface.
+  bool headless{false};
+  // A `ProcessFilter` expression, empty to show every process.
+  std::string filter;
+  // The processes to watch instead of every process.
+  WatchTarget watch;
+  // How often the displays and the collector refresh.
+  std::chrono::milliseconds interval{kDefaultRefreshInterval};
+  // Run as a collector publishing snapshots to shared memory, without a
+  // display.
+  bool publish{false};
+  // Display the snapshots of a collector instead of reading /proc.
+  bool attach{false};
+  std::string snapshot_name{kDefaultSnapshotName};
+  // Serve OpenMetrics on this loopback port, or -1 to disable.
+  int metrics_port{-1};
+  // `PressureMonitor` trigger specifications, e.g. `memory:some:150:1000`.
+  std::vector<std::string> psi_triggers;
+  // Save the sampler state on exit and resume from it on the next start.
+  bool warm_start{false};
+  // The CPUs to run on, empty for any.
+  std::vector<int> cpus;
+  // Run only when a CPU is otherwise idle.
+  bool sched_idle{false};
+  // The nice level to run at, 0 to leave it as is.
+  int nice{0};
+  // Lock the memory of the monitor once it has started.
+  bool lock_memory{false};
+  // The CPU time the monitor may use, in percent of one CPU, or 0 for any.
+  int cpu_budget{0};
+};
+
+namespace CommandLine {
+Options Parse(const std::vector<std::string>& args);
+std::string Usage();
+};  // namespace CommandLine
+
+#endif
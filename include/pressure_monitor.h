@@ -0,0 +1,68 @@
+#ifndef PRESSURE_MONITOR_H
+#define PRESSURE_MONITOR_H
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+
+// One line (`some` or `full`) of a pressure stall information file.
+struct PressureLine {
+  // Share of time stalled over the last 10, 60 and 300 seconds, in percent.
+  double avg10{0};
+  double avg60{0};
+  double avg300{0};
+  long long total_us{0};
+  // Stall time accumulated since the previous update.
+  long long delta_us{0};
+};
+
+struct PressureStats {
+  std::string resource;
+  PressureLine some;
+  // Absent for the system wide CPU pressure on older kernels.
+  bool has_full{false};
+  PressureLine full;
+};
+
+/*
+Reads the pressure stall information of the cpu, memory and io resources and
+watches PSI triggers.
+A trigger such as `memory:some:150:1000` asks the kernel to signal a `some`
+memory stall of at least 150ms within any 1000ms window. `Wait` sleeps until
+either the timeout expires or a trigger fires, so spikes are noticed right
+away without sampling faster. Without PSI (e.g. kernels built without it) the
+monitor reports no resources and `Wait` is a plain sleep.
+*/
+class PressureMonitor {
+ public:
+  explicit PressureMonitor(
+      std::filesystem::path pressureDirPath = LinuxParser::kPressureDirPath);
+  PressureMonitor(const PressureMonitor&) = delete;
+  PressureMonitor& operator=(const PressureMonitor&) = delete;
+  ~PressureMonitor();
+  bool Available() const;
+  void AddTrigger(const std::string& spec);
+  std::size_t NumTriggers() const;
+  std::vector<PressureStats>& Update();
+  bool Wait(std::chrono::milliseconds timeout);
+  // For callers polling the trigger fds themselves: the fds to watch for
+  // POLLPRI, and `Handle` to report the events returned for one of them.
+  const std::vector<int>& TriggerFds() const;
+  bool Handle(int fd, short events);
+  // The number of times a trigger has fired.
+  long Events() const;
+
+  static inline const std::vector<std::string> kResources{"cpu", "memory",
+                                                          "io"};
+
+ private:
+  std::filesystem::path pressure_dir_path_;
+  std::vector<int> trigger_fds_;
+  std::vector<PressureStats> stats_;
+  long events_{0};
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef PROC_SCHEMA_H
+#define PROC_SCHEMA_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "stat_splitter.h"
+
+/*
+Compile time descriptions of the fields a consumer needs from a proc file.
+Each schema generates a single pass extractor that parses only the requested
+fields, as integers, and stops after the last one:
+
+  - `Positional<1, 5>` takes whitespace separated fields by index, e.g. from
+    /proc/<pid>/statm.
+  - `Stat<3, 13>` takes fields of /proc/<pid>/stat by their proc(5) index
+    minus one. Everything after the command name is located from the last
+    `)`, so names containing spaces or parentheses cannot shift the fields,
+    and split with the vectorized `StatSplitter`.
+  - `Keyed<Keys>` takes the value following each of `Keys::kKeys` at the start
+    of a line, e.g. from /proc/meminfo. Keys are looked up in a perfect hash
+    table built at compile time, so each line costs one hash and at most one
+    comparison.
+
+Single character fields that are not digits, such as the stat state, are
+stored as that character. Any other field that is not a number, or that does
+not fit a long, fails the extraction.
+*/
+namespace ProcSchema {
+namespace Detail {
+constexpr bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n';
+}
+
+template <std::size_t N>
+constexpr bool Ascending(const std::array<int, N>& indices) {
+  for (std::size_t i = 1; i < N; ++i) {
+    if (indices[i] <= indices[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether `token` holds a value, leaving `value` at 0 if not.
+inline bool ParseValue(std::string_view token, long& value) {
+  value = 0;
+  const auto result =
+      std::from_chars(token.data(), token.data() + token.size(), value);
+  if (result.ec == std::errc::invalid_argument && token.size() == 1) {
+    value = token[0];
+    return true;
+  }
+  if (result.ec != std::errc()) {
+    value = 0;
+    return false;
+  }
+  return true;
+}
+
+// Stores the fields at `indices[next...]` of `text`, whose first field has
+// the index `firstIndex`.
+template <std::size_t N>
+bool ExtractFields(std::string_view text, int firstIndex,
+                   const std::array<int, N>& indices, std::array<long, N>& values,
+                   std::size_t next) {
+  std::size_t position = 0;
+  for (int field = firstIndex; next < N; ++field) {
+    while (position < text.size() && IsSpace(text[position])) {
+      ++position;
+    }
+    if (position == text.size()) {
+      return false;
+    }
+    std::size_t end = position;
+    while (end < text.size() && !IsSpace(text[end])) {
+      ++end;
+    }
+    if (field == indices[next] &&
+        !ParseValue(text.substr(position, end - position), values[next++])) {
+      return false;
+    }
+    position = end;
+  }
+  return true;
+}
+
+// FNV-1a, salted so that a seed without collisions can be searched for.
+constexpr uint32_t Hash(std::string_view key, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (const char c : key) {
+    hash ^= uint8_t(c);
+    hash *= 16777619u;
+  }
+  // The low bits of FNV barely depend on the seed, mix in the high ones.
+  hash ^= hash >> 16;
+  hash *= 0x7feb352du;
+  hash ^= hash >> 15;
+  return hash;
+}
+
+// The position of `index` within `indices`, or `N` if it is not there.
+template <std::size_t N>
+constexpr std::size_t Find(const std::array<int, N>& indices, int index) {
+  for (std::size_t i = 0; i < N; ++i) {
+    if (indices[i] == index) {
+      return i;
+    }
+  }
+  return N;
+}
+
+constexpr std::size_t TableSize(std::size_t numKeys) {
+  std::size_t size = 1;
+  while (size < 2 * numKeys) {
+    size *= 2;
+  }
+  return size;
+}
+
+template <std::size_t TableSize, std::size_t N>
+constexpr bool Collides(const std::array<std::string_view, N>& keys,
+                        uint32_t seed) {
+  std::array<bool, TableSize> used{};
+  for (const std::string_view key : keys) {
+    const std::size_t slot = Hash(key, seed) & (TableSize - 1);
+    if (used[slot]) {
+      return true;
+    }
+    used[slot] = true;
+  }
+  return false;
+}
+
+// The first seed hashing every key to its own slot, or 0 with a collision
+// for every seed tried (e.g. for duplicated keys).
+template <std::size_t TableSize, std::size_t N>
+constexpr uint32_t FindSeed(const std::array<std::string_view, N>& keys) {
+  for (uint32_t seed = 1; seed < 4096; ++seed) {
+    if (!Collides<TableSize>(keys, seed)) {
+      return seed;
+    }
+  }
+  return 0;
+}
+
+// Maps each slot to the position of the key hashed to it, or `N` if none.
+template <std::size_t TableSize, std::size_t N>
+constexpr std::array<std::size_t, TableSize> BuildTable(
+    const std::array<std::string_view, N>& keys, uint32_t seed) {
+  std::array<std::size_t, TableSize> table{};
+  for (std::size_t& slot : table) {
+    slot = N;
+  }
+  for (std::size_t i = 0; i < N; ++i) {
+    table[Hash(keys[i], seed) & (TableSize - 1)] = i;
+  }
+  return table;
+}
+}  // namespace Detail
+
+template <int... Indices>
+struct Positional {
+  static constexpr std::size_t kSize = sizeof...(Indices);
+  static constexpr std::array<int, kSize> kIndices{Indices...};
+  static_assert(kSize > 0 && Detail::Ascending(kIndices) && kIndices[0] >= 0,
+                "indices must be ascending and non-negative");
+  using Values = std::array<long, kSize>;
+
+  // Where the field with this index is stored in `Values`.
+  static constexpr std::size_t Position(int index) {
+    return Detail::Find(kIndices, index);
+  }
+
+  // Returns whether every field was found.
+  static bool Extract(std::string_view text, Values& values) {
+    return Detail::ExtractFields(text, 0, kIndices, values, 0);
+  }
+};
+
+template <int... Indices>
+struct Stat {
+  static constexpr std::size_t kSize = sizeof...(Indices);
+  static constexpr std::array<int, kSize> kIndices{Indices...};
+  static_assert(kSize > 0 && Detail::Ascending(kIndices) && kIndices[0] >= 0,
+                "indices must be ascending and non-negative");
+  static_assert(kIndices[0] != 1 && (kSize < 2 || kIndices[1] != 1),
+                "the command name is not a numeric field");
+  using Values = std::array<long, kSize>;
+
+  // Where the field with this index is stored in `Values`.
+  static constexpr std::size_t Position(int index) {
+    return Detail::Find(kIndices, index);
+  }
+
+  // Returns whether every field was found.
+  static bool Extract(std::string_view text, Values& values) {
+    StatSplitter::Fields fields;
+    // The fields from the state, index 2, up to the last one requested.
+    if (!StatSplitter::Split(text, std::max(kIndices[kSize - 1] - 1, 0),
+                             fields)) {
+      return false;
+    }
+    std::size_t next = 0;
+    if constexpr (kIndices[0] == 0) {
+      if (!Detail::ParseValue(text.substr(0, text.find(' ')),
+                              values[next++])) {
+        return false;
+      }
+    }
+    for (; next < kSize; ++next) {
+      const std::size_t field = kIndices[next] - 2;
+      if (field >= fields.count) {
+        return false;
+      }
+      if (!Detail::ParseValue(fields.Field(text, field), values[next])) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// `Keys` provides `static constexpr std::array<std::string_view, N> kKeys`.
+template <typename Keys>
+struct Keyed {
+  static constexpr std::size_t kSize = Keys::kKeys.size();
+  static constexpr std::size_t kTableSize = Detail::TableSize(kSize);
+  static constexpr uint32_t kSeed =
+      Detail::FindSeed<kTableSize>(Keys::kKeys);
+  static_assert(kSeed != 0, "keys must be distinct");
+  static constexpr std::array<std::size_t, kTableSize> kTable =
+      Detail::BuildTable<kTableSize>(Keys::kKeys, kSeed);
+  using Values = std::array<long, kSize>;
+
+  // The position of `key` in `Keys::kKeys`, or `kSize` for other keys.
+  static constexpr std::size_t Index(std::string_view key) {
+    const std::size_t index =
+        kTable[Detail::Hash(key, kSeed) & (kTableSize - 1)];
+    return index < kSize && Keys::kKeys[index] == key ? index : kSize;
+  }
+
+  // Returns whether every key was found with a value. Values of missing keys,
+  // and values that are not numbers, are 0.
+  static bool Extract(std::string_view text, Values& values) {
+    values.fill(0);
+    std::array<bool, kSize> seen{};
+    std::size_t found = 0;
+    std::size_t position = 0;
+    while (position < text.size() && found < kSize) {
+      std::size_t lineEnd = text.find('\n', position);
+      if (lineEnd == std::string_view::npos) {
+        lineEnd = text.size();
+      }
+      const std::string_view line = text.substr(position, lineEnd - position);
+      std::size_t keyEnd = 0;
+      while (keyEnd < line.size() && !Detail::IsSpace(line[keyEnd])) {
+        ++keyEnd;
+      }
+      const std::size_t index = Index(line.substr(0, keyEnd));
+      if (index < kSize && !seen[index]) {
+        seen[index] = true;
+        std::array<int, 1> first{1};
+        std::array<long, 1> value{0};
+        if (Detail::ExtractFields(line, 0, first, value, 0)) {
+          values[index] = value[0];
+          ++found;
+        }
+      }
+      position = lineEnd + 1;
+    }
+    return found == kSize;
+  }
+};
+}  // namespace ProcSchema
+
+#endif
@@ -3,47 +3,150 @@
 
 #include <unistd.h>
 
+#include <array>
 #include <chrono>
 #include <ctime>
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
+#include "fd_sampler.h"
+#include "state_sampler.h"
+#include "string_table.h"
 #include "system.h"
 
+// Processes read the uptime of the system that collects them. The class is
+// final, so the call is bound at compile time.
+class LinuxSystem;
+
 const std::chrono::duration<int, std::milli> kUpdateInterval(500);
 const float kCPUHertz = float(sysconf(_SC_CLK_TCK));
 
+// How often a collection samples a process. Most processes sleep, so only
+// those that used the CPU at their last sample are sampled every time
+// (`kUpdateInterval`), and the longer a process has been idle the less often
+// it is sampled.
+enum class SampleTier { kHot, kWarm, kCold };
+const std::chrono::seconds kWarmSampleInterval(2);
+const std::chrono::seconds kColdSampleInterval(10);
+// How long a process is idle before it drops to the cold tier.
+const std::chrono::seconds kColdAfter(30);
+
+// How a process fared with the scheduler over the interval between two
+// samples.
+struct SchedRates {
+  // The share of the interval spent on a CPU and waiting on a run queue.
+  double run{0};
+  double wait{0};
+  // The average wait on the run queue before each timeslice, in seconds.
+  double latency{0};
+  // Per second.
+  double timeslices{0};
+  double voluntary_switches{0};
+  double involuntary_switches{0};
+};
+
 /*
 Basic class for Process representation
 It contains relevant attributes as shown below
 */
 class Process {
  public:
-  Process(System* system, const int pid, const std::string user,
+  Process(LinuxSystem* system, const int pid, const std::string user,
           const std::string command, const std::filesystem::path pathRoot);
+  // Only reads the stat file. The user and command are read later, once the
+  // process is known to be of interest, and recorded with `Identify`.
+  Process(LinuxSystem* system, const int pid,
+          const std::filesystem::path pathRoot);
+  // A process with previously collected values, e.g. from a published
+  // snapshot. It never reads the proc filesystem.
+  Process(const int pid, const int ppid, const std::string user,
+          const std::string command, float cpuUtilization,
+          long virtualMemoryKb, long int upTime);
+  void Identify(std::string_view user, std::string_view command);
+  bool Identified();
   int Pid();
-  std::string User();
-  std::string Command();
+  int Ppid();
+  // Views into the global `StringTable`, valid while the process lives.
+  std::string_view User() const;
+  std::string_view Command() const;
+  // Equal handles mean equal strings, so these are cheap grouping keys.
+  StringTable::Handle UserHandle() const;
+  StringTable::Handle CommandHandle() const;
   float CpuUtilization();
   std::string Ram();
+  long VirtualMemoryKb();
   long int UpTime();
+  // The start time in clock ticks after boot, which tells a process apart
+  // from an earlier one with the same pid.
+  long StartTime();
+  // The CPU time in clock ticks and when it was read, in seconds after boot.
+  long TotalTicks();
+  double SampleTime();
+  // Measures the CPU utilization from counters sampled by an earlier run of
+  // the monitor, rather than since the process started. Returns false, doing
+  // nothing, when the counters belong to another process.
+  bool Restore(long startTime, long totalTicks, double sampleTime);
+  // Whether the last read of the stat file found the process exited, or its
+  // pid taken by a later process. Neither is told by the values read before.
+  bool Gone() const;
+  // The tier of the process by its last sample, and whether that tier is due
+  // for another sample. Reading a value samples the process regardless.
+  SampleTier Tier() const;
+  bool SampleDue() const;
+  // Whether the process was running or runnable at its last sample.
+  bool Running() const;
+  // The number of threads at its last sample.
+  int Threads() const;
+  // Whether it was in uninterruptible sleep, D, at its last sample.
+  bool Blocked() const;
+  // Read from the schedstat and status files on demand rather than by the
+  // collection, so only drawn processes, or those sorted by these rates, pay
+  // for the reads. Zero until the second sample.
+  SchedRates Sched();
+  // Counted in the background once first asked for, so the first calls, and
+  // those for processes of other users without privileges, are unknown.
+  FdCount Fds();
+  // Sampled in the background many times per refresh once first asked for,
+  // so empty until the refresh after the first call.
+  RunStates States();
   bool operator<(Process const& a) const;
   bool operator>(Process const& a) const;
   bool operator==(Process b) const;
 
  private:
-  System* system_;
+  LinuxSystem* system_;
   int pid_;
-  std::string user_;
-  std::string cmd_;
+  int ppid_{0};
+  InternedString user_;
+  InternedString cmd_;
+  bool identified_{false};
+  bool gone_{false};
   std::filesystem::path fs_path_root_;
   std::filesystem::path proc_stats_file_path_;
   long int uptime_{0};
+  long virtual_memory_kb_{0};
+  long start_time_{0};
+  long total_ticks_{0};
+  double sample_time_{-1};
+  // When the process last used the CPU, in seconds after boot, as seen by
+  // its samples.
+  double active_time_{-1};
+  char state_{0};
+  int threads_{1};
   float cpu_utilization_{0};
   float previous_cpu_utilization_{0};
   std::chrono::time_point<std::chrono::system_clock> stats_last_updated_;
+  // The scheduler counters, in the order of `SchedRates`, when they were
+  // last read.
+  std::array<long, 5> sched_counters_{};
+  double sched_sample_time_{-1};
+  SchedRates sched_rates_;
+  std::chrono::time_point<std::chrono::system_clock> sched_last_updated_;
   void UpdateStats();
+  // The system's sample interval, `kUpdateInterval` without a system.
+  std::chrono::milliseconds SampleInterval() const;
 };
 
 #endif
\ No newline at end of file
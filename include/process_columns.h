@@ -0,0 +1,170 @@
+#ifndef PROCESS_COLUMNS_H
+#define PROCESS_COLUMNS_H
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <ostream>
+
+#include "format.h"
+#include "process.h"
+
+/*
+Compile time composition of the columns of a process table. Each column is a
+type naming its header and width and printing its value for a process, and
+`Columns<...>` prints the header or a row of a fixed set of them:
+
+  using Table = Columns<Pid, User, Cpu, Command>;
+  Table::Header(out);
+  Table::Row(process, out);
+
+The set unrolls into straight-line calls on `Process`, with nothing looked up
+at run time, and columns left out of every set are not compiled in.
+*/
+namespace ProcessColumns {
+struct Pid {
+  static constexpr const char* kHeader = "PID";
+  static constexpr int kWidth = 7;
+  static void Print(Process& process, std::ostream& out) {
+    out << process.Pid();
+  }
+};
+
+struct User {
+  static constexpr const char* kHeader = "USER";
+  static constexpr int kWidth = 9;
+  static void Print(Process& process, std::ostream& out) {
+    out << process.User();
+  }
+};
+
+struct Cpu {
+  static constexpr const char* kHeader = "CPU[%]";
+  static constexpr int kWidth = 8;
+  static void Print(Process& process, std::ostream& out) {
+    out << std::fixed << std::setprecision(1)
+        << process.CpuUtilization() * 100;
+  }
+};
+
+struct Ram {
+  static constexpr const char* kHeader = "RAM[MB]";
+  static constexpr int kWidth = 9;
+  static void Print(Process& process, std::ostream& out) {
+    out << process.Ram();
+  }
+};
+
+struct Time {
+  static constexpr const char* kHeader = "TIME+";
+  static constexpr int kWidth = 10;
+  static void Print(Process& process, std::ostream& out) {
+    out << Format::ElapsedTime(process.UpTime());
+  }
+};
+
+// The scheduler columns of `SchedRates`. The rates are read once per
+// interval, so the columns of a row share a read.
+struct Latency {
+  static constexpr const char* kHeader = "LAT[ms]";
+  static constexpr int kWidth = 9;
+  static void Print(Process& process, std::ostream& out) {
+    out << std::fixed << std::setprecision(2) << process.Sched().latency * 1000;
+  }
+};
+
+struct Wait {
+  static constexpr const char* kHeader = "WAIT[%]";
+  static constexpr int kWidth = 9;
+  static void Print(Process& process, std::ostream& out) {
+    out << std::fixed << std::setprecision(1) << process.Sched().wait * 100;
+  }
+};
+
+struct Switches {
+  static constexpr const char* kHeader = "CSW/s";
+  static constexpr int kWidth = 8;
+  static void Print(Process& process, std::ostream& out) {
+    out << std::fixed << std::setprecision(0)
+        << process.Sched().voluntary_switches;
+  }
+};
+
+struct InvoluntarySwitches {
+  static constexpr const char* kHeader = "ICSW/s";
+  static constexpr int kWidth = 8;
+  static void Print(Process& process, std::ostream& out) {
+    out << std::fixed << std::setprecision(0)
+        << process.Sched().involuntary_switches;
+  }
+};
+
+// The open descriptors, and how long ago they were counted.
+struct Fds {
+  static constexpr const char* kHeader = "FDS";
+  static constexpr int kWidth = 8;
+  static void Print(Process& process, std::ostream& out) {
+    const FdCount fds = process.Fds();
+    if (fds.Known()) {
+      out << fds.count;
+    } else {
+      out << "-";
+    }
+  }
+};
+
+struct FdAge {
+  static constexpr const char* kHeader = "AGE";
+  static constexpr int kWidth = 6;
+  static void Print(Process& process, std::ostream& out) {
+    const FdCount fds = process.Fds();
+    if (!fds.Known()) {
+      out << "-";
+      return;
+    }
+    // One piece, so that it is padded to the width as a whole.
+    char age[24];
+    std::snprintf(age, sizeof(age), "%llds",
+                  static_cast<long long>(
+                      std::chrono::duration_cast<std::chrono::seconds>(
+                          FdCount::Clock::now() - fds.time)
+                          .count()));
+    out << age;
+  }
+};
+
+// The share of the run state samples of the last refresh in D state.
+struct Blocked {
+  static constexpr const char* kHeader = "BLK[%]";
+  static constexpr int kWidth = 8;
+  static void Print(Process& process, std::ostream& out) {
+    const float blocked = process.States().BlockedShare();
+    if (blocked < 0) {
+      out << "-";
+    } else {
+      out << std::fixed << std::setprecision(0) << blocked * 100;
+    }
+  }
+};
+
+// The last column, as wide as the command.
+struct Command {
+  static constexpr const char* kHeader = "COMMAND";
+  static constexpr int kWidth = 0;
+  static void Print(Process& process, std::ostream& out) {
+    out << process.Command();
+  }
+};
+
+template <typename... Column>
+struct Columns {
+  static void Header(std::ostream& out) {
+    ((out << std::setw(Column::kWidth) << Column::kHeader), ...);
+  }
+  static void Row(Process& process, std::ostream& out) {
+    ((out << std::setw(Column::kWidth), Column::Print(process, out)), ...);
+  }
+};
+}  // namespace ProcessColumns
+
+#endif
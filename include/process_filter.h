@@ -0,0 +1,53 @@
+#ifndef PROCESS_FILTER_H
+#define PROCESS_FILTER_H
+
+#include <regex>
+#include <string>
+#include <vector>
+
+class Process;
+
+/*
+A compiled filter expression such as `user=build cmd~"clang" cpu>5`.
+The expression is a list of predicates that must all hold. Each predicate is
+filed under the cheapest collection stage that provides its field, so that a
+process rejected by its pid or its stat line is never charged the status and
+cmdline reads.
+
+Fields: pid, ppid, cpu (%), mem (MB), time (s), user, cmd.
+Operators: = != < <= > >= on numbers, = != ~ (regex search) !~ on text.
+*/
+class ProcessFilter {
+ public:
+  // The collection stages, from cheapest to most expensive.
+  enum class Stage { kPid = 0, kStat, kStatus, kCmdline };
+
+  // The empty filter, which accepts every process.
+  ProcessFilter() = default;
+  static ProcessFilter Compile(const std::string& expression);
+  bool Empty() const;
+  bool HasPredicates(Stage stage) const;
+  bool AcceptsPid(int pid) const;
+  bool AcceptsStat(Process& process) const;
+  bool AcceptsUser(const std::string& user) const;
+  bool AcceptsCommand(const std::string& command) const;
+  const std::string& Expression() const;
+
+ private:
+  enum class Field { kPid, kPpid, kCpu, kMemory, kTime, kUser, kCommand };
+  enum class Op { kEq, kNe, kLt, kLe, kGt, kGe, kMatch, kNoMatch };
+  struct Predicate {
+    Field field;
+    Op op;
+    double number{0};
+    std::string text;
+    std::regex pattern;
+  };
+  static constexpr int kNumStages = 4;
+  static bool Compare(const Predicate& predicate, double value);
+  static bool Compare(const Predicate& predicate, const std::string& value);
+  std::string expression_;
+  std::vector<Predicate> predicates_[kNumStages];
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef PROCESS_GROUPS_H
+#define PROCESS_GROUPS_H
+
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "string_table.h"
+
+class Process;
+
+// What the process panel shows a row for.
+enum class GroupBy { kProcess, kUser, kCommand };
+
+/*
+CPU, memory and process count per user and per command basename, so that
+many small processes of one kind show up together.
+Like `ProcessTree`, the totals are maintained incrementally: each process
+remembers what it added to its groups, updating it adds only the change, and
+removing it takes its share out again. Both groupings are kept at once, so
+switching between them only picks the rows.
+*/
+class ProcessGroups {
+ public:
+  struct Row {
+    // A view into the global `StringTable`, valid while the group lives.
+    std::string_view name;
+    int num_processes;
+    float cpu_utilization;
+    long memory_kb;
+  };
+
+  // Adds a process, or applies the change of its values since it was last
+  // added. A process that changed its user or command moves to its new
+  // groups.
+  void Update(Process& process);
+  void Remove(int pid);
+  // The `n` groups using the most CPU. The rows are only valid until the
+  // groups change.
+  std::vector<Row>& Rows(GroupBy by, int n);
+  std::size_t Size(GroupBy by) const;
+  // The program name of a command line, e.g. "clang" for "/usr/bin/clang -c".
+  static std::string_view Basename(std::string_view command);
+  static const char* Name(GroupBy by);
+  static GroupBy Next(GroupBy by);
+
+ private:
+  struct Member {
+    InternedString user;
+    InternedString command;
+    float cpu_utilization{0};
+    long memory_kb{0};
+  };
+  struct Group {
+    InternedString name;
+    int num_processes{0};
+    float cpu_utilization{0};
+    long memory_kb{0};
+  };
+  using Groups = std::unordered_map<StringTable::Handle, Group>;
+  static void Add(Groups& groups, const InternedString& name,
+                  int num_processes, float cpu_delta, long memory_delta);
+  std::unordered_map<int, Member> members_;
+  Groups users_;
+  Groups commands_;
+  std::vector<Row> rows_;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef PROCESS_SORT_H
+#define PROCESS_SORT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+// The column the process list is ordered by. `kWait` is the share of time
+// waiting on a run queue, `kSwitches` the context switches per second and
+// `kFds` the open file descriptors, as last counted.
+enum class SortKey { kCpu, kMemory, kTime, kPid, kWait, kSwitches, kFds };
+
+namespace ProcessSort {
+void Sort(std::vector<Process>& processes, SortKey key);
+// Moves the first `k` processes by `key` to the front, in order, and leaves
+// the others after them in their previous order.
+void Top(std::vector<Process>& processes, SortKey key, std::size_t k);
+// The key after `key`, for cycling through them.
+SortKey Next(SortKey key);
+std::string Name(SortKey key);
+};  // namespace ProcessSort
+
+#endif
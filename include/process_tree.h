@@ -0,0 +1,87 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class Process;
+
+/*
+Parent/child index of the running processes.
+The index is maintained incrementally: inserting, re-parenting and removing a
+process only relink its neighbours, and subtree CPU and memory totals are kept
+up to date by propagating each process' change to its ancestors. Children are
+kept in pid order, so linking a process scans back from the last child of its
+parent to its place. New processes usually have the highest pid and take
+constant time, but after the pids wrap the scan grows with the number of
+siblings, e.g. the children of init. Rendering only walks the rows that are
+actually shown, so collapsing or expanding a subtree costs at most the size of
+that subtree.
+*/
+class ProcessTree {
+ public:
+  struct Row {
+    int pid;
+    Process* process;
+    int depth;
+    int num_children;
+    bool collapsed;
+    // Totals over the process and all of its descendants.
+    float cpu_utilization;
+    long memory_kb;
+  };
+
+  ProcessTree();
+  void Insert(int pid, int ppid);
+  void Remove(int pid);
+  void Update(Process& process);
+  bool ToggleCollapsed(int pid);
+  int Parent(int pid) const;
+  std::vector<int> Children(int pid) const;
+  float SubtreeCpuUtilization(int pid) const;
+  long SubtreeMemoryKb(int pid) const;
+  std::size_t Size() const;
+  // The first `n` visible rows in depth-first order. The rows refer to the
+  // processes last passed to `Update` and are only valid until they change.
+  // Processes that have not been passed to `Update` have no row, while their
+  // children keep theirs.
+  std::vector<Row>& Rows(int n);
+  // The pid of the row `offset` rows away from the row of `pid`, stopping at
+  // the first and last rows. Starts from the first row when `pid` is not
+  // shown, and returns -1 when there are no rows.
+  static int Neighbor(const std::vector<Row>& rows, int pid, int offset);
+
+ private:
+  // The kernel's idle task has pid 0 and is the parent of both init and
+  // kthreadd, so it doubles as the root of the tree.
+  static constexpr int kRootPid = 0;
+  static constexpr int kNone = -1;
+  struct Node {
+    // The parent reported by the process, which may not be known yet.
+    int ppid{kNone};
+    int parent{kNone};
+    int first_child{kNone};
+    int last_child{kNone};
+    int prev_sibling{kNone};
+    int next_sibling{kNone};
+    int num_children{0};
+    bool collapsed{false};
+    Process* process{nullptr};
+    float cpu_utilization{0};
+    long memory_kb{0};
+    float subtree_cpu_utilization{0};
+    long subtree_memory_kb{0};
+  };
+  void Link(int pid, Node& node, int parent);
+  void Unlink(Node& node);
+  void Forget(int pid, int ppid);
+  bool IsDescendant(int pid, int ancestor) const;
+  void Propagate(int parent, float cpu_delta, long memory_delta);
+  std::unordered_map<int, Node> nodes_;
+  // Processes whose parent has not been inserted yet, keyed by that parent.
+  std::unordered_map<int, std::vector<int>> waiting_;
+  std::vector<Row> rows_;
+};
+
+#endif
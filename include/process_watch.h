@@ -0,0 +1,81 @@
+#ifndef PROCESS_WATCH_H
+#define PROCESS_WATCH_H
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// The processes a targeted watch follows, with their descendants.
+struct WatchTarget {
+  std::vector<int> pids;
+  // Command names as in /proc/<pid>/comm, like pgrep.
+  std::vector<std::string> names;
+  // A cgroup v2 group relative to the cgroup root, e.g.
+  // system.slice/nginx.service. Its child groups are included.
+  std::string cgroup;
+  bool Empty() const {
+    return this->pids.empty() && this->names.empty() && this->cgroup.empty();
+  }
+};
+
+/*
+Lists the watched processes without enumerating /proc, so that a refresh costs
+the same on a host with 100 processes as on one with 100k, and can run many
+times a second.
+
+Descendants are found through /proc/<pid>/task/<tid>/children, which lists
+the children each thread forked. Processes found once stay watched while they
+live, so children orphaned by an exited parent are still followed; each is
+kept with its start time, so that a later process given the same pid is not
+taken for it. Members of
+the cgroup are read from cgroup.procs, of the group and of every child group.
+Names are resolved by a scan of /proc when the watch starts, and again every
+`kNameRescanInterval`, to catch named processes started later that descend
+from none of those found.
+*/
+class ProcessWatch {
+ public:
+  static constexpr std::chrono::seconds kNameRescanInterval{10};
+  // Watches nothing; `Active` is false.
+  ProcessWatch() = default;
+  ProcessWatch(std::string procsDirPath, std::string cgroupRootPath,
+               WatchTarget target);
+  bool Active() const { return !this->target_.Empty(); }
+  // Replaces `pids` with the watched processes that still run, in ascending
+  // order.
+  void List(std::vector<int>& pids);
+  // Parses a comma separated list of pids, e.g. "12,345".
+  // @throws std::invalid_argument for malformed lists.
+  static std::vector<int> ParsePids(const std::string& list);
+
+ private:
+  void ResolveNames();
+  // Adds the pids of a cgroup and of its child groups to the queue.
+  void AddCgroup(const std::string& dirPath);
+  // Adds the children of `pid` to the queue. Returns false if the process is
+  // gone.
+  bool AddChildren(int pid);
+  // Adds the pids listed in a file, separated by white space, to the queue.
+  bool AddPids(const char* filePath);
+  // Reads the start time of a process. Returns false if it is gone.
+  bool StartTime(int pid, long& startTime);
+  std::string procs_dir_path_;
+  std::string cgroup_root_path_;
+  WatchTarget target_;
+  // The pids of the named processes, as last resolved.
+  std::vector<int> named_;
+  bool resolved_{false};
+  std::chrono::steady_clock::time_point resolved_time_;
+  // The processes listed by the previous call, with their start times, in
+  // ascending order of pid.
+  std::vector<std::pair<int, long>> watched_;
+  std::vector<int> queue_;
+  std::unordered_set<int> seen_;
+  std::string contents_;
+  std::string comm_;
+  std::vector<char> buffer_;
+};
+
+#endif
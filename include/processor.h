@@ -1,3 +1,5 @@
+#include <chrono>
+#include <filesystem>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -7,6 +9,10 @@
 
 using namespace std;
 
+// Calls closer together than this return the previous sample, so that
+// everyone reporting on the same collection sees the same value.
+const std::chrono::milliseconds kMinSampleInterval(100);
+
 class Processor {
  public:
   Processor(string cpuStatsFilePath)
@@ -15,11 +21,22 @@ class Processor {
       throw runtime_error("processor's statistics file path must not be empty");
     }
   }
-  float Utilization();
+  virtual ~Processor() = default;
+  // The share of time busy since the previous sample, or since boot for the
+  // first sample.
+  virtual float Utilization();
+  // The active and total jiffies of the previous call, {-1, -1} before it.
+  std::pair<long, long> Counters() const;
+  // Continues from counters sampled by an earlier run of the monitor.
+  void Restore(long activeJiffies, long totalJiffies);
   bool operator==(Processor b) const;
 
  private:
-  const string cpu_stats_file_path_;
+  const std::filesystem::path cpu_stats_file_path_;
+  long active_jiffies_{-1};
+  long total_jiffies_{-1};
+  float utilization_{0};
+  std::chrono::steady_clock::time_point sampled_;
 };
 
 #endif
\ No newline at end of file
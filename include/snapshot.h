@@ -0,0 +1,95 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "process.h"
+#include "system.h"
+
+const std::string kDefaultSnapshotName{"/monitor-snapshot"};
+const int kMaxSnapshotProcesses = 256;
+
+// Fixed size records, so that the snapshot can live in shared memory.
+struct SnapshotProcess {
+  int pid;
+  int ppid;
+  float cpu_utilization;
+  long virtual_memory_kb;
+  long uptime;
+  char user[32];
+  char command[256];
+};
+
+struct SnapshotData {
+  float cpu_utilization;
+  float memory_utilization;
+  long uptime;
+  int total_processes;
+  int running_processes;
+  int blocked_processes;
+  char kernel[128];
+  char operating_system[128];
+  int num_processes;
+  SnapshotProcess processes[kMaxSnapshotProcesses];
+};
+
+/*
+Layout of the shared memory region.
+The collector writes each snapshot into the slot that readers are not
+directed to, guarded by that slot's sequence number (odd while a write is in
+progress), and then publishes the slot by bumping `generation`. Readers copy
+the current slot and retry if its sequence number changed under them, so
+they never block the collector and never see a torn snapshot.
+*/
+struct SnapshotRegion {
+  static constexpr uint32_t kMagic = 0x4d4f4e31;  // "MON1"
+  static constexpr uint32_t kVersion = 3;
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  // The collector that created the region, to tell a live region from one
+  // left behind by a crash.
+  int32_t publisher;
+  std::atomic<uint64_t> generation;
+  struct Slot {
+    std::atomic<uint64_t> sequence;
+    SnapshotData data;
+  } slots[2];
+};
+
+// Creates the shared memory region and publishes snapshots of a `System`.
+// Throws `std::runtime_error` if another collector publishes under the name.
+class SnapshotPublisher {
+ public:
+  SnapshotPublisher(const std::string& name = kDefaultSnapshotName);
+  ~SnapshotPublisher();
+  SnapshotPublisher(const SnapshotPublisher&) = delete;
+  SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+  void Publish(System& system);
+  void Publish(System& system, std::vector<Process>& processes);
+  void Publish(const SnapshotData& data);
+
+ private:
+  std::string name_;
+  SnapshotRegion* region_;
+  SnapshotData data_;
+};
+
+// Read-only view of a region created by a `SnapshotPublisher`.
+class SnapshotReader {
+ public:
+  SnapshotReader(const std::string& name = kDefaultSnapshotName);
+  ~SnapshotReader();
+  SnapshotReader(const SnapshotReader&) = delete;
+  SnapshotReader& operator=(const SnapshotReader&) = delete;
+  uint64_t Generation() const;
+  // Copies the latest snapshot. Returns its generation.
+  uint64_t Read(SnapshotData& data) const;
+
+ private:
+  const SnapshotRegion* region_;
+};
+
+#endif
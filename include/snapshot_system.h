@@ -0,0 +1,65 @@
+#ifndef SNAPSHOT_SYSTEM_H
+#define SNAPSHOT_SYSTEM_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "process.h"
+#include "process_tree.h"
+#include "processor.h"
+#include "snapshot.h"
+#include "system.h"
+
+// A processor whose utilization was measured by another process.
+class SnapshotProcessor : public Processor {
+ public:
+  SnapshotProcessor(string name) : Processor(std::move(name)) {}
+  float Utilization() override { return this->utilization_; }
+  void SetUtilization(float utilization) { this->utilization_ = utilization; }
+
+ private:
+  float utilization_{0};
+};
+
+/*
+A System backed by the snapshots published by a collector process, so that
+any number of viewers can share the cost of a single walk of /proc.
+*/
+class SnapshotSystem final : public System {
+ public:
+  SnapshotSystem(const std::string& name = kDefaultSnapshotName);
+  Processor& Cpu() override;
+  std::vector<Process>& Processes() override;
+  std::vector<Process>& Processes(
+      std::chrono::steady_clock::time_point deadline) override;
+  ScanProgress Progress() override;
+  float MemoryUtilization() override;
+  long UpTime() override;
+  int TotalProcesses() override;
+  int RunningProcesses() override;
+  int BlockedProcesses() override;
+  const std::string& Kernel() override;
+  const std::string& OperatingSystem() override;
+  std::vector<CgroupStats>& Cgroups() override;
+  ProcessTree& Tree() override;
+  ProcessGroups& Groups() override;
+  void SetFilter(ProcessFilter filter) override;
+
+ private:
+  void Refresh();
+  SnapshotReader reader_;
+  // Large enough that it is kept off the stack.
+  std::unique_ptr<SnapshotData> data_;
+  uint64_t generation_{0};
+  SnapshotProcessor snapshot_cpu_;
+  std::vector<Process> processes_;
+  std::unordered_set<int> known_pids_;
+  ProcessTree tree_;
+  ProcessGroups groups_;
+  std::vector<CgroupStats> cgroups_;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef STAT_SPLITTER_H
+#define STAT_SPLITTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+Splits a /proc/<pid>/stat line into the offsets of its fields after the
+command name, which ends at the last `)` as the name may hold spaces and
+parentheses itself.
+
+The vector versions compare 16 (SSE2) or 32 (AVX2) bytes at a time against
+the delimiters and turn the resulting bit masks into field boundaries, so a
+~300 byte line takes a dozen or so block compares instead of a branch per
+byte. `Split` uses the widest version the CPU supports, chosen once at
+startup; the others are exposed for tests and benchmarks.
+*/
+namespace StatSplitter {
+// More than the 52 fields of proc(5).
+constexpr std::size_t kMaxFields = 64;
+
+struct Fields {
+  // The offsets of the first byte and one past the last byte of each field,
+  // from the state (field 2) on.
+  std::array<uint16_t, kMaxFields> begin;
+  std::array<uint16_t, kMaxFields> end;
+  std::size_t count{0};
+  // The offset of the `)` closing the command name.
+  std::size_t comm_end{0};
+  std::string_view Field(std::string_view line, std::size_t i) const {
+    return line.substr(this->begin[i], this->end[i] - this->begin[i]);
+  }
+};
+
+enum class Isa { kScalar, kSse2, kAvx2 };
+
+// Splits up to `maxFields` fields. Returns false, for a line without a
+// command name or longer than the offsets hold.
+bool Split(std::string_view line, std::size_t maxFields, Fields& fields);
+// The version `Split` uses.
+Isa Selected();
+bool Supported(Isa isa);
+// Falls back to the scalar version where `isa` is not supported.
+bool Split(Isa isa, std::string_view line, std::size_t maxFields,
+           Fields& fields);
+}  // namespace StatSplitter
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef STATE_SAMPLER_H
+#define STATE_SAMPLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// How often a process was seen in each run state over a display interval.
+struct RunStates {
+  int running{0};
+  // S, or I for idle kernel threads.
+  int sleeping{0};
+  // Uninterruptible sleep, D, mostly waiting for I/O.
+  int blocked{0};
+  int zombie{0};
+  // Stopped, traced or dead.
+  int other{0};
+  void Add(char state);
+  int Samples() const {
+    return this->running + this->sleeping + this->blocked + this->zombie +
+           this->other;
+  }
+  // The share of the samples in D state, or -1 without samples.
+  float BlockedShare() const {
+    return Samples() > 0 ? float(this->blocked) / Samples() : -1;
+  }
+};
+
+/*
+Samples the run state of processes many times per display interval, on a
+background thread, so that a process that is always in uninterruptible sleep
+can be told from one that happened to be there when the display looked.
+
+Only the state field of /proc/<pid>/stat is read. The file of each sampled
+process is kept open and read with pread into a buffer on the stack, just far
+enough to reach the state after the command name. The caller picks the
+candidates, at most `kMaxCandidates` of them, as every sample costs a read.
+*/
+class StateSampler {
+ public:
+  // 50 Hz.
+  static constexpr std::chrono::milliseconds kDefaultInterval{20};
+  // Each candidate holds an open descriptor.
+  static constexpr std::size_t kMaxCandidates = 256;
+  explicit StateSampler(std::string procsDirPath,
+                        std::chrono::milliseconds interval = kDefaultInterval);
+  ~StateSampler();
+  StateSampler(const StateSampler&) = delete;
+  StateSampler& operator=(const StateSampler&) = delete;
+  // Starts the background thread. Without it, `Step` samples on the
+  // caller's thread.
+  void Start();
+  // Ends the current display interval, whose states `Get` returns from now
+  // on, and samples `pids` over the next one.
+  void Tick(const std::vector<int>& pids);
+  // The states of the last complete interval, empty for pids not sampled.
+  RunStates Get(int pid) const;
+  // Samples every candidate once.
+  void Step();
+  // The state of the stat file open at `fd`, or '\0' if it cannot be read.
+  static char ReadState(int fd);
+
+ private:
+  void Run();
+  std::string procs_dir_path_;
+  std::chrono::milliseconds interval_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_{false};
+  std::vector<int> pids_;
+  std::unordered_map<int, RunStates> current_;
+  std::unordered_map<int, RunStates> last_;
+  // Owned by the sampling thread.
+  std::vector<int> step_pids_;
+  std::unordered_map<int, int> files_;
+  std::vector<std::pair<int, char>> states_;
+  std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Stores each distinct string once, in large arena chunks, and identifies it by
+a 32 bit handle.
+Strings are reference counted. A string whose count drops to zero is removed
+from the index immediately, and a chunk is recycled as soon as none of its
+strings are alive any more. Strings are stored null terminated so that views
+can be passed to C APIs. The table is not thread safe.
+*/
+class StringTable {
+ public:
+  using Handle = uint32_t;
+  // The empty string, which is never stored.
+  static constexpr Handle kEmpty = 0;
+
+  StringTable();
+  StringTable(const StringTable&) = delete;
+  StringTable& operator=(const StringTable&) = delete;
+  // Returns the handle of the string, adding a reference to it.
+  Handle Intern(std::string_view value);
+  void Retain(Handle handle);
+  void Release(Handle handle);
+  std::string_view View(Handle handle) const;
+  // The number of distinct strings alive.
+  std::size_t Size() const;
+  // The bytes held by the arena chunks.
+  std::size_t ArenaBytes() const;
+  // The table shared by every `InternedString`.
+  static StringTable& Global();
+
+ private:
+  static constexpr std::size_t kChunkSize = 64 * 1024;
+  struct Entry {
+    uint32_t chunk;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t references;
+  };
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    std::size_t capacity;
+    std::size_t used;
+    std::size_t live;
+  };
+  uint32_t Allocate(std::size_t size);
+  std::vector<Entry> entries_;
+  std::vector<Handle> free_handles_;
+  std::vector<Chunk> chunks_;
+  std::vector<uint32_t> free_chunks_;
+  uint32_t current_chunk_;
+  std::unordered_map<std::string_view, Handle> index_;
+};
+
+// A reference counted handle to a string in the global `StringTable`.
+class InternedString {
+ public:
+  InternedString() = default;
+  explicit InternedString(std::string_view value);
+  InternedString(const InternedString& other);
+  InternedString(InternedString&& other) noexcept;
+  InternedString& operator=(const InternedString& other);
+  InternedString& operator=(InternedString&& other) noexcept;
+  ~InternedString();
+  std::string_view View() const;
+  StringTable::Handle Handle() const;
+  bool operator==(const InternedString& other) const;
+
+ private:
+  StringTable::Handle handle_{StringTable::kEmpty};
+};
+
+#endif
@@ -1,10 +1,17 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "cgroup_view.h"
+#include "process_filter.h"
+#include "process_groups.h"
+#include "process_tree.h"
 #include "processor.h"
 
 using namespace std;
@@ -12,24 +19,51 @@ using namespace std;
 // Forward declare the Process class to avoid dependency issues.
 class Process;
 
+// How far a collection of the processes, spread over several calls, has got.
+struct ScanProgress {
+  std::size_t scanned{0};
+  std::size_t total{0};
+  bool Done() const { return scanned >= total; }
+};
+
+// What the displays need of a source of system and process metrics. The
+// sources are final classes, so calls on them where their type is known, such
+// as those of their processes, are bound at compile time.
 class System {
  public:
   System(Processor cpu) : cpu_(std::move(cpu)) {}
+  virtual ~System() = default;
   virtual Processor& Cpu() = 0;
   virtual vector<Process>& Processes() = 0;
+  // Collects until `deadline` and returns the processes found so far. An
+  // unfinished collection is continued by the next call.
+  virtual vector<Process>& Processes(
+      std::chrono::steady_clock::time_point deadline) = 0;
+  virtual ScanProgress Progress() = 0;
   virtual float MemoryUtilization() = 0;
   virtual long UpTime() = 0;
   virtual int TotalProcesses() = 0;
   virtual int RunningProcesses() = 0;
-  virtual string Kernel() = 0;
-  virtual string OperatingSystem() = 0;
+  // Tasks in uninterruptible sleep waiting for I/O, at this moment.
+  virtual int BlockedProcesses() = 0;
+  // Valid until the next call.
+  virtual const string& Kernel() = 0;
+  virtual const string& OperatingSystem() = 0;
+  virtual vector<CgroupStats>& Cgroups() = 0;
+  virtual ProcessTree& Tree() = 0;
+  virtual ProcessGroups& Groups() = 0;
+  // Only lists the processes accepted by `filter` from now on.
+  virtual void SetFilter(ProcessFilter filter) = 0;
 
  protected:
   Processor cpu_;
-  vector<Process> processes_ = {};
 
   string osName_{""};
   string kernelName_{""};
 };
 
+// Receives the processes collected for each refresh of a display, so that
+// other consumers can reuse them rather than collecting them again.
+using CollectionHandler = std::function<void(System&, vector<Process>&)>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef WARM_STATE_H
+#define WARM_STATE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The identity and CPU counters of a process when the state was saved.
+struct WarmProcess {
+  int pid{0};
+  long start_time{0};
+  long total_ticks{0};
+  double sample_time{0};
+  std::string user;
+  std::string command;
+};
+
+// What a `LinuxSystem` needs to show real rates on its first frame after a
+// restart, instead of averages since boot.
+struct WarmState {
+  // The boot the state belongs to, see `LinuxParser::BootId`.
+  std::string boot_id;
+  // Seconds after boot at which the state was captured.
+  double time{0};
+  long cpu_active_jiffies{-1};
+  long cpu_total_jiffies{-1};
+  // The user id map, valid while /etc/passwd keeps this modification time.
+  long passwd_mtime{0};
+  std::unordered_map<std::string, std::string> uid_map;
+  std::vector<WarmProcess> processes;
+};
+
+/*
+Saves and loads a `WarmState` as a binary file, by default
+$XDG_RUNTIME_DIR/monitor-state. User names and commands are stored once each
+and referenced by index, like in the `StringTable`. The file is replaced
+atomically and is only readable by its owner.
+*/
+namespace WarmStart {
+const uint32_t kMagic = 0x4d4e5753;  // "MNWS"
+const uint32_t kVersion = 1;
+// Older states are no useful baseline for the first frame.
+const double kMaxAgeSeconds = 600;
+
+// The default state file, or an empty path without $XDG_RUNTIME_DIR.
+std::filesystem::path DefaultPath();
+bool Save(const WarmState& state, const std::filesystem::path& filePath);
+bool Load(const std::filesystem::path& filePath, WarmState& state);
+};  // namespace WarmStart
+
+#endif
@@ -0,0 +1,86 @@
+#include "cgroup_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::string;
+using std::vector;
+
+CgroupView::CgroupView(std::filesystem::path procsDirPath,
+                       std::filesystem::path cgroupRootPath, int numCpus)
+    : procs_dir_path_(std::move(procsDirPath)),
+      cgroup_root_path_(std::move(cgroupRootPath)),
+      num_cpus_(numCpus) {}
+
+vector<CgroupStats>& CgroupView::Groups() { return this->groups_; }
+
+vector<CgroupStats>& CgroupView::Update(const vector<int>& pids) {
+  return Update(pids, std::chrono::steady_clock::now());
+}
+
+vector<CgroupStats>& CgroupView::Update(
+    const vector<int>& pids, std::chrono::steady_clock::time_point now) {
+  // Count the members of each group, resolving only pids not seen before.
+  std::unordered_map<string, int> members;
+  std::unordered_set<int> live(pids.begin(), pids.end());
+  for (const int pid : pids) {
+    auto cached = this->pid_cgroups_.find(pid);
+    if (cached == this->pid_cgroups_.end()) {
+      const string cgroup = LinuxParser::Cgroup(this->procs_dir_path_, pid);
+      if (cgroup.empty()) {
+        continue;
+      }
+      cached = this->pid_cgroups_.emplace(pid, cgroup).first;
+    }
+    ++members[cached->second];
+  }
+  for (auto it = this->pid_cgroups_.begin(); it != this->pid_cgroups_.end();) {
+    it = live.count(it->first) ? std::next(it) : this->pid_cgroups_.erase(it);
+  }
+
+  this->groups_.clear();
+  std::unordered_map<string, Sample> samples;
+  for (const auto& [cgroup, count] : members) {
+    // The group path is absolute within the hierarchy, so strip the leading
+    // '/' before appending it to the mount point.
+    const std::filesystem::path dir =
+        this->cgroup_root_path_ / std::filesystem::path(cgroup).relative_path();
+    CgroupStats stats;
+    stats.path = cgroup;
+    stats.num_processes = count;
+    stats.memory_bytes = LinuxParser::CgroupMemoryCurrent(dir);
+    const auto [quota, period] = LinuxParser::CgroupCpuMax(dir);
+    stats.cpu_limit = quota > 0 && period > 0 ? float(quota) / period : 0;
+    const Sample sample{LinuxParser::CgroupCpuUsage(dir), now};
+    const auto previous = this->samples_.find(cgroup);
+    if (previous != this->samples_.end()) {
+      const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+          now - previous->second.sampled_at);
+      const float capacity = stats.cpu_limit > 0 ? stats.cpu_limit : num_cpus_;
+      if (elapsed.count() > 0 && capacity > 0) {
+        stats.cpu_utilization =
+            float(sample.usage_usec - previous->second.usage_usec) /
+            (float(elapsed.count()) * capacity);
+      }
+    }
+    samples.emplace(cgroup, sample);
+    this->groups_.push_back(stats);
+  }
+  // Only groups that still have members keep a baseline.
+  this->samples_.swap(samples);
+  std::sort(this->groups_.begin(), this->groups_.end(),
+            [](const CgroupStats& a, const CgroupStats& b) {
+              if (a.cpu_utilization != b.cpu_utilization) {
+                return a.cpu_utilization > b.cpu_utilization;
+              }
+              return a.path < b.path;
+            });
+  return this->groups_;
+}
@@ -0,0 +1,167 @@
+#include "event_loop.h"
+
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+const int kMaxEvents = 16;
+
+static std::runtime_error SystemError(const std::string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+EventLoop::EventLoop() {
+  this->epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (this->epoll_fd_ < 0) {
+    throw SystemError("could not create epoll instance");
+  }
+}
+
+EventLoop::~EventLoop() {
+  if (this->timer_fd_ >= 0) {
+    close(this->timer_fd_);
+  }
+  if (this->signal_fd_ >= 0) {
+    close(this->signal_fd_);
+  }
+  close(this->epoll_fd_);
+}
+
+void EventLoop::Add(int fd, uint32_t events, Handler handler) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+    throw SystemError("could not watch fd " + std::to_string(fd));
+  }
+  this->handlers_[fd] = std::make_shared<Handler>(std::move(handler));
+}
+
+void EventLoop::Remove(int fd) {
+  if (this->handlers_.erase(fd) > 0) {
+    epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  }
+}
+
+void EventLoop::SetTimer(std::chrono::milliseconds interval,
+                         std::function<void()> onTick) {
+  if (this->timer_fd_ < 0) {
+    this->timer_fd_ =
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (this->timer_fd_ < 0) {
+      throw SystemError("could not create timer");
+    }
+    Add(this->timer_fd_, EPOLLIN, [this](uint32_t) {
+      uint64_t expirations;
+      if (read(this->timer_fd_, &expirations, sizeof(expirations)) > 0 &&
+          this->on_tick_) {
+        // Ticks missed while busy are coalesced into one.
+        this->on_tick_();
+      }
+    });
+  }
+  this->interval_ = interval;
+  this->on_tick_ = std::move(onTick);
+  const long ns = std::chrono::nanoseconds(interval).count();
+  itimerspec spec{};
+  spec.it_interval.tv_sec = ns / 1000000000;
+  spec.it_interval.tv_nsec = ns % 1000000000;
+  spec.it_value = spec.it_interval;
+  if (timerfd_settime(this->timer_fd_, 0, &spec, nullptr) < 0) {
+    throw SystemError("could not arm timer");
+  }
+}
+
+std::chrono::milliseconds EventLoop::Interval() const {
+  return this->interval_;
+}
+
+void EventLoop::Defer(std::function<void()> task) {
+  this->deferred_.push_back(std::move(task));
+}
+
+void EventLoop::HandleSignals(const std::vector<int>& signals,
+                              std::function<void(int)> onSignal) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  for (const int signal : signals) {
+    sigaddset(&mask, signal);
+  }
+  if (sigprocmask(SIG_BLOCK, &mask, nullptr) < 0) {
+    throw SystemError("could not block signals");
+  }
+  this->signal_fd_ =
+      signalfd(this->signal_fd_, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (this->signal_fd_ < 0) {
+    throw SystemError("could not create signalfd");
+  }
+  this->on_signal_ = std::move(onSignal);
+  if (this->handlers_.count(this->signal_fd_) == 0) {
+    Add(this->signal_fd_, EPOLLIN, [this](uint32_t) {
+      signalfd_siginfo info;
+      while (read(this->signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+        this->on_signal_(info.ssi_signo);
+      }
+    });
+  }
+}
+
+/**
+ *  @brief  Waits for events and runs their handlers.
+ *  @param  timeout  The longest time to wait, or -1ms to wait indefinitely.
+ *
+ *  Deferred tasks do not wait: the events already ready are handled, then the
+ *  tasks deferred before this call are run.
+ *
+ *  @returns The number of events dispatched.
+ */
+int EventLoop::RunOnce(std::chrono::milliseconds timeout) {
+  if (!this->deferred_.empty()) {
+    timeout = std::chrono::milliseconds(0);
+  }
+  epoll_event events[kMaxEvents];
+  const int ready =
+      epoll_wait(this->epoll_fd_, events, kMaxEvents, timeout.count());
+  if (ready < 0) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    throw SystemError("could not wait for events");
+  }
+  for (int i = 0; i < ready; ++i) {
+    const auto found = this->handlers_.find(events[i].data.fd);
+    // An earlier handler may have removed this one.
+    if (found != this->handlers_.end()) {
+      const std::shared_ptr<Handler> handler = found->second;
+      (*handler)(events[i].events);
+    }
+  }
+  // Tasks deferred by these ones wait for the next round of events.
+  for (std::size_t n = this->deferred_.size(); n > 0; --n) {
+    std::function<void()> task = std::move(this->deferred_.front());
+    this->deferred_.pop_front();
+    task();
+  }
+  return ready;
+}
+
+void EventLoop::Run() {
+  this->running_ = true;
+  while (this->running_) {
+    RunOnce(std::chrono::milliseconds(-1));
+  }
+}
+
+void EventLoop::Stop() { this->running_ = false; }
@@ -0,0 +1,181 @@
+#include "fd_sampler.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "low_impact.h"
+
+using std::vector;
+
+namespace {
+// Large enough for the entries of a few thousand descriptors per call.
+const std::size_t kBufferBytes = 64 * 1024;
+// The nice level of the thread where SCHED_IDLE is not allowed.
+const int kFallbackNice = 19;
+}  // namespace
+
+FdSampler::FdSampler(std::string procsDirPath,
+                     std::chrono::milliseconds budget)
+    : procs_dir_path_(std::move(procsDirPath)), budget_(budget) {}
+
+FdSampler::~FdSampler() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stop_ = true;
+  }
+  this->wake_.notify_one();
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+}
+
+void FdSampler::Start() {
+  // Like the metrics server, the thread blocks every signal, so that they
+  // reach the display's handlers.
+  sigset_t all;
+  sigset_t previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+  this->thread_ = std::thread(&FdSampler::Run, this);
+  pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+void FdSampler::Tick(const vector<int>& pids) {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->pids_.assign(pids.begin(), pids.end());
+    this->ticked_ = true;
+  }
+  this->wake_.notify_one();
+}
+
+FdCount FdSampler::Get(int pid) const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  const auto it = this->counts_.find(pid);
+  return it == this->counts_.end() ? FdCount() : it->second;
+}
+
+/**
+ *  @brief  Counts the descriptors of the processes of the last tick.
+ *  @param  deadline  When to stop, leaving the rest to the next tick.
+ *
+ *  Processes never counted go first, then the others in turn by pid, each at
+ * most once per step.
+ */
+void FdSampler::Step(FdCount::Clock::time_point deadline) {
+  const FdCount::Clock::time_point start = FdCount::Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->ticked_pids_.assign(this->pids_.begin(), this->pids_.end());
+    std::sort(this->ticked_pids_.begin(), this->ticked_pids_.end());
+    for (auto it = this->counts_.begin(); it != this->counts_.end();) {
+      it = std::binary_search(this->ticked_pids_.begin(),
+                              this->ticked_pids_.end(), it->first)
+               ? std::next(it)
+               : this->counts_.erase(it);
+    }
+  }
+  const vector<int>& pids = this->ticked_pids_;
+  for (const int pid : pids) {
+    if (FdCount::Clock::now() >= deadline) {
+      return;
+    }
+    bool counted;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      counted = this->counts_.count(pid) > 0;
+    }
+    if (!counted) {
+      CountOne(pid);
+    }
+  }
+  const std::size_t first =
+      std::upper_bound(pids.begin(), pids.end(), this->last_pid_) -
+      pids.begin();
+  for (std::size_t i = 0; i < pids.size(); ++i) {
+    if (FdCount::Clock::now() >= deadline) {
+      return;
+    }
+    const int pid = pids[(first + i) % pids.size()];
+    if (Get(pid).time >= start) {
+      // Counted by the first pass.
+      continue;
+    }
+    CountOne(pid);
+    this->last_pid_ = pid;
+  }
+}
+
+/**
+ *  @brief  Counts the entries of a directory with getdents64.
+ *  @param  dirPath  The directory, e.g. /proc/42/fd.
+ *  @param  buffer  Receives the entries, grown once and reused.
+ *
+ *  @returns The entries other than `.` and `..`, or -1 if the directory
+ * cannot be read.
+ */
+long FdSampler::Count(const char* dirPath, vector<char>& buffer) {
+  const int fd = open(dirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  if (buffer.size() < kBufferBytes) {
+    buffer.resize(kBufferBytes);
+  }
+  long count = 0;
+  const bool read = LinuxParser::ForEachEntry(
+      fd, buffer.data(), buffer.size(), [&count](const dirent64& entry) {
+        if (std::strcmp(entry.d_name, ".") != 0 &&
+            std::strcmp(entry.d_name, "..") != 0) {
+          ++count;
+        }
+      });
+  close(fd);
+  return read ? count : -1;
+}
+
+void FdSampler::Run() {
+  try {
+    LowImpact::SetIdle();
+  } catch (const std::runtime_error&) {
+    try {
+      LowImpact::SetNice(kFallbackNice);
+    } catch (const std::runtime_error&) {
+      // Counts at the priority of the monitor.
+    }
+  }
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (true) {
+    this->wake_.wait(lock, [this] { return this->ticked_ || this->stop_; });
+    if (this->stop_) {
+      return;
+    }
+    this->ticked_ = false;
+    lock.unlock();
+    Step(FdCount::Clock::now() + this->budget_);
+    lock.lock();
+  }
+}
+
+void FdSampler::CountOne(int pid) {
+  char dirPath[PATH_MAX];
+  std::snprintf(dirPath, sizeof(dirPath), "%s/%d/fd",
+                this->procs_dir_path_.c_str(), pid);
+  const FdCount count{Count(dirPath, this->buffer_), FdCount::Clock::now()};
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->counts_[pid] = count;
+}
@@ -1,8 +1,11 @@
 #include "format.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <string>
+#include <vector>
 
 using std::string;
 
@@ -24,4 +27,20 @@ string Format::ElapsedTime(long seconds) {
   std::sprintf(output, "%.2li:%.2li:%.2li", hrs.count(), mins.count(),
                secs.count());
   return output;
-}
\ No newline at end of file
+}
+
+string Format::Sparkline(const std::vector<float>& values, float max) {
+  static const char* const kBlocks[] = {"▁", "▂", "▃", "▄",
+                                        "▅", "▆", "▇", "█"};
+  constexpr int kLevels = sizeof(kBlocks) / sizeof(kBlocks[0]);
+  string line;
+  for (const float value : values) {
+    if (std::isnan(value)) {
+      line += ' ';
+      continue;
+    }
+    const float share = max > 0 ? std::clamp(value / max, 0.0f, 1.0f) : 0;
+    line += kBlocks[std::min(int(share * kLevels), kLevels - 1)];
+  }
+  return line;
+}
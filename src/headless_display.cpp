@@ -0,0 +1,164 @@
+#include "headless_display.h"
+
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "format.h"
+#include "process_columns.h"
+#include "system.h"
+
+using std::setw;
+using std::string;
+
+void HeadlessDisplay::DisplaySystem(System& system, std::ostream& out) {
+  out << "OS: " << system.OperatingSystem() << "\n";
+  out << "Kernel: " << system.Kernel() << "\n";
+  out << "CPU: " << std::fixed << std::setprecision(1)
+      << system.Cpu().Utilization() * 100 << "%\n";
+  out << "Memory: " << system.MemoryUtilization() * 100 << "%\n";
+  out << "Total Processes: " << system.TotalProcesses() << "\n";
+  out << "Running Processes: " << system.RunningProcesses() << "\n";
+  out << "Blocked Processes: " << system.BlockedProcesses() << "\n";
+  out << "Up Time: " << Format::ElapsedTime(system.UpTime()) << "\n";
+}
+
+void HeadlessDisplay::DisplayPressure(std::vector<PressureStats>& pressure,
+                                      std::ostream& out) {
+  for (const PressureStats& stats : pressure) {
+    out << "Pressure " << std::left << setw(7) << stats.resource + ":"
+        << std::right << std::fixed << std::setprecision(2) << "some "
+        << stats.some.avg10 << "% " << stats.some.avg60 << "% (+"
+        << stats.some.delta_us / 1000 << "ms)";
+    if (stats.has_full) {
+      out << " full " << stats.full.avg10 << "% " << stats.full.avg60
+          << "% (+" << stats.full.delta_us / 1000 << "ms)";
+    }
+    out << "\n";
+  }
+}
+
+void HeadlessDisplay::DisplayIo(const IoStats& io, std::ostream& out) {
+  out << std::fixed << std::setprecision(0) << "Paging: faults "
+      << io.vm.faults << "/s major " << io.vm.major_faults << "/s swap in "
+      << io.vm.swap_in << "/s out " << io.vm.swap_out << "/s scan "
+      << io.vm.scanned << "/s steal " << io.vm.stolen << "/s\n";
+  for (const DiskRates& disk : io.disks) {
+    out << "Disk " << disk.name << ": r " << std::setprecision(0)
+        << disk.reads << "/s " << std::setprecision(1)
+        << disk.read_bytes / 1e6 << "MB/s w " << std::setprecision(0)
+        << disk.writes << "/s " << std::setprecision(1)
+        << disk.write_bytes / 1e6 << "MB/s util " << disk.utilization * 100
+        << "% await " << std::setprecision(2) << disk.await_ms << "ms\n";
+  }
+  for (const NetRates& interface : io.interfaces) {
+    out << "Net " << interface.name << ": rx " << std::setprecision(1)
+        << interface.rx_bytes / 1e6 << "MB/s " << std::setprecision(0)
+        << interface.rx_packets << "p/s tx " << std::setprecision(1)
+        << interface.tx_bytes / 1e6 << "MB/s " << std::setprecision(0)
+        << interface.tx_packets << "p/s drop "
+        << interface.rx_drops + interface.tx_drops << "/s\n";
+  }
+}
+
+void HeadlessDisplay::DisplayOverhead(const SelfMonitor::Overhead& overhead,
+                                      std::ostream& out) {
+  out << SelfMonitor::Describe(overhead) << "\n";
+}
+
+void HeadlessDisplay::DisplayProcesses(std::vector<Process>& processes,
+                                       std::ostream& out, int n, bool sched,
+                                       bool fds, bool blocked) {
+  using namespace ProcessColumns;
+  using Base = Columns<Pid, User, Cpu, Ram, Time>;
+  using Sched = Columns<Latency, Wait, Switches, InvoluntarySwitches>;
+  using Descriptors = Columns<Fds, FdAge>;
+  out << std::left;
+  Base::Header(out);
+  if (sched) {
+    Sched::Header(out);
+  }
+  if (fds) {
+    Descriptors::Header(out);
+  }
+  if (blocked) {
+    Columns<Blocked>::Header(out);
+  }
+  Columns<Command>::Header(out);
+  out << "\n";
+  int const num_processes = int(processes.size()) > n ? n : processes.size();
+  for (int i = 0; i < num_processes; ++i) {
+    Base::Row(processes[i], out);
+    if (sched) {
+      Sched::Row(processes[i], out);
+    }
+    if (fds) {
+      Descriptors::Row(processes[i], out);
+    }
+    if (blocked) {
+      Columns<Blocked>::Row(processes[i], out);
+    }
+    Columns<Command>::Row(processes[i], out);
+    out << "\n";
+  }
+  out << std::right;
+}
+
+void HeadlessDisplay::DisplayGroups(std::vector<ProcessGroups::Row>& rows,
+                                    std::ostream& out, GroupBy by) {
+  out << std::left << setw(8) << "CPU[%]" << setw(9) << "RAM[MB]" << setw(7)
+      << "PROCS" << (by == GroupBy::kUser ? "USER" : "COMMAND") << "\n";
+  for (const ProcessGroups::Row& group : rows) {
+    out << setw(8) << std::fixed << std::setprecision(1)
+        << group.cpu_utilization * 100 << setw(9) << group.memory_kb / 1000
+        << setw(7) << group.num_processes
+        << (group.name.empty() ? "-" : group.name) << "\n";
+  }
+  out << std::right;
+}
+
+namespace {
+volatile std::sig_atomic_t stop_display = 0;
+}  // namespace
+
+void HeadlessDisplay::Display(System& system, PressureMonitor& pressure,
+                              IoMonitor& io, const Options& options,
+                              CollectionHandler onCollect) {
+  std::signal(SIGINT, [](int) { stop_display = 1; });
+  std::signal(SIGTERM, [](int) { stop_display = 1; });
+  SelfMonitor self(options.cpu_budget / 100.0);
+  while (!stop_display) {
+    if (!self.Admit()) {
+      pressure.Wait(options.interval);
+      continue;
+    }
+    // The system panel is cheap, so it is out before the process scan.
+    DisplaySystem(system, std::cout);
+    DisplayOverhead(self.Report(), std::cout);
+    DisplayPressure(pressure.Update(), std::cout);
+    if (options.show_io) {
+      DisplayIo(io.Update(), std::cout);
+    }
+    std::cout.flush();
+    std::vector<Process>& processes = system.Processes();
+    if (onCollect) {
+      onCollect(system, processes);
+    }
+    if (options.group_by != GroupBy::kProcess) {
+      DisplayGroups(system.Groups().Rows(options.group_by,
+                                         options.num_processes),
+                    std::cout, options.group_by);
+    } else {
+      DisplayProcesses(processes, std::cout, options.num_processes,
+                       options.show_sched, options.show_fds,
+                       options.show_blocked);
+    }
+    std::cout << std::endl;
+    if (pressure.Wait(options.interval)) {
+      std::cout << "PSI trigger fired\n";
+    }
+  }
+}
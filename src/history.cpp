@@ -0,0 +1,305 @@
+#include "history.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <ratio>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+namespace {
+using Tenths = std::chrono::duration<int64_t, std::ratio<1, 10>>;
+
+// Significant bits kept of each value, including the implicit leading one.
+constexpr int kValueBits = 8;
+
+uint32_t ToTenths(History::Clock::time_point time) {
+  const int64_t tenths =
+      std::chrono::duration_cast<Tenths>(time.time_since_epoch()).count();
+  return uint32_t(std::max<int64_t>(tenths, 0));
+}
+
+History::Clock::time_point FromTenths(uint32_t tenths) {
+  return History::Clock::time_point(
+      std::chrono::duration_cast<History::Clock::duration>(Tenths(tenths)));
+}
+
+// Rounds away the low mantissa bits, so that the XOR of two values has at
+// least that many trailing zeros.
+uint32_t Quantize(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  constexpr int kDropped = 24 - kValueBits;
+  bits += 1u << (kDropped - 1);
+  return bits & ~((1u << kDropped) - 1);
+}
+
+float ToFloat(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// The fields of an encoded point, written once it is known to fit.
+struct Encoding {
+  std::array<std::pair<uint64_t, int>, 8> fields;
+  int count{0};
+  int width{0};
+  void Add(uint64_t bits, int fieldWidth) {
+    this->fields[this->count++] = {bits, fieldWidth};
+    this->width += fieldWidth;
+  }
+};
+
+template <std::size_t N>
+void Append(std::array<uint8_t, N>& buffer, uint16_t& position, uint64_t bits,
+            int width) {
+  for (int i = width - 1; i >= 0; --i) {
+    if ((bits >> i) & 1) {
+      buffer[position >> 3] |= uint8_t(0x80 >> (position & 7));
+    }
+    ++position;
+  }
+}
+
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+  bool Done() const { return this->position_ >= this->size_; }
+  uint64_t Read(int width) {
+    uint64_t bits = 0;
+    for (int i = 0; i < width; ++i, ++this->position_) {
+      const uint8_t byte = this->data_[this->position_ >> 3];
+      bits = (bits << 1) | ((byte >> (7 - (this->position_ & 7))) & 1);
+    }
+    return bits;
+  }
+
+ private:
+  const uint8_t* data_;
+  std::size_t size_;
+  std::size_t position_{0};
+};
+}  // namespace
+
+bool SeriesKey::operator==(const SeriesKey& other) const {
+  return this->pid == other.pid && this->start_time == other.start_time &&
+         this->metric == other.metric;
+}
+
+std::size_t SeriesKeyHash::operator()(const SeriesKey& key) const {
+  return (std::hash<long>()(key.start_time) * 31 + key.pid) * 2 +
+         std::size_t(key.metric);
+}
+
+History::History(std::chrono::seconds window, std::size_t maxBytes)
+    : window_(window),
+      max_blocks_(std::max<std::size_t>(maxBytes / sizeof(Block), 1)) {}
+
+void History::Add(const SeriesKey& key, Clock::time_point time, float value) {
+  Series& series = this->series_[key];
+  const uint32_t tenths = ToTenths(time);
+  const uint32_t bits = Quantize(value);
+  if (!series.blocks.empty()) {
+    if (tenths < series.last_time) {
+      return;
+    }
+    Encoding encoding;
+    // The time, as the change of the interval since the previous point.
+    const int64_t delta = int64_t(tenths) - series.last_time;
+    const int64_t deltaOfDelta = delta - series.last_delta;
+    if (deltaOfDelta == 0) {
+      encoding.Add(0b0, 1);
+    } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+      encoding.Add(0b10, 2);
+      encoding.Add(deltaOfDelta + 63, 7);
+    } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+      encoding.Add(0b110, 3);
+      encoding.Add(deltaOfDelta + 255, 9);
+    } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+      encoding.Add(0b1110, 4);
+      encoding.Add(deltaOfDelta + 2047, 12);
+    } else {
+      encoding.Add(0b1111, 4);
+      encoding.Add(uint32_t(int32_t(deltaOfDelta)), 32);
+    }
+    // The value, as the bits that differ from the previous one.
+    const uint32_t xored = bits ^ series.last_value;
+    uint8_t leading = series.leading;
+    uint8_t trailing = series.trailing;
+    if (xored == 0) {
+      encoding.Add(0b0, 1);
+    } else {
+      const int lead = __builtin_clz(xored);
+      const int trail = __builtin_ctz(xored);
+      if (leading != kNoWindow && lead >= leading && trail >= trailing) {
+        encoding.Add(0b10, 2);
+        encoding.Add(xored >> trailing, 32 - leading - trailing);
+      } else {
+        leading = lead;
+        trailing = trail;
+        const int length = 32 - lead - trail;
+        encoding.Add(0b11, 2);
+        encoding.Add(lead, 5);
+        encoding.Add(length - 1, 5);
+        encoding.Add(xored >> trail, length);
+      }
+    }
+    Block& block = series.blocks.back();
+    if (block.num_bits + encoding.width <= int(kBlockBytes * 8)) {
+      for (int i = 0; i < encoding.count; ++i) {
+        Append(block.bits, block.num_bits, encoding.fields[i].first,
+               encoding.fields[i].second);
+      }
+      block.last_time = tenths;
+      series.last_time = tenths;
+      series.last_delta = delta;
+      series.last_value = bits;
+      series.leading = leading;
+      series.trailing = trailing;
+      return;
+    }
+  }
+  // A new block, starting with the raw point.
+  if (this->num_blocks_ >= this->max_blocks_) {
+    EvictOldest(series);
+  }
+  series.blocks.emplace_back();
+  ++this->num_blocks_;
+  Block& block = series.blocks.back();
+  Append(block.bits, block.num_bits, tenths, 32);
+  Append(block.bits, block.num_bits, bits, 32);
+  block.first_time = tenths;
+  block.last_time = tenths;
+  series.last_time = tenths;
+  series.last_delta = 0;
+  series.last_value = bits;
+  series.leading = kNoWindow;
+}
+
+vector<History::Point> History::Decode(const Block& block) {
+  vector<Point> points;
+  BitReader reader(block.bits.data(), block.num_bits);
+  uint32_t time = reader.Read(32);
+  uint32_t value = reader.Read(32);
+  points.push_back({FromTenths(time), ToFloat(value)});
+  int64_t delta = 0;
+  int leading = 0;
+  int trailing = 0;
+  while (!reader.Done()) {
+    int64_t deltaOfDelta = 0;
+    if (!reader.Read(1)) {
+      deltaOfDelta = 0;
+    } else if (!reader.Read(1)) {
+      deltaOfDelta = int64_t(reader.Read(7)) - 63;
+    } else if (!reader.Read(1)) {
+      deltaOfDelta = int64_t(reader.Read(9)) - 255;
+    } else if (!reader.Read(1)) {
+      deltaOfDelta = int64_t(reader.Read(12)) - 2047;
+    } else {
+      deltaOfDelta = int32_t(reader.Read(32));
+    }
+    delta += deltaOfDelta;
+    time += delta;
+    if (reader.Read(1)) {
+      if (reader.Read(1)) {
+        leading = reader.Read(5);
+        trailing = 32 - leading - (int(reader.Read(5)) + 1);
+      }
+      value ^= uint32_t(reader.Read(32 - leading - trailing)) << trailing;
+    }
+    points.push_back({FromTenths(time), ToFloat(value)});
+  }
+  return points;
+}
+
+vector<History::Point> History::Points(const SeriesKey& key) const {
+  vector<Point> points;
+  const auto series = this->series_.find(key);
+  if (series == this->series_.end()) {
+    return points;
+  }
+  for (const Block& block : series->second.blocks) {
+    const vector<Point> decoded = Decode(block);
+    points.insert(points.end(), decoded.begin(), decoded.end());
+  }
+  return points;
+}
+
+vector<float> History::Resample(const SeriesKey& key, Clock::time_point end,
+                                std::size_t width) const {
+  vector<float> values(width, std::numeric_limits<float>::quiet_NaN());
+  const auto series = this->series_.find(key);
+  if (width == 0 || series == this->series_.end()) {
+    return values;
+  }
+  const Clock::time_point start = end - this->window_;
+  const uint32_t startTenths = ToTenths(start);
+  for (const Block& block : series->second.blocks) {
+    if (block.last_time < startTenths) {
+      continue;
+    }
+    for (const Point& point : Decode(block)) {
+      if (point.time < start || point.time > end) {
+        continue;
+      }
+      const std::size_t span = std::min<std::size_t>(
+          width - 1, (point.time - start) * width / this->window_);
+      if (std::isnan(values[span]) || point.value > values[span]) {
+        values[span] = point.value;
+      }
+    }
+  }
+  return values;
+}
+
+void History::Retain(const std::unordered_set<int>& pids,
+                     Clock::time_point now) {
+  const uint32_t oldest = ToTenths(now - this->window_);
+  for (auto it = this->series_.begin(); it != this->series_.end();) {
+    std::deque<Block>& blocks = it->second.blocks;
+    if (it->first.pid != 0 && !pids.count(it->first.pid)) {
+      this->num_blocks_ -= blocks.size();
+      blocks.clear();
+    }
+    while (!blocks.empty() && blocks.front().last_time < oldest) {
+      blocks.pop_front();
+      --this->num_blocks_;
+    }
+    it = blocks.empty() ? this->series_.erase(it) : std::next(it);
+  }
+}
+
+// Drops the block whose last point is the oldest. A series left without
+// blocks goes as well, unless it is the one about to get a new block.
+void History::EvictOldest(const Series& keep) {
+  auto oldest = this->series_.end();
+  for (auto it = this->series_.begin(); it != this->series_.end(); ++it) {
+    if (!it->second.blocks.empty() &&
+        (oldest == this->series_.end() ||
+         it->second.blocks.front().last_time <
+             oldest->second.blocks.front().last_time)) {
+      oldest = it;
+    }
+  }
+  if (oldest == this->series_.end()) {
+    return;
+  }
+  oldest->second.blocks.pop_front();
+  --this->num_blocks_;
+  if (oldest->second.blocks.empty() && &oldest->second != &keep) {
+    this->series_.erase(oldest);
+  }
+}
+
+std::size_t History::Bytes() const {
+  return this->num_blocks_ * sizeof(Block);
+}
+
+std::size_t History::NumSeries() const { return this->series_.size(); }
@@ -0,0 +1,373 @@
+#include "io_monitor.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "processor.h"
+
+using std::string;
+
+namespace {
+// The buffer grows by this much until a file fits.
+const std::size_t kReadBytes = 16 * 1024;
+// The kernel counts /proc/diskstats sectors in 512 byte units, whatever the
+// sector size of the device.
+const double kSectorBytes = 512;
+// /proc/diskstats: the fields after the device name.
+const int kDiskFields = 10;
+const int kDiskReadsField = 0;
+const int kDiskSectorsReadField = 2;
+const int kDiskReadMsField = 3;
+const int kDiskWritesField = 4;
+const int kDiskSectorsWrittenField = 6;
+const int kDiskWriteMsField = 7;
+const int kDiskIoMsField = 9;
+// /proc/net/dev: the fields after the interface name.
+const int kNetFields = 12;
+const int kNetRxBytesField = 0;
+const int kNetRxPacketsField = 1;
+const int kNetRxDropsField = 3;
+const int kNetTxBytesField = 8;
+const int kNetTxPacketsField = 9;
+const int kNetTxDropsField = 11;
+
+bool IsBlank(char c) { return c == ' ' || c == '\t'; }
+
+const char* SkipBlanks(const char* next, const char* end) {
+  while (next < end && IsBlank(*next)) {
+    ++next;
+  }
+  return next;
+}
+
+// Parses the number starting at the next field of a line, leaving `value` at
+// 0 and skipping the rest of the line if there is none.
+const char* NextNumber(const char* next, const char* end,
+                       unsigned long long& value) {
+  value = 0;
+  const auto [last, error] =
+      std::from_chars(SkipBlanks(next, end), end, value);
+  return error == std::errc() ? last : end;
+}
+
+// The increase of a counter, or 0 if it went backwards.
+double Delta(unsigned long long current, unsigned long long previous) {
+  return current >= previous ? current - previous : 0;
+}
+
+// Moves the device named `name`, found from slot `count` on, to that slot,
+// or a new unknown device if it is not there. The devices in between keep
+// their order, so one that appears or goes idle does not move the counters
+// of the others out of reach.
+template <typename Rates, typename Counters>
+void TakeSlot(std::string_view name, std::size_t count,
+              std::vector<Rates>& rates, std::vector<Counters>& counters,
+              std::vector<bool>& known) {
+  std::size_t slot = count;
+  while (slot < rates.size() && rates[slot].name != name) {
+    ++slot;
+  }
+  if (slot == rates.size()) {
+    rates.emplace_back();
+    counters.emplace_back();
+    known.push_back(false);
+  }
+  if (slot != count) {
+    std::rotate(rates.begin() + count, rates.begin() + slot,
+                rates.begin() + slot + 1);
+    std::rotate(counters.begin() + count, counters.begin() + slot,
+                counters.begin() + slot + 1);
+    std::rotate(known.begin() + count, known.begin() + slot,
+                known.begin() + slot + 1);
+  }
+}
+}  // namespace
+
+IoMonitor::IoMonitor(string diskstatsPath, string netDevPath,
+                     string vmstatPath) {
+  this->diskstats_.path = std::move(diskstatsPath);
+  this->net_dev_.path = std::move(netDevPath);
+  this->vmstat_.path = std::move(vmstatPath);
+}
+
+IoMonitor::~IoMonitor() {
+  for (const File* file :
+       {&this->diskstats_, &this->net_dev_, &this->vmstat_}) {
+    if (file->fd >= 0) {
+      close(file->fd);
+    }
+  }
+}
+
+const IoStats& IoMonitor::Update() {
+  return Update(std::chrono::steady_clock::now());
+}
+
+/**
+ *  @brief  Reads the three files and updates the rates.
+ *  @param  now  The time of the reads, which the rates are computed over.
+ *
+ *  Like the CPU, calls within `kMinSampleInterval` of the last update return
+ * its rates, so that a redraw does not measure a few milliseconds.
+ */
+const IoStats& IoMonitor::Update(std::chrono::steady_clock::time_point now) {
+  if (this->updated_ && now - this->last_update_ < kMinSampleInterval) {
+    return this->stats_;
+  }
+  const double seconds =
+      this->updated_
+          ? std::chrono::duration<double>(now - this->last_update_).count()
+          : 0;
+  this->updated_ = true;
+  this->last_update_ = now;
+  if (Read(this->diskstats_)) {
+    ParseDisks(seconds);
+  } else {
+    this->stats_.disks.clear();
+    this->disk_counters_.clear();
+    this->disk_known_.clear();
+  }
+  if (Read(this->net_dev_)) {
+    ParseInterfaces(seconds);
+  } else {
+    this->stats_.interfaces.clear();
+    this->net_counters_.clear();
+    this->net_known_.clear();
+  }
+  if (Read(this->vmstat_)) {
+    ParseVm(seconds);
+  } else {
+    this->stats_.vm = VmRates();
+    this->vm_known_ = false;
+  }
+  return this->stats_;
+}
+
+/**
+ *  @brief  Reads a file into the buffer from its start.
+ *
+ *  The file is opened on the first read and kept open. The buffer only grows,
+ * so once it fits the largest file reading allocates nothing.
+ */
+bool IoMonitor::Read(File& file) {
+  this->length_ = 0;
+  if (file.fd < 0) {
+    file.fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file.fd < 0) {
+      return false;
+    }
+  }
+  std::size_t length = 0;
+  while (true) {
+    if (this->buffer_.size() - length < kReadBytes) {
+      this->buffer_.resize(length + kReadBytes);
+    }
+    const ssize_t size = pread(file.fd, this->buffer_.data() + length,
+                               this->buffer_.size() - length, length);
+    if (size < 0 && errno == EINTR) {
+      continue;
+    }
+    if (size < 0) {
+      return false;
+    }
+    if (size == 0) {
+      break;
+    }
+    length += size;
+  }
+  this->length_ = length;
+  return true;
+}
+
+// One line per device: major, minor, name and the counters.
+void IoMonitor::ParseDisks(double seconds) {
+  std::vector<DiskRates>& disks = this->stats_.disks;
+  std::size_t count = 0;
+  const char* next = this->buffer_.data();
+  const char* const end = next + this->length_;
+  while (next < end) {
+    const char* line_end =
+        static_cast<const char*>(std::memchr(next, '\n', end - next));
+    line_end = line_end == nullptr ? end : line_end;
+    unsigned long long number;
+    const char* field = NextNumber(next, line_end, number);
+    field = SkipBlanks(NextNumber(field, line_end, number), line_end);
+    const char* name_end = field;
+    while (name_end < line_end && !IsBlank(*name_end)) {
+      ++name_end;
+    }
+    const std::string_view name(field, name_end - field);
+    unsigned long long values[kDiskFields];
+    field = name_end;
+    for (unsigned long long& value : values) {
+      field = NextNumber(field, line_end, value);
+    }
+    next = line_end + 1;
+    if (name.empty() ||
+        values[kDiskReadsField] + values[kDiskWritesField] == 0) {
+      continue;
+    }
+    TakeSlot(name, count, disks, this->disk_counters_, this->disk_known_);
+    DiskRates& rates = disks[count];
+    DiskCounters& counters = this->disk_counters_[count];
+    const bool known = this->disk_known_[count] && seconds > 0;
+    if (rates.name != name) {
+      rates.name.assign(name);
+    }
+    const DiskCounters current{
+        values[kDiskReadsField],  values[kDiskSectorsReadField],
+        values[kDiskReadMsField], values[kDiskWritesField],
+        values[kDiskSectorsWrittenField], values[kDiskWriteMsField],
+        values[kDiskIoMsField]};
+    // Without a previous value every rate is 0.
+    const double per_second = known ? 1 / seconds : 0;
+    const double reads = Delta(current.reads, counters.reads);
+    const double writes = Delta(current.writes, counters.writes);
+    rates.reads = reads * per_second;
+    rates.writes = writes * per_second;
+    rates.read_bytes =
+        Delta(current.sectors_read, counters.sectors_read) * kSectorBytes *
+        per_second;
+    rates.write_bytes =
+        Delta(current.sectors_written, counters.sectors_written) *
+        kSectorBytes * per_second;
+    rates.utilization =
+        std::min(1.0, Delta(current.io_ms, counters.io_ms) / 1000 * per_second);
+    // As iostat's await: the time spent by the requests completed in the
+    // interval, over their number.
+    rates.await_ms = known && reads + writes > 0
+                         ? (Delta(current.read_ms, counters.read_ms) +
+                            Delta(current.write_ms, counters.write_ms)) /
+                               (reads + writes)
+                         : 0;
+    counters = current;
+    this->disk_known_[count] = true;
+    ++count;
+  }
+  disks.resize(count);
+  this->disk_counters_.resize(count);
+  this->disk_known_.resize(count);
+}
+
+// Two header lines, then one line per interface: the name, a colon, and the
+// receive and transmit counters.
+void IoMonitor::ParseInterfaces(double seconds) {
+  std::vector<NetRates>& interfaces = this->stats_.interfaces;
+  std::size_t count = 0;
+  const char* next = this->buffer_.data();
+  const char* const end = next + this->length_;
+  while (next < end) {
+    const char* line_end =
+        static_cast<const char*>(std::memchr(next, '\n', end - next));
+    line_end = line_end == nullptr ? end : line_end;
+    const char* colon =
+        static_cast<const char*>(std::memchr(next, ':', line_end - next));
+    const char* line = next;
+    next = line_end + 1;
+    if (colon == nullptr) {
+      continue;
+    }
+    const char* name_begin = SkipBlanks(line, colon);
+    const std::string_view name(name_begin, colon - name_begin);
+    unsigned long long values[kNetFields];
+    const char* field = colon + 1;
+    for (unsigned long long& value : values) {
+      field = NextNumber(field, line_end, value);
+    }
+    if (name.empty() ||
+        values[kNetRxBytesField] + values[kNetTxBytesField] == 0) {
+      continue;
+    }
+    TakeSlot(name, count, interfaces, this->net_counters_, this->net_known_);
+    NetRates& rates = interfaces[count];
+    NetCounters& counters = this->net_counters_[count];
+    const bool known = this->net_known_[count] && seconds > 0;
+    if (rates.name != name) {
+      rates.name.assign(name);
+    }
+    const NetCounters current{
+        values[kNetRxBytesField], values[kNetRxPacketsField],
+        values[kNetRxDropsField], values[kNetTxBytesField],
+        values[kNetTxPacketsField], values[kNetTxDropsField]};
+    const double per_second = known ? 1 / seconds : 0;
+    rates.rx_bytes = Delta(current.rx_bytes, counters.rx_bytes) * per_second;
+    rates.tx_bytes = Delta(current.tx_bytes, counters.tx_bytes) * per_second;
+    rates.rx_packets =
+        Delta(current.rx_packets, counters.rx_packets) * per_second;
+    rates.tx_packets =
+        Delta(current.tx_packets, counters.tx_packets) * per_second;
+    rates.rx_drops = Delta(current.rx_drops, counters.rx_drops) * per_second;
+    rates.tx_drops = Delta(current.tx_drops, counters.tx_drops) * per_second;
+    counters = current;
+    this->net_known_[count] = true;
+    ++count;
+  }
+  interfaces.resize(count);
+  this->net_counters_.resize(count);
+  this->net_known_.resize(count);
+}
+
+// One `name value` line per counter.
+void IoMonitor::ParseVm(double seconds) {
+  // Reclaim is split by who scanned or reclaimed; the totals add them up.
+  static const std::pair<std::string_view, VmCounter> kKeys[] = {
+      {"pgfault", kFaults},
+      {"pgmajfault", kMajorFaults},
+      {"pswpin", kSwapIn},
+      {"pswpout", kSwapOut},
+      {"pgscan_kswapd", kScanned},
+      {"pgscan_direct", kScanned},
+      {"pgscan_khugepaged", kScanned},
+      {"pgsteal_kswapd", kStolen},
+      {"pgsteal_direct", kStolen},
+      {"pgsteal_khugepaged", kStolen}};
+  VmCounters current{};
+  const char* next = this->buffer_.data();
+  const char* const end = next + this->length_;
+  while (next < end) {
+    const char* line_end =
+        static_cast<const char*>(std::memchr(next, '\n', end - next));
+    line_end = line_end == nullptr ? end : line_end;
+    const char* name_end = next;
+    while (name_end < line_end && !IsBlank(*name_end)) {
+      ++name_end;
+    }
+    const std::string_view name(next, name_end - next);
+    next = line_end + 1;
+    // Every counter of interest starts with "p".
+    if (name.empty() || name[0] != 'p') {
+      continue;
+    }
+    for (const auto& [key, counter] : kKeys) {
+      if (name == key) {
+        unsigned long long value;
+        NextNumber(name_end, line_end, value);
+        current[counter] += value;
+        break;
+      }
+    }
+  }
+  const double per_second = this->vm_known_ && seconds > 0 ? 1 / seconds : 0;
+  auto rate = [&](VmCounter counter) {
+    return Delta(current[counter], this->vm_counters_[counter]) * per_second;
+  };
+  VmRates& vm = this->stats_.vm;
+  vm.faults = rate(kFaults);
+  vm.major_faults = rate(kMajorFaults);
+  vm.swap_in = rate(kSwapIn);
+  vm.swap_out = rate(kSwapOut);
+  vm.scanned = rate(kScanned);
+  vm.stolen = rate(kStolen);
+  this->vm_counters_ = current;
+  this->vm_known_ = true;
+}
@@ -1,11 +1,19 @@
 #include "linux_parser.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+
 #include <filesystem>
 #include <iostream>
 #include <iterator>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -16,34 +24,129 @@ using std::string;
 using std::to_string;
 using std::vector;
 
+namespace {
+// The buffer the files read on every refresh are read into. It grows to the
+// largest of them once, so refreshes after the first do not allocate.
+string &Scratch() {
+  static thread_local string contents;
+  return contents;
+}
+
+// Reads with plain system calls rather than a stream, which would allocate
+// its buffer for every file. `contents` keeps its capacity between calls.
+bool Read(const char *filePath, string &contents) {
+  const int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  // Reading the files of a process fails with ESRCH once it has exited.
+  contents.clear();
+  char buffer[4096];
+  ssize_t size;
+  while ((size = read(fd, buffer, sizeof(buffer))) > 0 ||
+         (size < 0 && errno == EINTR)) {
+    if (size > 0) {
+      contents.append(buffer, size);
+    }
+  }
+  close(fd);
+  return size == 0;
+}
+
+// /proc/stat: the fields of the first line, the totals of every CPU, by
+// `LinuxParser::CPUStates`.
+using CpuStatSchema = ProcSchema::Positional<1, 2, 3, 4, 5, 6, 7, 8, 9, 10>;
+using UptimeSchema = ProcSchema::Positional<0>;
+// /proc/loadavg: the three load averages, runnable/total tasks and the last
+// pid.
+using LoadavgSchema = ProcSchema::Positional<4>;
+}  // namespace
+
 /**
- *  @brief  Searches in an external file for a line starting with the specified
- * value, and returns the associated value.
- *  @param  filePath  A reference to the path to the file to read data from.
- *  @param  key  The word to search the file for, at the start of the line in
- * the file.
+ *  @brief  Reads the values of the keys of a schema from a keyed file, such as
+ * /proc/meminfo.
+ *  @param  filePath  The file to read data from.
+ *  @param  values  Receives the value of each key, or 0 for missing keys.
  *
- *  @returns The first matching token of type `Value` on the row that starts
- * with the specified word.
+ *  @returns Whether every key was found.
  */
-template <typename Key, typename Value>
-Value FindValue(const std::filesystem::path &filePath, const Key &key) {
-  Key currentKey;
-  Value currentValue;
-  string line;
-  std::ifstream stream(filePath);
+template <typename Keys>
+bool ReadKeys(const char *filePath,
+              typename ProcSchema::Keyed<Keys>::Values &values) {
+  values.fill(0);
+  string &contents = Scratch();
+  return Read(filePath, contents) &&
+         ProcSchema::Keyed<Keys>::Extract(contents, values);
+}
+
+bool LinuxParser::ReadFile(const std::filesystem::path &filePath,
+                           string &contents) {
+  return Read(filePath.c_str(), contents);
+}
+
+bool LinuxParser::ReadFile(const char *filePath, string &contents) {
+  return Read(filePath, contents);
+}
+
+/**
+ *  @brief  Reads the random id the kernel generates at each boot.
+ *  @param  procsDirPath  The proc filesystem, e.g. /proc.
+ *
+ *  @returns The id, or an empty string if it cannot be read.
+ */
+string LinuxParser::BootId(const std::filesystem::path &procsDirPath) {
+  string id;
+  std::ifstream stream(procsDirPath / kBootIdFilePath);
   if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> currentKey >> currentValue;
-      if (currentKey == key) {
-        stream.close();
-        return currentValue;
-      }
-    }
+    stream >> id;
     stream.close();
   }
-  return currentValue;
+  return id;
+}
+
+// Seconds since boot, including suspended time, the clock of /proc/uptime.
+double LinuxParser::BootTime() {
+  timespec now;
+  clock_gettime(CLOCK_BOOTTIME, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+bool LinuxParser::ProcessStats(const std::filesystem::path &filePath,
+                               ProcessStatSchema::Values &values) {
+  string &contents = Scratch();
+  return ReadFile(filePath, contents) &&
+         ProcessStatSchema::Extract(contents, values);
+}
+
+bool LinuxParser::SchedStats(const std::filesystem::path &filePath,
+                             SchedStatSchema::Values &values) {
+  string &contents = Scratch();
+  return ReadFile(filePath, contents) &&
+         SchedStatSchema::Extract(contents, values);
+}
+
+bool LinuxParser::ContextSwitches(
+    const std::filesystem::path &filePath,
+    ProcSchema::Keyed<StatusSwitchKeys>::Values &values) {
+  return ReadKeys<StatusSwitchKeys>(filePath.c_str(), values);
+}
+
+bool LinuxParser::ProcessIdentity(const std::filesystem::path &filePath,
+                                  string &comm, long &startTime) {
+  string &contents = Scratch();
+  if (!ReadFile(filePath, contents)) {
+    return false;
+  }
+  const size_t begin = contents.find('(');
+  const size_t end = contents.rfind(')');
+  ProcSchema::Stat<kStarttimeStatIndex>::Values values;
+  if (begin == string::npos || end == string::npos || end < begin ||
+      !ProcSchema::Stat<kStarttimeStatIndex>::Extract(contents, values)) {
+    return false;
+  }
+  comm.assign(contents, begin + 1, end - begin - 1);
+  startTime = values[0];
+  return true;
 }
 
 vector<string> LinuxParser::Stats(const std::filesystem::path &filePath) {
@@ -100,35 +203,56 @@ string LinuxParser::Kernel(const std::filesystem::path &filePath) {
 
 vector<int> LinuxParser::Pids(const std::string &dirPath) {
   vector<int> pids;
-  const std::filesystem::path directory{dirPath};
-  for (auto const& dir_entry : std::filesystem::directory_iterator{directory}) {
-    if (dir_entry.is_directory()) {
-      // Is every character of the name a digit?
-      string filename(dir_entry.path().filename());
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
-      }
-    }
-  }
+  Pids(dirPath, pids);
   return pids;
 }
 
-float LinuxParser::MemoryUtilization(const std::filesystem::path &filePath) {
-  float value, memTotal, memFree;
-  string line, keyName;
-  std::ifstream stream(filePath);
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> keyName >> value;
-      if (keyName == kMemTotalKey) {
-        memTotal = value;
-      } else if (keyName == kMemFreeKey) {
-        memFree = value;
-      }
+/**
+ *  @brief  Lists the pids of a proc filesystem.
+ *  @param  dirPath  The proc filesystem, or a directory laid out like it.
+ *  @param  pids  Receives the names of the subdirectories that are numbers.
+ *
+ *  The directory is read into a buffer on the stack.
+ */
+void LinuxParser::Pids(const std::string &dirPath, vector<int> &pids) {
+  pids.clear();
+  const int fd = open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  alignas(dirent64) char buffer[16384];
+  ForEachEntry(fd, buffer, sizeof(buffer), [fd, &pids](const dirent64 &entry) {
+    int pid = 0;
+    const char *name = entry.d_name;
+    for (; *name >= '0' && *name <= '9'; ++name) {
+      pid = pid * 10 + (*name - '0');
     }
-    stream.close();
+    if (*name != '\0' || name == entry.d_name) {
+      return;
+    }
+    // Processes exit while the directory is listed, so entries that are gone
+    // by now are skipped rather than reported.
+    struct stat status;
+    if (entry.d_type == DT_DIR ||
+        (entry.d_type == DT_UNKNOWN &&
+         fstatat(fd, entry.d_name, &status, 0) == 0 &&
+         S_ISDIR(status.st_mode))) {
+      pids.push_back(pid);
+    }
+  });
+  close(fd);
+  // Directory iteration order is filesystem dependent, callers expect a stable
+  // ascending order.
+  std::sort(pids.begin(), pids.end());
+}
+
+float LinuxParser::MemoryUtilization(const std::filesystem::path &filePath) {
+  ProcSchema::Keyed<MeminfoKeys>::Values values;
+  ReadKeys<MeminfoKeys>(filePath.c_str(), values);
+  const float memTotal = values[0];
+  const float memFree = values[1];
+  if (memTotal == 0) {
+    return 0;
   }
   // The output, display expects the utilization percentage to not be multiplied
   // by 100 e.g. 0.041 instead of 4.1.
@@ -136,16 +260,10 @@ float LinuxParser::MemoryUtilization(const std::filesystem::path &filePath) {
 }
 
 long LinuxParser::UpTime(const std::filesystem::path &filePath) {
-  long upTime;
-  string line;
-  std::ifstream stream(filePath);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    linestream >> upTime;
-    stream.close();
-  }
-  return upTime;
+  UptimeSchema::Values values{0};
+  // The fraction of the seconds ends the parse of the number.
+  ReadFile(filePath, Scratch()) && UptimeSchema::Extract(Scratch(), values);
+  return values[0];
 }
 
 long LinuxParser::Jiffies(const std::filesystem::path &filePath) {
@@ -173,6 +291,22 @@ long LinuxParser::IdleJiffies(const std::filesystem::path &filePath) {
          stol(values[LinuxParser::kIOwait_]);
 }
 
+bool LinuxParser::CpuJiffies(const std::filesystem::path &filePath,
+                             long &active, long &idle) {
+  CpuStatSchema::Values values{};
+  string &contents = Scratch();
+  if (!ReadFile(filePath, contents)) {
+    return false;
+  }
+  // Older kernels have fewer columns, which count as 0.
+  CpuStatSchema::Extract(contents, values);
+  active = values[kUser_] + values[kNice_] + values[kSystem_] +
+           values[kIRQ_] + values[kSoftIRQ_] + values[kSteal_] +
+           values[kGuest_] + values[kGuestNice_];
+  idle = values[kIdle_] + values[kIOwait_];
+  return true;
+}
+
 vector<string> LinuxParser::CpuUtilization(
     const std::filesystem::path &filePath) {
   vector<string> stats = Stats(filePath);
@@ -182,11 +316,30 @@ vector<string> LinuxParser::CpuUtilization(
 }
 
 int LinuxParser::TotalProcesses(const std::filesystem::path &filePath) {
-  return FindValue<std::string, int>(filePath, kTotalProcsKey);
+  ProcSchema::Keyed<StatProcessesKeys>::Values values;
+  ReadKeys<StatProcessesKeys>(filePath.c_str(), values);
+  return values[0];
 }
 
 int LinuxParser::RunningProcesses(const std::filesystem::path &filePath) {
-  return FindValue<std::string, int>(filePath, kNumRunningProcsKey);
+  ProcSchema::Keyed<StatProcessesKeys>::Values values;
+  ReadKeys<StatProcessesKeys>(filePath.c_str(), values);
+  return values[1];
+}
+
+int LinuxParser::BlockedProcesses(const std::filesystem::path &filePath) {
+  ProcSchema::Keyed<StatProcessesKeys>::Values values;
+  ReadKeys<StatProcessesKeys>(filePath.c_str(), values);
+  return values[2];
+}
+
+long LinuxParser::LastPid(const std::filesystem::path &filePath) {
+  LoadavgSchema::Values values;
+  if (!ReadFile(filePath, Scratch()) ||
+      !LoadavgSchema::Extract(Scratch(), values)) {
+    return -1;
+  }
+  return values[0];
 }
 
 string LinuxParser::Command(const std::filesystem::path &filePathRoot,
@@ -205,39 +358,137 @@ string LinuxParser::Command(const std::filesystem::path &filePathRoot,
   return line;
 }
 
+// The status file always gives the memory sizes in kB.
 string LinuxParser::Ram(const std::filesystem::path &filePathRoot, int pid) {
+  char filePath[PATH_MAX];
+  std::snprintf(filePath, sizeof(filePath), "%s/%d/%s", filePathRoot.c_str(),
+                pid, kMemoryUtilizationFilePath.c_str());
+  ProcSchema::Keyed<StatusVmSizeKeys>::Values values;
+  if (!ReadKeys<StatusVmSizeKeys>(filePath, values)) {
+    return "0";
+  }
+  return SystemMemory::Utilization(SystemMemory::Unit::kb, values[0])
+      .ToMbString();
+}
+
+string LinuxParser::Uid(const std::filesystem::path &filePathRoot, int pid) {
+  std::filesystem::path filePath =
+      filePathRoot / std::filesystem::path(std::to_string(pid)) / kUidFilePath;
+  ProcSchema::Keyed<StatusUidKeys>::Values values;
+  if (!ReadKeys<StatusUidKeys>(filePath.c_str(), values)) {
+    return string();
+  }
+  return to_string(values[0]);
+}
+
+// NOTE: Provided function not required in this implementation
+string LinuxParser::User(int pid [[maybe_unused]]) { return string(); }
+
+// NOTE: Provided function not required in this implementation
+long LinuxParser::UpTime(int pid [[maybe_unused]]) { return 0; }
+
+/**
+ *  @brief  Finds the cgroup v2 (unified hierarchy) membership of a process.
+ *  @param  filePathRoot  The root of the proc filesystem.
+ *  @param  pid  The process to look up.
+ *
+ *  @returns The cgroup path relative to the cgroup root, e.g.
+ * `/system.slice/nginx.service`, or an empty string when the process has
+ * exited or the host only mounts the v1 hierarchies.
+ */
+string LinuxParser::Cgroup(const std::filesystem::path &filePathRoot,
+                           int pid) {
   std::filesystem::path filePath = filePathRoot /
                                    std::filesystem::path(std::to_string(pid)) /
-                                   kMemoryUtilizationFilePath;
-  int amount;
-  string line, key, unitValue;
+                                   kCgroupFilePath;
+  string line;
   std::ifstream stream(filePath);
   if (stream.is_open()) {
     while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> amount >> unitValue;
-      if (key == kMemoryUtilizationKey) {
+      // The unified hierarchy is always reported as `0::<path>`.
+      if (line.rfind("0::", 0) == 0) {
         stream.close();
-        SystemMemory::Unit unit = SystemMemory::UnitFromString(unitValue);
-        return SystemMemory::Utilization(unit, amount).ToMbString();
+        return line.substr(3);
       }
     }
     stream.close();
   }
-  return "0";
+  return string();
 }
 
-string LinuxParser::Uid(const std::filesystem::path &filePathRoot, int pid) {
-  std::filesystem::path filePath =
-      filePathRoot / std::filesystem::path(std::to_string(pid)) / kUidFilePath;
-  return FindValue<string, string>(filePath, kUidKey);
+long LinuxParser::CgroupCpuUsage(const std::filesystem::path &cgroupPath) {
+  ProcSchema::Keyed<CgroupCpuStatKeys>::Values values;
+  ReadKeys<CgroupCpuStatKeys>((cgroupPath / kCgroupCpuStatFilePath).c_str(),
+                              values);
+  return values[0];
 }
 
-// NOTE: Provided function not required in this implementation
-string LinuxParser::User(int pid [[maybe_unused]]) { return string(); }
+long LinuxParser::CgroupMemoryCurrent(const std::filesystem::path &cgroupPath) {
+  long bytes{0};
+  std::ifstream stream(cgroupPath / kCgroupMemoryCurrentFilePath);
+  if (stream.is_open()) {
+    stream >> bytes;
+    stream.close();
+  }
+  return bytes;
+}
 
-// NOTE: Provided function not required in this implementation
-long LinuxParser::UpTime(int pid [[maybe_unused]]) { return 0; }
+/**
+ *  @brief  Reads the CPU bandwidth limit of a cgroup.
+ *  @param  cgroupPath  The cgroup's directory within the cgroup filesystem.
+ *
+ *  @returns The `{quota, period}` pair in microseconds. The quota is -1 when
+ * the group is unlimited (`max`) or when the file is missing, e.g. for the
+ * root cgroup.
+ */
+std::pair<long, long> LinuxParser::CgroupCpuMax(
+    const std::filesystem::path &cgroupPath) {
+  string quota, period;
+  std::ifstream stream(cgroupPath / kCgroupCpuMaxFilePath);
+  if (stream.is_open()) {
+    stream >> quota >> period;
+    stream.close();
+  }
+  if (quota.empty() || quota == kCgroupUnlimitedValue || period.empty()) {
+    return {-1, period.empty() ? 0 : std::stol(period)};
+  }
+  return {std::stol(quota), std::stol(period)};
+}
+
+/**
+ *  @brief  Reads one line of a pressure stall information file, e.g.
+ * `some avg10=0.12 avg60=0.05 avg300=0.01 total=123456`.
+ *  @param  filePath  The file, e.g. /proc/pressure/memory.
+ *  @param  key  The line to read, `some` or `full`.
+ *
+ *  @returns The avg10, avg60 and avg300 percentages followed by the total stall
+ * time in microseconds, or an empty vector when the line is missing.
+ */
+vector<double> LinuxParser::Pressure(const std::filesystem::path &filePath,
+                                     const string &key) {
+  vector<double> values;
+  string line, token;
+  std::ifstream stream(filePath);
+  if (stream.is_open()) {
+    while (std::getline(stream, line)) {
+      std::istringstream linestream(line);
+      linestream >> token;
+      if (token != key) {
+        continue;
+      }
+      while (linestream >> token) {
+        const size_t separator = token.find('=');
+        if (separator == string::npos) {
+          continue;
+        }
+        values.push_back(std::stod(token.substr(separator + 1)));
+      }
+      break;
+    }
+    stream.close();
+  }
+  return values.size() == 4 ? values : vector<double>();
+}
 
 std::unordered_map<string, string> LinuxParser::UserIdMap(
     const std::filesystem::path &filePath) {
@@ -1,17 +1,27 @@
 #include "linux_system.h"
 
+#include <unistd.h>
+
 #include <algorithm>
 #include <chrono>
+#include <climits>
+#include <cstdio>
 #include <filesystem>
 #include <iostream>
+#include <tuple>
 
 #include "linux_parser.h"
 #include "process.h"
 
 using namespace std;
 
-LinuxSystem::LinuxSystem() : System(Processor(kDefaultProcessorStatsFilePath)) {
+LinuxSystem::LinuxSystem()
+    : System(Processor(kDefaultProcessorStatsFilePath)),
+      cgroup_view_(LinuxParser::kProcDirectory, LinuxParser::kCgroupRootPath,
+                   sysconf(_SC_NPROCESSORS_ONLN)) {
   this->procs_dir_path_ = LinuxParser::kProcDirectory;
+  this->procs_dir_ = this->procs_dir_path_;
+  this->loadavg_file_path_ = this->procs_dir_ / LinuxParser::kLoadavgFilePath;
   this->cpu_info_file_path_ =
       LinuxParser::kProcDirectory + LinuxParser::kCpuinfoFilename;
   this->mem_info_file_path_ =
@@ -25,16 +35,21 @@ LinuxSystem::LinuxSystem() : System(Processor(kDefaultProcessorStatsFilePath)) {
       LinuxParser::kProcDirectory + LinuxParser::kUptimeFilename;
   this->kernel_info_file_path_ =
       LinuxParser::kProcDirectory + LinuxParser::kVersionFilename;
-  this->uid_map_ = LinuxParser::UserIdMap(LinuxParser::kPasswordPath);
+  this->passwd_file_path_ = LinuxParser::kPasswordPath;
+  this->cgroup_root_path_ = LinuxParser::kCgroupRootPath;
 }
 
 LinuxSystem::LinuxSystem(string procs_dir_path, string cpuInfoFilePath,
                          string memInfoFilePath, string osVersionFilePath,
                          string statusFilePath, string statsFilePath,
                          string uptimeFilePath, string kernelInfoFilePath,
-                         string etcPasswdFilePath)
-    : System(Processor(statsFilePath)) {
+                         string etcPasswdFilePath, string cgroupRootPath)
+    : System(Processor(statsFilePath)),
+      cgroup_view_(procs_dir_path, cgroupRootPath,
+                   sysconf(_SC_NPROCESSORS_ONLN)) {
   this->procs_dir_path_ = procs_dir_path;
+  this->procs_dir_ = this->procs_dir_path_;
+  this->loadavg_file_path_ = this->procs_dir_ / LinuxParser::kLoadavgFilePath;
   this->cpu_info_file_path_ = cpuInfoFilePath;
   this->mem_info_file_path_ = memInfoFilePath;
   this->os_version_file_path_ = osVersionFilePath;
@@ -42,32 +57,447 @@ LinuxSystem::LinuxSystem(string procs_dir_path, string cpuInfoFilePath,
   this->stats_file_path_ = statsFilePath;
   this->uptime_file_path_ = uptimeFilePath;
   this->kernel_info_file_path_ = kernelInfoFilePath;
-  this->uid_map_ = LinuxParser::UserIdMap(etcPasswdFilePath);
+  this->passwd_file_path_ = etcPasswdFilePath;
+  this->cgroup_root_path_ = cgroupRootPath;
 }
 
 LinuxSystem::~LinuxSystem() {
   this->uid_map_.clear();
-  this->proc_map_.clear();
+  this->known_pids_.clear();
   this->processes_.clear();
 }
 
 Processor& LinuxSystem::Cpu() { return this->cpu_; }
 
+// The process list is kept between calls: processes that have exited are
+// dropped, new ones are added, and the process tree is updated to match.
+//
+// The filter is applied in stages. Pid predicates are checked before anything
+// is read and stat predicates before the status and cmdline files are read, so
+// rejected processes are never charged the expensive reads. Processes rejected
+// by their user or command are remembered until their stat file shows an exec
+// or a reused pid.
 vector<Process>& LinuxSystem::Processes() {
-  this->processes_.clear();
-  const vector<int> currentPids = LinuxParser::Pids(this->procs_dir_path_);
-  const filesystem::path procDirPath(this->procs_dir_path_);
-  for (const int pid : currentPids) {
-    const string uid = LinuxParser::Uid(this->procs_dir_path_, pid);
-    const string cmd = LinuxParser::Command(this->procs_dir_path_, pid);
-    const Process proc(this, pid, this->uid_map_[uid], cmd, procDirPath);
-    processes_.push_back(proc);
+  return Processes(std::chrono::steady_clock::time_point::max());
+}
+
+// New processes are added until the deadline, so that a display can show the
+// processes found so far while a large /proc is being walked.
+vector<Process>& LinuxSystem::Processes(
+    std::chrono::steady_clock::time_point deadline) {
+  if (this->progress_.Done()) {
+    StartScan();
+  }
+  // Hidden processes that now pass the stat predicates are listed.
+  size_t hidden = 0;
+  for (Process& proc : hidden_) {
+    const bool accepted = this->filter_.AcceptsStat(proc);
+    if (proc.Gone()) {
+      // Found again by the next scan if the pid was taken over.
+      this->known_pids_.erase(proc.Pid());
+      continue;
+    }
+    if (!accepted) {
+      if (&hidden_[hidden] != &proc) {
+        hidden_[hidden] = std::move(proc);
+      }
+      ++hidden;
+      continue;
+    }
+    List(proc);
+  }
+  hidden_.erase(hidden_.begin() + hidden, hidden_.end());
+
+  while (this->num_pending_added_ < this->pending_pids_.size()) {
+    // Checking the clock for every pid would cost more than reading a few.
+    if (this->num_pending_added_ % kScanDeadlineStride == 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    const int pid = this->pending_pids_[this->num_pending_added_++];
+    Process proc(this, pid, this->procs_dir_);
+    if (proc.Gone()) {
+      // Exited since the directory was listed.
+      this->exited_pids_.push_back(pid);
+      continue;
+    }
+    this->known_pids_.insert(pid);
+    const auto warm = this->warm_processes_.find(pid);
+    if (warm != this->warm_processes_.end() &&
+        !proc.Restore(warm->second.start_time, warm->second.total_ticks,
+                      warm->second.sample_time)) {
+      // The pid now belongs to another process.
+      this->warm_processes_.erase(warm);
+    }
+    if (this->filter_.AcceptsStat(proc)) {
+      List(proc);
+    } else {
+      hidden_.push_back(std::move(proc));
+    }
+  }
+  this->progress_.scanned = this->num_pending_added_;
+  if (this->progress_.Done()) {
+    this->pending_pids_.clear();
+    this->warm_processes_.clear();
+    if (this->fd_sampler_) {
+      TickFdSampler();
+    }
   }
   std::sort(processes_.rbegin(), processes_.rend());
+  if (this->progress_.Done() && this->state_sampler_) {
+    TickStateSampler();
+  }
   return processes_;
 }
 
-std::string LinuxSystem::Kernel() {
+// Lists a process that passes the stat predicates, reading its user and
+// command the first time.
+void LinuxSystem::List(Process& proc) {
+  if (!proc.Identified()) {
+    const auto warm = this->warm_processes_.find(proc.Pid());
+    const bool warmed = warm != this->warm_processes_.end();
+    const string user =
+        warmed ? warm->second.user
+               : UserIdMap()[LinuxParser::Uid(this->procs_dir_path_,
+                                              proc.Pid())];
+    bool accepted = this->filter_.AcceptsUser(user);
+    string cmd;
+    if (accepted) {
+      cmd = warmed ? warm->second.command
+                   : LinuxParser::Command(this->procs_dir_path_, proc.Pid());
+      accepted = this->filter_.AcceptsCommand(cmd);
+    }
+    if (!accepted) {
+      this->known_pids_.erase(proc.Pid());
+      Rejection rejection{"", proc.StartTime()};
+      LinuxParser::ProcessIdentity(
+          filesystem::path(this->procs_dir_path_) / to_string(proc.Pid()) /
+              LinuxParser::kProcStatFilePath,
+          rejection.comm, rejection.start_time);
+      this->rejected_[proc.Pid()] = std::move(rejection);
+      return;
+    }
+    proc.Identify(user, cmd);
+  }
+  this->tree_.Insert(proc.Pid(), proc.Ppid());
+  processes_.push_back(std::move(proc));
+}
+
+ScanProgress LinuxSystem::Progress() { return this->progress_; }
+
+// Drops the processes that have exited, re-checks the listed ones and finds
+// the new pids for `Processes` to add.
+//
+// On a quiet tick, when no process has started since the last walk of /proc,
+// the walk is skipped and the pids of the last one are kept, less those whose
+// directory is gone or whose reads have failed since. Nothing counts exits,
+// so each pid is checked, which costs a lookup rather than a read.
+void LinuxSystem::StartScan() {
+  if (this->watch_.Active()) {
+    this->watch_.List(this->pids_);
+  } else if (Quiet()) {
+    char path[PATH_MAX];
+    for (const int pid : this->pids_) {
+      std::snprintf(path, sizeof(path), "%s/%d", this->procs_dir_path_.c_str(),
+                    pid);
+      if (access(path, F_OK) != 0) {
+        this->exited_pids_.push_back(pid);
+      }
+    }
+    std::sort(this->exited_pids_.begin(), this->exited_pids_.end());
+    this->pids_.erase(
+        std::remove_if(this->pids_.begin(), this->pids_.end(),
+                       [this](int pid) {
+                         return std::binary_search(this->exited_pids_.begin(),
+                                                   this->exited_pids_.end(),
+                                                   pid);
+                       }),
+        this->pids_.end());
+  } else {
+    LinuxParser::Pids(this->procs_dir_path_, this->pids_);
+  }
+  this->exited_pids_.clear();
+  // The pids are sorted, and searching them costs less than hashing them.
+  const auto live = [this](int pid) {
+    return std::binary_search(this->pids_.begin(), this->pids_.end(), pid);
+  };
+  const auto exited = [this, &live](Process& proc) {
+    if (live(proc.Pid())) {
+      return false;
+    }
+    this->known_pids_.erase(proc.Pid());
+    this->tree_.Remove(proc.Pid());
+    this->groups_.Remove(proc.Pid());
+    return true;
+  };
+  processes_.erase(std::remove_if(processes_.begin(), processes_.end(), exited),
+                   processes_.end());
+  hidden_.erase(std::remove_if(hidden_.begin(), hidden_.end(), exited),
+                hidden_.end());
+  for (auto it = rejected_pids_.begin(); it != rejected_pids_.end();) {
+    it = live(*it) ? std::next(it) : rejected_pids_.erase(it);
+  }
+  for (auto it = rejected_.begin(); it != rejected_.end();) {
+    it = live(it->first) ? std::next(it) : rejected_.erase(it);
+  }
+
+  // The list is sorted by CPU, so processes are sampled again whether they
+  // are drawn or not, each as often as its tier asks. Drawn processes are
+  // sampled by the display as well.
+  int running = 0;
+  bool skipped = false;
+  for (Process& proc : processes_) {
+    if (proc.SampleDue()) {
+      proc.CpuUtilization();
+    } else {
+      skipped = true;
+    }
+    if (proc.Running()) {
+      running += proc.Threads();
+    }
+  }
+  // procs_running counts threads, so it is compared with the threads of the
+  // running processes. More runnable tasks than those means that a skipped
+  // sleeper may have woken up, so all are sampled. A sleeping process with a
+  // running thread, or a task that is not listed, makes a false alarm, which
+  // only costs a full pass.
+  if (skipped && RunningProcesses() > running) {
+    for (Process& proc : processes_) {
+      proc.CpuUtilization();
+    }
+  }
+
+  // Listed processes that no longer pass the stat predicates are hidden.
+  size_t listed = 0;
+  for (Process& proc : processes_) {
+    if (proc.Gone()) {
+      // A reused pid is not known any more, so it is identified again below.
+      this->known_pids_.erase(proc.Pid());
+      this->tree_.Remove(proc.Pid());
+      this->groups_.Remove(proc.Pid());
+      continue;
+    }
+    if (!this->filter_.AcceptsStat(proc)) {
+      this->tree_.Remove(proc.Pid());
+      this->groups_.Remove(proc.Pid());
+      hidden_.push_back(std::move(proc));
+      continue;
+    }
+    // Orphans are re-parented by the kernel.
+    if (this->tree_.Parent(proc.Pid()) != proc.Ppid()) {
+      this->tree_.Insert(proc.Pid(), proc.Ppid());
+    }
+    if (&processes_[listed] != &proc) {
+      processes_[listed] = std::move(proc);
+    }
+    ++listed;
+  }
+  processes_.erase(processes_.begin() + listed, processes_.end());
+
+  this->pending_pids_.clear();
+  this->num_pending_added_ = 0;
+  for (const int pid : this->pids_) {
+    if (this->known_pids_.count(pid) || this->rejected_pids_.count(pid)) {
+      continue;
+    }
+    const auto rejected = this->rejected_.find(pid);
+    if (rejected != this->rejected_.end()) {
+      if (StillRejected(pid, rejected->second)) {
+        continue;
+      }
+      this->rejected_.erase(rejected);
+    }
+    if (!this->filter_.AcceptsPid(pid)) {
+      this->rejected_pids_.insert(pid);
+      continue;
+    }
+    this->pending_pids_.push_back(pid);
+  }
+  this->progress_ = {0, this->pending_pids_.size()};
+}
+
+// Whether no process can have started since the last walk of /proc: every
+// fork, of a process or a thread, counts in the `processes` line of
+// /proc/stat, and /proc/loadavg ends with the last pid handed out. Walks
+// after `kFullScanInterval` regardless, in case a counter misses something,
+// e.g. a pid namespace whose loadavg does not show the host's forks.
+bool LinuxSystem::Quiet() {
+  const long forks = LinuxParser::TotalProcesses(this->stats_file_path_);
+  const long lastPid = LinuxParser::LastPid(this->loadavg_file_path_);
+  const auto now = std::chrono::steady_clock::now();
+  if (forks != 0 && forks == this->forks_ && lastPid == this->last_pid_ &&
+      now - this->last_full_scan_ < kFullScanInterval) {
+    return true;
+  }
+  this->forks_ = forks;
+  this->last_pid_ = lastPid;
+  this->last_full_scan_ = now;
+  return false;
+}
+
+// Whether a rejected pid still runs the same command, judged from the stat
+// file alone, which is far cheaper than reading the status and cmdline again.
+bool LinuxSystem::StillRejected(int pid, const Rejection& rejection) {
+  string comm;
+  long startTime;
+  if (!LinuxParser::ProcessIdentity(filesystem::path(this->procs_dir_path_) /
+                                        to_string(pid) /
+                                        LinuxParser::kProcStatFilePath,
+                                    comm, startTime)) {
+    // Gone, or going; the next scan drops it.
+    this->exited_pids_.push_back(pid);
+    return true;
+  }
+  return comm == rejection.comm && startTime == rejection.start_time;
+}
+
+// The modification time of a file, or 0 if it cannot be read.
+static long ModificationTime(const string& filePath) {
+  std::error_code error;
+  const auto time = filesystem::last_write_time(filePath, error);
+  return error ? 0 : long(time.time_since_epoch().count());
+}
+
+std::unordered_map<std::string, std::string>& LinuxSystem::UserIdMap() {
+  if (!this->uid_map_loaded_) {
+    this->uid_map_ = LinuxParser::UserIdMap(this->passwd_file_path_);
+    this->uid_map_loaded_ = true;
+  }
+  return this->uid_map_;
+}
+
+WarmState LinuxSystem::Capture() {
+  WarmState state;
+  state.boot_id = LinuxParser::BootId(this->procs_dir_path_);
+  state.time = LinuxParser::BootTime();
+  std::tie(state.cpu_active_jiffies, state.cpu_total_jiffies) =
+      this->cpu_.Counters();
+  state.passwd_mtime = ModificationTime(this->passwd_file_path_);
+  state.uid_map = UserIdMap();
+  for (Process& proc : processes_) {
+    state.processes.push_back({proc.Pid(), proc.StartTime(), proc.TotalTicks(),
+                               proc.SampleTime(), string(proc.User()),
+                               string(proc.Command())});
+  }
+  return state;
+}
+
+bool LinuxSystem::Restore(const WarmState& state) {
+  const double age = LinuxParser::BootTime() - state.time;
+  if (state.boot_id.empty() ||
+      state.boot_id != LinuxParser::BootId(this->procs_dir_path_) || age < 0 ||
+      age > WarmStart::kMaxAgeSeconds) {
+    return false;
+  }
+  if (state.cpu_total_jiffies >= 0) {
+    this->cpu_.Restore(state.cpu_active_jiffies, state.cpu_total_jiffies);
+  }
+  if (!this->uid_map_loaded_ &&
+      state.passwd_mtime == ModificationTime(this->passwd_file_path_)) {
+    this->uid_map_ = state.uid_map;
+    this->uid_map_loaded_ = true;
+  }
+  this->warm_processes_.clear();
+  for (const WarmProcess& process : state.processes) {
+    this->warm_processes_.emplace(process.pid, process);
+  }
+  return true;
+}
+
+FdCount LinuxSystem::Fds(int pid) {
+  if (!this->fd_sampler_) {
+    this->fd_sampler_ = std::make_unique<FdSampler>(this->procs_dir_path_);
+    this->fd_sampler_->Start();
+    TickFdSampler();
+  }
+  return this->fd_sampler_->Get(pid);
+}
+
+void LinuxSystem::TickFdSampler() {
+  this->fd_pids_.clear();
+  for (Process& proc : processes_) {
+    this->fd_pids_.push_back(proc.Pid());
+  }
+  this->fd_sampler_->Tick(this->fd_pids_);
+}
+
+RunStates LinuxSystem::States(int pid) {
+  if (!this->state_sampler_) {
+    this->state_sampler_ =
+        std::make_unique<StateSampler>(this->procs_dir_path_);
+    this->state_sampler_->Start();
+    TickStateSampler();
+  }
+  return this->state_sampler_->Get(pid);
+}
+
+// Ends the sampler's interval. The candidates are the processes blocked at
+// their last sample, then the others that are not idle, by CPU, up to the
+// most the sampler takes: a process asleep for long is not worth 50 reads a
+// second, and one that blocks for good is found by its next sample.
+void LinuxSystem::TickStateSampler() {
+  this->state_pids_.clear();
+  for (Process& proc : processes_) {
+    if (proc.Blocked()) {
+      this->state_pids_.push_back(proc.Pid());
+    }
+  }
+  for (Process& proc : processes_) {
+    if (this->state_pids_.size() >= StateSampler::kMaxCandidates) {
+      break;
+    }
+    if (!proc.Blocked() && proc.Tier() != SampleTier::kCold) {
+      this->state_pids_.push_back(proc.Pid());
+    }
+  }
+  this->state_sampler_->Tick(this->state_pids_);
+}
+
+void LinuxSystem::SetFilter(ProcessFilter filter) {
+  this->filter_ = std::move(filter);
+  // Rejections by the previous filter no longer apply, start over.
+  Reset();
+}
+
+void LinuxSystem::SetWatch(WatchTarget target) {
+  this->watch_ = ProcessWatch(this->procs_dir_path_, this->cgroup_root_path_,
+                              std::move(target));
+  Reset();
+}
+
+void LinuxSystem::SetSampleInterval(std::chrono::milliseconds interval) {
+  this->sample_interval_ = interval;
+}
+
+void LinuxSystem::Reset() {
+  this->forks_ = -1;
+  this->processes_.clear();
+  this->hidden_.clear();
+  this->known_pids_.clear();
+  this->rejected_pids_.clear();
+  this->rejected_.clear();
+  this->pending_pids_.clear();
+  this->num_pending_added_ = 0;
+  this->progress_ = ScanProgress();
+  this->tree_ = ProcessTree();
+  this->groups_ = ProcessGroups();
+}
+
+ProcessTree& LinuxSystem::Tree() {
+  for (Process& proc : processes_) {
+    this->tree_.Update(proc);
+  }
+  return this->tree_;
+}
+
+ProcessGroups& LinuxSystem::Groups() {
+  for (Process& proc : processes_) {
+    this->groups_.Update(proc);
+  }
+  return this->groups_;
+}
+
+const std::string& LinuxSystem::Kernel() {
   if (!this->kernelName_.empty()) {
     return this->kernelName_;
   }
@@ -79,7 +509,7 @@ float LinuxSystem::MemoryUtilization() {
   return LinuxParser::MemoryUtilization(this->mem_info_file_path_);
 }
 
-std::string LinuxSystem::OperatingSystem() {
+const std::string& LinuxSystem::OperatingSystem() {
   if (!this->osName_.empty()) {
     return this->osName_;
   }
@@ -87,10 +517,22 @@ std::string LinuxSystem::OperatingSystem() {
   return this->osName_;
 }
 
+vector<CgroupStats>& LinuxSystem::Cgroups() {
+  if (this->watch_.Active()) {
+    this->watch_.List(this->pids_);
+    return this->cgroup_view_.Update(this->pids_);
+  }
+  return this->cgroup_view_.Update(LinuxParser::Pids(this->procs_dir_path_));
+}
+
 int LinuxSystem::RunningProcesses() {
   return LinuxParser::RunningProcesses(this->stats_file_path_);
 }
 
+int LinuxSystem::BlockedProcesses() {
+  return LinuxParser::BlockedProcesses(this->stats_file_path_);
+}
+
 int LinuxSystem::TotalProcesses() {
   return LinuxParser::TotalProcesses(this->stats_file_path_);
 }
@@ -0,0 +1,202 @@
+#include "low_impact.h"
+
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_schema.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+std::runtime_error Error(const string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Touches the stack the monitor may grow into, so that it is mapped when the
+// memory is locked.
+void __attribute__((noinline)) PrefaultStack() {
+  volatile char reserve[LowImpact::kStackReserveBytes];
+  for (std::size_t i = 0; i < sizeof(reserve); i += 4096) {
+    reserve[i] = 0;
+  }
+}
+
+// The resident set, in pages.
+using StatmSchema = ProcSchema::Positional<1>;
+
+double CpuSeconds() {
+  timespec time;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+}  // namespace
+
+/**
+ *  @brief  Parses a CPU list such as "0-1,4".
+ *  @param  list  Comma separated CPUs and inclusive ranges of CPUs.
+ *
+ *  @returns The CPUs in the order listed.
+ *  @throws std::invalid_argument for malformed lists.
+ */
+vector<int> LowImpact::ParseCpuList(const string& list) {
+  vector<int> cpus;
+  std::istringstream items(list);
+  string item;
+  while (std::getline(items, item, ',')) {
+    const std::size_t dash = item.find('-');
+    std::size_t end = 0;
+    int first, last;
+    try {
+      first = std::stoi(item.substr(0, dash), &end);
+      if (end != dash && dash != string::npos) {
+        throw std::invalid_argument(item);
+      }
+      last = first;
+      if (dash != string::npos) {
+        const string rest = item.substr(dash + 1);
+        last = std::stoi(rest, &end);
+        if (end != rest.size()) {
+          throw std::invalid_argument(item);
+        }
+      } else if (end != item.size()) {
+        throw std::invalid_argument(item);
+      }
+    } catch (const std::logic_error&) {
+      throw std::invalid_argument("bad CPU list: " + list);
+    }
+    if (first < 0 || last < first || last >= CPU_SETSIZE) {
+      throw std::invalid_argument("bad CPU list: " + list);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    throw std::invalid_argument("bad CPU list: " + list);
+  }
+  return cpus;
+}
+
+void LowImpact::Pin(const vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    throw Error("could not pin to the CPUs");
+  }
+}
+
+void LowImpact::SetIdle() {
+  const sched_param param{0};
+  if (sched_setscheduler(0, SCHED_IDLE, &param) != 0) {
+    throw Error("could not switch to SCHED_IDLE");
+  }
+}
+
+void LowImpact::SetNice(int nice) {
+  if (setpriority(PRIO_PROCESS, 0, nice) != 0) {
+    throw Error("could not set the nice level");
+  }
+}
+
+/**
+ *  @brief  Locks the memory of the monitor, after faulting in reserves of
+ * heap and stack for it to grow into.
+ *
+ *  Memory mapped later is only locked without a memlock limit, or as root,
+ *  which is not held to it, as allocations beyond the limit would fail
+ *  otherwise.
+ *
+ *  @returns Whether memory mapped later is locked as well.
+ *  @throws std::runtime_error when the current memory cannot be locked.
+ */
+bool LowImpact::LockMemory() {
+  // Freed memory stays in the heap rather than being returned, and large
+  // allocations come from it too, so that the reserve is reused.
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  {
+    const std::unique_ptr<char[]> reserve(new char[kHeapReserveBytes]);
+    for (std::size_t i = 0; i < kHeapReserveBytes; i += 4096) {
+      static_cast<volatile char*>(reserve.get())[i] = 0;
+    }
+  }
+  PrefaultStack();
+  rlimit limit;
+  const bool unlimited = geteuid() == 0 ||
+                         (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+                          limit.rlim_cur == RLIM_INFINITY);
+  if (unlimited && mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+    return true;
+  }
+  if (mlockall(MCL_CURRENT) != 0) {
+    throw Error("could not lock the memory");
+  }
+  return false;
+}
+
+SelfMonitor::SelfMonitor(double budget, string statmPath)
+    : budget_(budget), statm_path_(std::move(statmPath)) {}
+
+bool SelfMonitor::Admit() { return Admit(Clock::now(), CpuSeconds()); }
+
+bool SelfMonitor::Admit(Clock::time_point now, double cpuSeconds) {
+  if (this->started_) {
+    const double elapsed =
+        std::chrono::duration<double>(now - this->last_time_).count();
+    const double used = cpuSeconds - this->last_cpu_seconds_;
+    this->overhead_.cpu_share = elapsed > 0 ? used / elapsed : 0;
+    this->overhead_.cpu_ms = used * 1000;
+    this->credit_seconds_ =
+        std::min(this->credit_seconds_ + this->budget_ * elapsed - used,
+                 this->budget_ * kMaxCredit.count());
+  }
+  this->started_ = true;
+  this->last_time_ = now;
+  this->last_cpu_seconds_ = cpuSeconds;
+  if (this->budget_ > 0 && this->credit_seconds_ < 0) {
+    ++this->overhead_.skipped_ticks;
+    return false;
+  }
+  return true;
+}
+
+SelfMonitor::Overhead SelfMonitor::Report() const {
+  Overhead overhead = this->overhead_;
+  string contents;
+  StatmSchema::Values statm;
+  if (LinuxParser::ReadFile(this->statm_path_, contents) &&
+      StatmSchema::Extract(contents, statm)) {
+    overhead.rss_kb = statm[0] * (sysconf(_SC_PAGESIZE) / 1024);
+  }
+  return overhead;
+}
+
+string SelfMonitor::Describe(const Overhead& overhead) {
+  char line[96];
+  std::snprintf(line, sizeof(line),
+                "Monitor: %.1f%% CPU, %.1f ms/tick, %ld MB RSS, %ld skipped",
+                overhead.cpu_share * 100, overhead.cpu_ms,
+                overhead.rss_kb / 1024, overhead.skipped_ticks);
+  return line;
+}
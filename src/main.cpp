@@ -1,7 +1,171 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "headless_display.h"
+#include "io_monitor.h"
 #include "linux_system.h"
+#include "low_impact.h"
+#include "metrics_server.h"
 #include "ncurses_display.h"
+#include "options.h"
+#include "pressure_monitor.h"
+#include "process_filter.h"
+#include "snapshot.h"
+#include "snapshot_system.h"
+#include "warm_state.h"
+
+namespace {
+volatile std::sig_atomic_t stop_collector = 0;
+
+// Publishes a snapshot every interval until interrupted, removing the shared
+// memory region on the way out.
+void Collect(System& system, const Options& options,
+             CollectionHandler onCollect) {
+  std::signal(SIGINT, [](int) { stop_collector = 1; });
+  std::signal(SIGTERM, [](int) { stop_collector = 1; });
+  SnapshotPublisher publisher(options.snapshot_name);
+  SelfMonitor self(options.cpu_budget / 100.0);
+  while (!stop_collector) {
+    if (!self.Admit()) {
+      std::this_thread::sleep_for(options.interval);
+      continue;
+    }
+    std::vector<Process>& processes = system.Processes();
+    publisher.Publish(system, processes);
+    if (onCollect) {
+      onCollect(system, processes);
+    }
+    std::this_thread::sleep_for(options.interval);
+  }
+}
+// Locks the memory once the system has been set up, as late as possible so
+// that little is allocated past the reserve.
+void LockMemory() {
+  try {
+    if (!LowImpact::LockMemory()) {
+      std::cerr << "--lock-memory: only the memory mapped so far is locked, "
+                   "as RLIMIT_MEMLOCK is limited\n";
+    }
+  } catch (const std::runtime_error& e) {
+    std::cerr << "ignoring --lock-memory: " << e.what() << "\n";
+  }
+}
+}  // namespace
 
-int main() {
-  auto system = LinuxSystem();
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+int main(int argc, char* argv[]) {
+  Options options;
+  ProcessFilter filter;
+  try {
+    options =
+        CommandLine::Parse(std::vector<std::string>(argv + 1, argv + argc));
+    filter = ProcessFilter::Compile(options.filter);
+  } catch (const std::invalid_argument& e) {
+    std::cerr << e.what() << "\n" << CommandLine::Usage();
+    return 1;
+  }
+  // Before any thread starts, so that they all inherit the settings.
+  try {
+    if (!options.cpus.empty()) {
+      LowImpact::Pin(options.cpus);
+    }
+  } catch (const std::runtime_error& e) {
+    std::cerr << "ignoring --cpus: " << e.what() << "\n";
+  }
+  try {
+    if (options.sched_idle) {
+      LowImpact::SetIdle();
+    } else if (options.nice != 0) {
+      LowImpact::SetNice(options.nice);
+    }
+  } catch (const std::runtime_error& e) {
+    std::cerr << "ignoring " << (options.sched_idle ? "--idle" : "--nice")
+              << ": " << e.what() << "\n";
+  }
+  PressureMonitor pressure;
+  for (const std::string& trigger : options.psi_triggers) {
+    try {
+      pressure.AddTrigger(trigger);
+    } catch (const std::invalid_argument& e) {
+      std::cerr << e.what() << "\n" << CommandLine::Usage();
+      return 1;
+    } catch (const std::runtime_error& e) {
+      // Without PSI the monitor simply refreshes on its usual schedule.
+      std::cerr << "ignoring --psi-trigger " << trigger << ": " << e.what()
+                << "\n";
+    }
+  }
+  // The files are only opened by the first update, with --io.
+  IoMonitor io;
+  std::filesystem::path state_path;
+  if (options.warm_start) {
+    state_path = WarmStart::DefaultPath();
+    if (state_path.empty()) {
+      std::cerr << "ignoring --warm-start: XDG_RUNTIME_DIR is not set\n";
+    }
+  }
+  std::unique_ptr<System> system;
+  // The system whose state is saved on exit, if any.
+  LinuxSystem* warm_system{nullptr};
+  std::unique_ptr<MetricsServer> metrics;
+  CollectionHandler onCollect;
+  try {
+    if (options.metrics_port > 0) {
+      metrics = std::make_unique<MetricsServer>(options.metrics_port);
+      onCollect = [&metrics, &options](System& system,
+                                       std::vector<Process>& processes) {
+        // The display has sampled the CPU for this collection already; asking
+        // again within kMinSampleInterval returns that same sample.
+        const float cpu = system.Cpu().Utilization();
+        metrics->Publish(MetricsServer::Render(system, cpu, processes,
+                                               options.num_processes));
+      };
+    }
+    if (options.attach) {
+      system = std::make_unique<SnapshotSystem>(options.snapshot_name);
+    } else {
+      auto linux_system = std::make_unique<LinuxSystem>();
+      linux_system->SetFilter(std::move(filter));
+      if (!options.watch.Empty()) {
+        linux_system->SetWatch(options.watch);
+      }
+      // Values are reused for half a refresh at most, so that every refresh
+      // samples afresh.
+      linux_system->SetSampleInterval(std::min(
+          std::chrono::milliseconds(kUpdateInterval), options.interval / 2));
+      WarmState state;
+      if (!state_path.empty() && WarmStart::Load(state_path, state)) {
+        linux_system->Restore(state);
+      }
+      if (!state_path.empty()) {
+        warm_system = linux_system.get();
+      }
+      system = std::move(linux_system);
+    }
+    if (options.lock_memory) {
+      LockMemory();
+    }
+    if (options.publish) {
+      Collect(*system, options, onCollect);
+    }
+  } catch (const std::runtime_error& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  if (options.headless && !options.publish) {
+    HeadlessDisplay::Display(*system, pressure, io, options, onCollect);
+  } else if (!options.publish) {
+    NCursesDisplay::Display(*system, pressure, io, options, onCollect);
+  }
+  if (warm_system != nullptr &&
+      !WarmStart::Save(warm_system->Capture(), state_path)) {
+    std::cerr << "could not save the state to " << state_path << "\n";
+  }
+}
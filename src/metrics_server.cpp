@@ -0,0 +1,254 @@
+#include "metrics_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "process.h"
+
+using std::string;
+
+const string kContentType{
+    "application/openmetrics-text; version=1.0.0; charset=utf-8"};
+const string kMetricsPath{"/metrics"};
+// How long a client may take to send its whole request, and to take each
+// part of the response.
+const std::chrono::milliseconds kRequestTimeout(1000);
+
+// Escapes a label value as required by the exposition format.
+static string LabelValue(std::string_view value) {
+  string escaped;
+  for (const char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+static string Response(const string& status, const string& contentType,
+                       const string& body) {
+  return "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+         "\r\nContent-Length: " + std::to_string(body.size()) +
+         "\r\nConnection: close\r\n\r\n" + body;
+}
+
+MetricsServer::MetricsServer(int port) {
+  this->listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (this->listen_fd_ < 0) {
+    throw std::runtime_error("could not create the metrics socket");
+  }
+  const int reuse = 1;
+  setsockopt(this->listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse,
+             sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  if (bind(this->listen_fd_, reinterpret_cast<sockaddr*>(&address), length) !=
+          0 ||
+      listen(this->listen_fd_, 16) != 0 ||
+      getsockname(this->listen_fd_, reinterpret_cast<sockaddr*>(&address),
+                  &length) != 0) {
+    const string error = std::strerror(errno);
+    close(this->listen_fd_);
+    throw std::runtime_error("could not listen on 127.0.0.1:" +
+                             std::to_string(port) + ": " + error);
+  }
+  this->port_ = ntohs(address.sin_port);
+  this->stop_fd_ = eventfd(0, EFD_CLOEXEC);
+  this->response_ = std::make_shared<const string>(
+      Response("503 Service Unavailable", "text/plain", "no data yet\n"));
+  // The thread inherits a mask blocking every signal, so signals meant for the
+  // process, e.g. SIGTERM, reach the display's handlers or signalfd instead.
+  sigset_t all;
+  sigset_t previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+  this->thread_ = std::thread(&MetricsServer::Serve, this);
+  pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+MetricsServer::~MetricsServer() {
+  const uint64_t one = 1;
+  if (write(this->stop_fd_, &one, sizeof(one)) == sizeof(one)) {
+    this->thread_.join();
+  } else {
+    this->thread_.detach();
+  }
+  close(this->stop_fd_);
+  close(this->listen_fd_);
+}
+
+int MetricsServer::Port() const { return this->port_; }
+
+void MetricsServer::Publish(const string& body) {
+  auto response =
+      std::make_shared<const string>(Response("200 OK", kContentType, body));
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->response_ = std::move(response);
+}
+
+/**
+ *  @brief  Renders the system metrics and the metrics of the top processes.
+ *  @param  system  The system the processes were collected from.
+ *  @param  cpuUtilization  The CPU utilization sampled for this collection.
+ *  @param  processes  The processes of the current collection, sorted by CPU
+ * utilization in descending order.
+ *  @param  k  The number of processes to include.
+ *
+ *  @returns The metrics in the OpenMetrics text format.
+ */
+string MetricsServer::Render(System& system, float cpuUtilization,
+                             std::vector<Process>& processes, int k) {
+  std::ostringstream out;
+  out << "# TYPE monitor_cpu_utilization gauge\n"
+      << "# HELP monitor_cpu_utilization Share of CPU time spent busy.\n"
+      << "monitor_cpu_utilization " << cpuUtilization << "\n"
+      << "# TYPE monitor_memory_utilization gauge\n"
+      << "# HELP monitor_memory_utilization Share of memory in use.\n"
+      << "monitor_memory_utilization " << system.MemoryUtilization() << "\n"
+      << "# TYPE monitor_uptime_seconds gauge\n"
+      << "# UNIT monitor_uptime_seconds seconds\n"
+      << "monitor_uptime_seconds " << system.UpTime() << "\n"
+      << "# TYPE monitor_processes_created counter\n"
+      << "# HELP monitor_processes_created Processes created since boot.\n"
+      << "monitor_processes_created_total " << system.TotalProcesses() << "\n"
+      << "# TYPE monitor_processes_running gauge\n"
+      << "monitor_processes_running " << system.RunningProcesses() << "\n"
+      << "# TYPE monitor_processes_blocked gauge\n"
+      << "# HELP monitor_processes_blocked Tasks blocked waiting for I/O.\n"
+      << "monitor_processes_blocked " << system.BlockedProcesses() << "\n";
+  const int n = int(processes.size()) > k ? k : processes.size();
+  std::vector<string> labels;
+  for (int i = 0; i < n; ++i) {
+    labels.push_back("{pid=\"" + std::to_string(processes[i].Pid()) +
+                     "\",user=\"" + LabelValue(processes[i].User()) +
+                     "\",command=\"" + LabelValue(processes[i].Command()) +
+                     "\"}");
+  }
+  out << "# TYPE monitor_process_cpu_utilization gauge\n"
+      << "# HELP monitor_process_cpu_utilization Share of a CPU used by the "
+         "process.\n";
+  for (int i = 0; i < n; ++i) {
+    out << "monitor_process_cpu_utilization" << labels[i] << " "
+        << processes[i].CpuUtilization() << "\n";
+  }
+  out << "# TYPE monitor_process_virtual_memory_bytes gauge\n"
+      << "# UNIT monitor_process_virtual_memory_bytes bytes\n";
+  for (int i = 0; i < n; ++i) {
+    out << "monitor_process_virtual_memory_bytes" << labels[i] << " "
+        << processes[i].VirtualMemoryKb() * 1024 << "\n";
+  }
+  out << "# TYPE monitor_process_uptime_seconds gauge\n"
+      << "# UNIT monitor_process_uptime_seconds seconds\n";
+  for (int i = 0; i < n; ++i) {
+    out << "monitor_process_uptime_seconds" << labels[i] << " "
+        << processes[i].UpTime() << "\n";
+  }
+  out << "# EOF\n";
+  return out.str();
+}
+
+// Accepts and answers connections one at a time until the server is
+// destroyed.
+void MetricsServer::Serve() {
+  pollfd fds[2] = {{this->listen_fd_, POLLIN, 0}, {this->stop_fd_, POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    if (fds[1].revents) {
+      return;
+    }
+    const int client =
+        accept4(this->listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client >= 0) {
+      // A client that stops reading cannot hold up the other scrapes.
+      const auto seconds =
+          std::chrono::duration_cast<std::chrono::seconds>(kRequestTimeout);
+      const timeval timeout{
+          seconds.count(),
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              kRequestTimeout - seconds)
+              .count()};
+      setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      Respond(client);
+      close(client);
+    }
+  }
+}
+
+void MetricsServer::Respond(int client) {
+  char request[4096];
+  size_t received = 0;
+  // Wait for the end of the request headers, for one timeout in all so that
+  // a client trickling bytes cannot keep the only serving thread.
+  const auto deadline = std::chrono::steady_clock::now() + kRequestTimeout;
+  while (received < sizeof(request) - 1) {
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+    pollfd fd{client, POLLIN, 0};
+    if (remaining.count() <= 0 || poll(&fd, 1, remaining.count()) <= 0) {
+      return;
+    }
+    const ssize_t count =
+        read(client, request + received, sizeof(request) - 1 - received);
+    if (count <= 0) {
+      return;
+    }
+    received += count;
+    request[received] = '\0';
+    if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n")) {
+      break;
+    }
+  }
+  std::shared_ptr<const string> response;
+  const string line(request, std::strcspn(request, "\r\n"));
+  std::istringstream linestream(line);
+  string method, target;
+  linestream >> method >> target;
+  if (method == "GET" &&
+      target.substr(0, target.find('?')) == kMetricsPath) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    response = this->response_;
+  } else {
+    response = std::make_shared<const string>(
+        Response("404 Not Found", "text/plain", "not found\n"));
+  }
+  size_t sent = 0;
+  while (sent < response->size()) {
+    const ssize_t count = send(client, response->data() + sent,
+                               response->size() - sent, MSG_NOSIGNAL);
+    if (count <= 0) {
+      return;
+    }
+    sent += count;
+  }
+}
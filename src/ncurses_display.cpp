@@ -1,112 +1,759 @@
 #include "ncurses_display.h"
 
 #include <curses.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <clocale>
+#include <csignal>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
 #include <string>
-#include <thread>
+#include <unordered_set>
 #include <vector>
 
+#include "event_loop.h"
 #include "format.h"
+#include "process_filter.h"
+#include "process_sort.h"
 #include "system.h"
 
 using std::string;
 using std::to_string;
 
+namespace {
+// Leaves this many columns for the command before showing sparklines in the
+// process rows.
+const int kMinCommandWidth = 40;
+
+SeriesKey SystemKey(SeriesKey::Metric metric) { return {0, 0, metric}; }
+
+SeriesKey ProcessKey(Process& process, SeriesKey::Metric metric) {
+  return {process.Pid(), process.StartTime(), metric};
+}
+
+// Draws the sparkline of a series over the history window, at most `width`
+// columns wide and scaled to at least `max`.
+void DrawSparkline(WINDOW* window, int row, int column, int width,
+                   const History& history, const SeriesKey& key, float max) {
+  width = std::min(width, window->_maxx - column);
+  if (width <= 0) {
+    return;
+  }
+  const std::vector<float> values =
+      history.Resample(key, History::Clock::now(), width);
+  for (const float value : values) {
+    // NaN compares false, so spans without points are skipped.
+    max = value > max ? value : max;
+  }
+  mvwprintw(window, row, column, "%s",
+            Format::Sparkline(values, max).c_str());
+}
+
+// The first four characters of a percentage, e.g. "12.3" or "0.00".
+void PrintPercent(WINDOW* window, int row, int column, float percent) {
+  char text[64];
+  std::snprintf(text, sizeof(text), "%f", percent);
+  mvwprintw(window, row, column, "%.4s", text);
+}
+}  // namespace
+
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
-  int size{50};
-  float bars{percent * size};
-
+void NCursesDisplay::ProgressBar(WINDOW* window, float percent) {
+  const int size{50};
+  const float bars{percent * size};
+  char result[size + 1];
   for (int i{0}; i < size; ++i) {
-    result += i <= bars ? '|' : ' ';
+    result[i] = i <= bars ? '|' : ' ';
   }
-
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+  result[size] = '\0';
+  // Four characters of the percentage, or three after a space.
+  char display[64];
+  std::snprintf(display, sizeof(display), "%f", percent * 100);
+  const bool narrow = percent < 0.1 || percent == 1.0;
+  wprintw(window, "0%%%s %s%.*s/100%%", result, narrow ? " " : "",
+          narrow ? 3 : 4, display);
 }
 
-void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
+void NCursesDisplay::DisplaySystem(System& system, WINDOW* window,
+                                   const History* history) {
+  // The bars end before this column.
+  int const sparkline_column{74};
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
+  mvwprintw(window, ++row, 2, "OS: %s", system.OperatingSystem().c_str());
+  mvwprintw(window, ++row, 2, "Kernel: %s", system.Kernel().c_str());
   mvwprintw(window, ++row, 2, "CPU: ");
   wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
+  wmove(window, row, 10);
+  ProgressBar(window, system.Cpu().Utilization());
   wattroff(window, COLOR_PAIR(1));
+  if (history != nullptr) {
+    DrawSparkline(window, row, sparkline_column, kSystemSparklineWidth,
+                  *history, SystemKey(SeriesKey::Metric::kCpu), 1);
+  }
   mvwprintw(window, ++row, 2, "Memory: ");
   wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
+  wmove(window, row, 10);
+  ProgressBar(window, system.MemoryUtilization());
   wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
+  if (history != nullptr) {
+    DrawSparkline(window, row, sparkline_column, kSystemSparklineWidth,
+                  *history, SystemKey(SeriesKey::Metric::kMemory), 1);
+  }
+  mvwprintw(window, ++row, 2, "Total Processes: %d", system.TotalProcesses());
+  mvwprintw(window, ++row, 2, "Running Processes: %d  Blocked: %d",
+            system.RunningProcesses(), system.BlockedProcesses());
+  mvwprintw(window, ++row, 2, "Up Time: %s",
+            Format::ElapsedTime(system.UpTime()).c_str());
   wrefresh(window);
 }
 
+void NCursesDisplay::DisplayOverhead(const SelfMonitor::Overhead& overhead,
+                                     WINDOW* window, int row) {
+  mvwprintw(window, row, 2, "%s", SelfMonitor::Describe(overhead).c_str());
+}
+
+void NCursesDisplay::DisplayPressure(std::vector<PressureStats>& pressure,
+                                     PressureMonitor& monitor, WINDOW* window,
+                                     int row) {
+  char line[128];
+  for (const PressureStats& stats : pressure) {
+    int length = std::snprintf(
+        line, sizeof(line), "%-7s some %6.2f%% %6.2f%% +%lldms", stats.resource.c_str(),
+        stats.some.avg10, stats.some.avg60, stats.some.delta_us / 1000);
+    if (stats.has_full) {
+      std::snprintf(line + length, sizeof(line) - length,
+                    "  full %6.2f%% %6.2f%% +%lldms", stats.full.avg10,
+                    stats.full.avg60, stats.full.delta_us / 1000);
+    }
+    mvwprintw(window, ++row, 2, "Pressure: ");
+    mvwprintw(window, row, 12, "%s", line);
+  }
+  if (monitor.NumTriggers() > 0) {
+    mvwprintw(window, ++row, 2, "PSI triggers fired: %ld", monitor.Events());
+  }
+}
+
+void NCursesDisplay::DisplayIo(const IoStats& io, WINDOW* window, int row,
+                               int rows) {
+  // Lines are cut at the border of the window rather than wrapped.
+  const int width = std::max(0, window->_maxx - 13);
+  const int last = row + rows;
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "faults %.0f/s  major %.0f/s  swap %.0f/%.0f/s  scan %.0f/s  "
+                "steal %.0f/s",
+                io.vm.faults, io.vm.major_faults, io.vm.swap_in,
+                io.vm.swap_out, io.vm.scanned, io.vm.stolen);
+  mvwprintw(window, ++row, 2, "Paging: ");
+  mvwprintw(window, row, 12, "%.*s", width, line);
+  for (std::size_t i = 0;
+       i < io.disks.size() && int(i) < kIoDeviceRows && row < last; ++i) {
+    const DiskRates& disk = io.disks[i];
+    std::snprintf(line, sizeof(line),
+                  "%-10.10s r %5.0f/s %6.1fMB/s  w %5.0f/s %6.1fMB/s  "
+                  "%3.0f%% %6.2fms",
+                  disk.name.c_str(), disk.reads, disk.read_bytes / 1e6,
+                  disk.writes, disk.write_bytes / 1e6,
+                  disk.utilization * 100, disk.await_ms);
+    mvwprintw(window, ++row, 2, "Disk: ");
+    mvwprintw(window, row, 12, "%.*s", width, line);
+  }
+  for (std::size_t i = 0; i < io.interfaces.size() &&
+                          int(i) < kIoDeviceRows && row < last;
+       ++i) {
+    const NetRates& interface = io.interfaces[i];
+    std::snprintf(line, sizeof(line),
+                  "%-10.10s rx %6.1fMB/s %6.0fp/s  tx %6.1fMB/s %6.0fp/s  "
+                  "drop %.0f/s",
+                  interface.name.c_str(), interface.rx_bytes / 1e6,
+                  interface.rx_packets, interface.tx_bytes / 1e6,
+                  interface.tx_packets,
+                  interface.rx_drops + interface.tx_drops);
+    mvwprintw(window, ++row, 2, "Net: ");
+    mvwprintw(window, row, 12, "%.*s", width, line);
+  }
+}
+
 void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+                                      WINDOW* window, int n, bool sched,
+                                      bool fds, bool blocked,
+                                      const History* history) {
   int row{0};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
   int const ram_column{26};
   int const time_column{35};
-  int const command_column{46};
+  int const latency_column{46};
+  int const wait_column{54};
+  int const switches_column{62};
+  int const involuntary_column{70};
+  int const fds_column{sched ? 78 : 46};
+  int const fd_age_column{fds_column + 8};
+  int const blocked_column{fds ? fd_age_column + 7 : fds_column};
+  int const cpu_history_column{blocked ? blocked_column + 8 : blocked_column};
+  int const ram_history_column{cpu_history_column + kRowSparklineWidth + 1};
+  bool const show_history{history != nullptr &&
+                          window->_maxx - ram_history_column -
+                                  kRowSparklineWidth - 1 >=
+                              kMinCommandWidth};
+  int const command_column{show_history
+                               ? ram_history_column + kRowSparklineWidth + 1
+                               : cpu_history_column};
   wattron(window, COLOR_PAIR(2));
   mvwprintw(window, ++row, pid_column, "PID");
   mvwprintw(window, row, user_column, "USER");
   mvwprintw(window, row, cpu_column, "CPU[%%]");
   mvwprintw(window, row, ram_column, "RAM[MB]");
   mvwprintw(window, row, time_column, "TIME+");
+  if (sched) {
+    mvwprintw(window, row, latency_column, "LAT[ms]");
+    mvwprintw(window, row, wait_column, "WAIT[%%]");
+    mvwprintw(window, row, switches_column, "CSW/s");
+    mvwprintw(window, row, involuntary_column, "ICSW/s");
+  }
+  if (fds) {
+    mvwprintw(window, row, fds_column, "FDS");
+    mvwprintw(window, row, fd_age_column, "AGE");
+  }
+  if (blocked) {
+    mvwprintw(window, row, blocked_column, "BLK[%%]");
+  }
+  if (show_history) {
+    const long long minutes = kHistoryWindow.count() / 60;
+    mvwprintw(window, row, cpu_history_column, "CPU %lldm", minutes);
+    mvwprintw(window, row, ram_history_column, "RAM %lldm", minutes);
+  }
   mvwprintw(window, row, command_column, "COMMAND");
   wattroff(window, COLOR_PAIR(2));
   int const num_processes = int(processes.size()) > n ? n : processes.size();
   for (int i = 0; i < num_processes; ++i) {
-    mvwprintw(window, ++row, pid_column, to_string(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
+    mvwprintw(window, ++row, pid_column, "%d", processes[i].Pid());
+    mvwprintw(window, row, user_column, "%s", processes[i].User().data());
+    PrintPercent(window, row, cpu_column, processes[i].CpuUtilization() * 100);
+    mvwprintw(window, row, ram_column, "%s", processes[i].Ram().c_str());
+    mvwprintw(window, row, time_column, "%s",
               Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
+    if (sched) {
+      const SchedRates rates = processes[i].Sched();
+      mvwprintw(window, row, latency_column, "%.2f", rates.latency * 1000);
+      mvwprintw(window, row, wait_column, "%.1f", rates.wait * 100);
+      mvwprintw(window, row, switches_column, "%.0f",
+                rates.voluntary_switches);
+      mvwprintw(window, row, involuntary_column, "%.0f",
+                rates.involuntary_switches);
+    }
+    if (fds) {
+      const FdCount count = processes[i].Fds();
+      if (count.Known()) {
+        mvwprintw(window, row, fds_column, "%ld", count.count);
+        mvwprintw(window, row, fd_age_column, "%llds",
+                  static_cast<long long>(
+                      std::chrono::duration_cast<std::chrono::seconds>(
+                          FdCount::Clock::now() - count.time)
+                          .count()));
+      } else {
+        mvwprintw(window, row, fds_column, "-");
+        mvwprintw(window, row, fd_age_column, "-");
+      }
+    }
+    if (blocked) {
+      const float share = processes[i].States().BlockedShare();
+      if (share < 0) {
+        mvwprintw(window, row, blocked_column, "-");
+      } else {
+        mvwprintw(window, row, blocked_column, "%.0f", share * 100);
+      }
+    }
+    if (show_history) {
+      DrawSparkline(window, row, cpu_history_column, kRowSparklineWidth,
+                    *history, ProcessKey(processes[i], SeriesKey::Metric::kCpu),
+                    1);
+      DrawSparkline(window, row, ram_history_column, kRowSparklineWidth,
+                    *history,
+                    ProcessKey(processes[i], SeriesKey::Metric::kMemory), 0);
+    }
+    const std::string_view command = processes[i].Command().substr(
+        0, std::max(window->_maxx - command_column, 0));
+    mvwprintw(window, row, command_column, "%.*s", int(command.size()),
+              command.empty() ? "" : command.data());
+  }
+}
+
+void NCursesDisplay::Record(System& system, std::vector<Process>* processes,
+                            int n, History& history) {
+  const History::Clock::time_point now = History::Clock::now();
+  history.Add(SystemKey(SeriesKey::Metric::kCpu), now,
+              system.Cpu().Utilization());
+  history.Add(SystemKey(SeriesKey::Metric::kMemory), now,
+              system.MemoryUtilization());
+  if (processes == nullptr) {
+    return;
+  }
+  int const num_processes = int(processes->size()) > n ? n : processes->size();
+  for (int i = 0; i < num_processes; ++i) {
+    Process& process = (*processes)[i];
+    history.Add(ProcessKey(process, SeriesKey::Metric::kCpu), now,
+                process.CpuUtilization());
+    history.Add(ProcessKey(process, SeriesKey::Metric::kMemory), now,
+                process.VirtualMemoryKb());
+  }
+  // Exited processes take their history with them.
+  std::unordered_set<int> pids;
+  for (Process& process : *processes) {
+    pids.insert(process.Pid());
+  }
+  history.Retain(pids, now);
+}
+
+// Like `DisplayProcesses`, but indents each command under its parent and shows
+// the CPU and memory totals of each subtree.
+void NCursesDisplay::DisplayTree(std::vector<ProcessTree::Row>& rows,
+                                 WINDOW* window, int selected) {
+  int row{0};
+  int const pid_column{2};
+  int const user_column{9};
+  int const cpu_column{16};
+  int const ram_column{26};
+  int const time_column{35};
+  int const command_column{46};
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, pid_column, "PID");
+  mvwprintw(window, row, user_column, "USER");
+  mvwprintw(window, row, cpu_column, "CPU[%%]");
+  mvwprintw(window, row, ram_column, "RAM[MB]");
+  mvwprintw(window, row, time_column, "TIME+");
+  mvwprintw(window, row, command_column, "COMMAND");
+  wattroff(window, COLOR_PAIR(2));
+  for (auto& tree_row : rows) {
+    Process& process = *tree_row.process;
+    if (tree_row.pid == selected) {
+      wattron(window, A_REVERSE);
+    }
+    mvwprintw(window, ++row, pid_column, "%d", process.Pid());
+    mvwprintw(window, row, user_column, "%s", process.User().data());
+    PrintPercent(window, row, cpu_column, tree_row.cpu_utilization * 100);
+    mvwprintw(window, row, ram_column, "%ld", tree_row.memory_kb / 1000);
+    mvwprintw(window, row, time_column, "%s",
+              Format::ElapsedTime(process.UpTime()).c_str());
+    // The indent, the mark of a collapsed parent, then the command, cut at
+    // the border of the window.
+    const int width = std::max(window->_maxx - command_column, 0);
+    const int indent = std::min(2 * tree_row.depth, width);
+    const std::string_view mark =
+        tree_row.collapsed && tree_row.num_children ? "+ " : "";
+    const int mark_width = std::min(int(mark.size()), width - indent);
+    const std::string_view command =
+        process.Command().substr(0, width - indent - mark_width);
+    mvwprintw(window, row, command_column, "%*s%.*s%.*s", indent, "",
+              mark_width, mark.data(), int(command.size()),
+              command.empty() ? "" : command.data());
+    wattroff(window, A_REVERSE);
+  }
+}
+
+void NCursesDisplay::DisplayCgroups(std::vector<CgroupStats>& cgroups,
+                                    WINDOW* window, int n) {
+  int row{0};
+  int const cpu_column{2};
+  int const limit_column{10};
+  int const ram_column{18};
+  int const procs_column{27};
+  int const cgroup_column{34};
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, cpu_column, "CPU[%%]");
+  mvwprintw(window, row, limit_column, "LIMIT");
+  mvwprintw(window, row, ram_column, "RAM[MB]");
+  mvwprintw(window, row, procs_column, "PROCS");
+  mvwprintw(window, row, cgroup_column, "CGROUP");
+  wattroff(window, COLOR_PAIR(2));
+  int const num_cgroups = int(cgroups.size()) > n ? n : cgroups.size();
+  for (int i = 0; i < num_cgroups; ++i) {
+    PrintPercent(window, ++row, cpu_column, cgroups[i].cpu_utilization * 100);
+    if (cgroups[i].cpu_limit > 0) {
+      PrintPercent(window, row, limit_column, cgroups[i].cpu_limit);
+    } else {
+      mvwprintw(window, row, limit_column, "max");
+    }
+    mvwprintw(window, row, ram_column, "%ld",
+              cgroups[i].memory_bytes / 1000000);
+    mvwprintw(window, row, procs_column, "%d", cgroups[i].num_processes);
+    mvwprintw(window, row, cgroup_column, "%.*s",
+              std::max(window->_maxx - cgroup_column, 0),
+              cgroups[i].path.c_str());
   }
 }
 
-void NCursesDisplay::Display(System& system, int n) {
+// Like `DisplayCgroups`, with the totals of a user or command per row.
+void NCursesDisplay::DisplayGroups(std::vector<ProcessGroups::Row>& rows,
+                                   WINDOW* window, GroupBy by) {
+  int row{0};
+  int const cpu_column{2};
+  int const ram_column{10};
+  int const procs_column{19};
+  int const name_column{26};
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, cpu_column, "CPU[%%]");
+  mvwprintw(window, row, ram_column, "RAM[MB]");
+  mvwprintw(window, row, procs_column, "PROCS");
+  mvwprintw(window, row, name_column,
+            by == GroupBy::kUser ? "USER" : "COMMAND");
+  wattroff(window, COLOR_PAIR(2));
+  for (const ProcessGroups::Row& group : rows) {
+    PrintPercent(window, ++row, cpu_column, group.cpu_utilization * 100);
+    mvwprintw(window, row, ram_column, "%ld", group.memory_kb / 1000);
+    mvwprintw(window, row, procs_column, "%d", group.num_processes);
+    const std::string_view name = group.name.empty() ? "-" : group.name;
+    mvwprintw(window, row, name_column, "%.*s",
+              std::min(int(name.size()),
+                       std::max(window->_maxx - name_column, 0)),
+              name.data());
+  }
+}
+
+string NCursesDisplay::StatusLine(bool paused, SortKey sortKey,
+                                  std::chrono::milliseconds interval,
+                                  ScanProgress progress, GroupBy groupBy) {
+  string status = string(" q quit  p ") + (paused ? "resume" : "pause") +
+                  "  s sort:" + ProcessSort::Name(sortKey) +
+                  "  u by:" + ProcessGroups::Name(groupBy) +
+                  "  / filter  t tree  g cgroups  l sched  f fds  b blocked"
+                  "  h history  +/- " +
+                  to_string(interval.count()) + "ms ";
+  if (!progress.Done()) {
+    status += " scanning " + to_string(progress.scanned) + "/" +
+              to_string(progress.total) + " ";
+  }
+  return status;
+}
+
+void NCursesDisplay::Display(System& system, PressureMonitor& pressure,
+                             IoMonitor& io, const Options& options,
+                             CollectionHandler onCollect) {
+  int const n = options.num_processes;
+  setlocale(LC_ALL, "");  // draw the UTF-8 sparklines
   initscr();      // start ncurses
   noecho();       // do not print input values
-  cbreak();       // terminate ncurses on ctrl + c
+  cbreak();       // deliver ctrl + c as SIGINT, handled by the loop
   start_color();  // enable color
+  keypad(stdscr, TRUE);
+  nodelay(stdscr, TRUE);  // getch() returns ERR once the input is drained
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
 
-  int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
+  // One row per PSI resource, plus the trigger count when watching any.
+  int const pressure_rows =
+      pressure.Update().size() + (pressure.NumTriggers() > 0 ? 1 : 0);
+  // The paging rates and the devices found at start, below the pressure.
+  int io_rows{0};
+  if (options.show_io) {
+    const IoStats& stats = io.Update();
+    io_rows = 1 + std::min<int>(stats.disks.size(), kIoDeviceRows) +
+              std::min<int>(stats.interfaces.size(), kIoDeviceRows);
+  }
+  WINDOW* system_window{nullptr};
+  WINDOW* process_window{nullptr};
+  auto layout = [&]() {
+    if (system_window != nullptr) {
+      delwin(system_window);
+      delwin(process_window);
+    }
+    int x_max{getmaxx(stdscr)};
+    system_window = newwin(10 + pressure_rows + io_rows, x_max - 1, 0, 0);
+    process_window = newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
+  };
+  layout();
+
+  EventLoop loop;
+  bool show_cgroups{options.show_cgroups};
+  bool show_tree{options.show_tree};
+  GroupBy group_by{options.group_by};
+  bool show_sched{options.show_sched};
+  bool show_fds{options.show_fds};
+  bool show_blocked{options.show_blocked};
+  bool show_history{true};
+  History history;
+  SelfMonitor self(options.cpu_budget / 100.0);
+  bool paused{false};
+  // The pid of the tree row that the arrow keys move and Enter collapses.
+  int selected{-1};
+  SortKey sort_key{SortKey::kCpu};
+  string filter{options.filter};
+  // The filter being typed, while the prompt is open.
+  bool prompting{false};
+  string prompt;
+  // A transient message, e.g. a filter error, shown instead of the keys.
+  string message;
+  // The most recent collection, redrawn as is while paused.
+  std::vector<Process>* processes{nullptr};
+  std::vector<ProcessTree::Row>* rows{nullptr};
+  std::vector<CgroupStats>* cgroups{nullptr};
+  std::vector<ProcessGroups::Row>* groups{nullptr};
+
+  // Whether a deferred slice of the process scan is queued.
+  bool scanning{false};
 
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  // The system panel only reads the global files, so it is shown before the
+  // process scan starts.
+  auto drawSystem = [&]() {
+    werase(system_window);
     box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
+    DisplaySystem(system, system_window, &history);
+    DisplayOverhead(self.Report(), system_window, 8);
+    DisplayPressure(pressure.Update(), pressure, system_window, 8);
+    if (io_rows > 0) {
+      DisplayIo(io.Update(), system_window, 8 + pressure_rows, io_rows);
+    }
+    refresh();
     wrefresh(system_window);
+  };
+  std::function<void(bool)> drawProcesses = [&](bool collect) {
+    bool collected{false};
+    if (collect) {
+      // The cgroup view does not need the processes unless someone else
+      // does.
+      if (show_cgroups && !onCollect) {
+        processes = nullptr;
+      } else {
+        // A large /proc is walked in slices, showing what was found so far.
+        processes = &system.Processes(std::chrono::steady_clock::now() +
+                                      kScanSlice);
+        collected = true;
+        if (onCollect && system.Progress().Done()) {
+          onCollect(system, *processes);
+        }
+      }
+      // Records whole scans only, while the collection is ordered by CPU.
+      if (system.Progress().Done()) {
+        Record(system, processes, n, history);
+      }
+      rows = nullptr;
+      cgroups = nullptr;
+      groups = nullptr;
+      if (show_cgroups) {
+        cgroups = &system.Cgroups();
+      } else if (show_tree) {
+        rows = &system.Tree().Rows(n);
+        // Keeps the selection on a shown row, e.g. after its process exits.
+        selected = ProcessTree::Neighbor(*rows, selected, 0);
+      } else if (group_by != GroupBy::kProcess) {
+        groups = &system.Groups().Rows(group_by, n);
+      } else if (sort_key != SortKey::kCpu) {
+        // The collection is ordered by CPU; other keys only order the rows
+        // that are drawn.
+        ProcessSort::Top(*processes, sort_key, n);
+      }
+    }
+    const ScanProgress progress = system.Progress();
+    if (collected && !progress.Done() && !scanning) {
+      scanning = true;
+      loop.Defer([&]() {
+        scanning = false;
+        if (!paused) {
+          drawProcesses(true);
+        }
+      });
+    }
+    werase(process_window);
+    box(process_window, 0, 0);
+    if (cgroups != nullptr) {
+      DisplayCgroups(*cgroups, process_window, n);
+    } else if (rows != nullptr) {
+      DisplayTree(*rows, process_window, selected);
+    } else if (groups != nullptr) {
+      DisplayGroups(*groups, process_window, group_by);
+    } else if (processes != nullptr) {
+      DisplayProcesses(*processes, process_window, n, show_sched, show_fds,
+                       show_blocked, show_history ? &history : nullptr);
+    }
+    string status =
+        prompting ? " filter: " + prompt + "_ "
+        : message.empty()
+            ? StatusLine(paused, sort_key, loop.Interval(), progress,
+                         group_by)
+            : " " + message + " ";
+    mvwprintw(process_window, process_window->_maxy, 2, "%s",
+              status.substr(0, process_window->_maxx - 3).c_str());
     wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  };
+  auto draw = [&](bool collect) {
+    drawSystem();
+    drawProcesses(collect);
+  };
+  auto tick = [&]() {
+    // Past the CPU budget, the tick is skipped rather than the loop slowed
+    // down, so the keys stay responsive.
+    if (!paused && self.Admit()) {
+      draw(true);
+    }
+  };
+
+  auto onPrompt = [&](int key) {
+    if (key == '\n' || key == KEY_ENTER) {
+      prompting = false;
+      try {
+        system.SetFilter(ProcessFilter::Compile(prompt));
+        filter = prompt;
+      } catch (const std::invalid_argument& e) {
+        message = e.what();
+      }
+      draw(true);
+      return;
+    }
+    if (key == 27) {  // escape
+      prompting = false;
+    } else if (key == KEY_BACKSPACE || key == 127 || key == '\b') {
+      if (!prompt.empty()) {
+        prompt.pop_back();
+      }
+    } else if (key >= ' ' && key < 127) {
+      prompt += char(key);
+    }
+    draw(false);
+  };
+  auto onKey = [&](int key) {
+    if (prompting) {
+      onPrompt(key);
+      return;
+    }
+    message.clear();
+    switch (key) {
+      case 'q':
+      case 'Q':
+        loop.Stop();
+        return;
+      case 'p':
+        paused = !paused;
+        break;
+      case 's':
+        sort_key = ProcessSort::Next(sort_key);
+        if (processes != nullptr && rows == nullptr && cgroups == nullptr &&
+            groups == nullptr) {
+          ProcessSort::Top(*processes, sort_key, n);
+        }
+        break;
+      case 'l':
+        show_sched = !show_sched;
+        break;
+      case 'f':
+        show_fds = !show_fds;
+        break;
+      case 'b':
+        show_blocked = !show_blocked;
+        break;
+      case 'h':
+        show_history = !show_history;
+        break;
+      case '/':
+        prompting = true;
+        prompt = filter;
+        break;
+      case 't':
+        show_tree = !show_tree;
+        show_cgroups = false;
+        draw(true);
+        return;
+      case 'g':
+        show_cgroups = !show_cgroups;
+        draw(true);
+        return;
+      case 'u':
+        // Both groupings are kept up to date, so switching does not collect
+        // again.
+        group_by = ProcessGroups::Next(group_by);
+        show_tree = false;
+        show_cgroups = false;
+        if (processes == nullptr) {
+          // Left the cgroup view, which did not collect the processes.
+          draw(true);
+          return;
+        }
+        rows = nullptr;
+        cgroups = nullptr;
+        groups = nullptr;
+        if (group_by != GroupBy::kProcess) {
+          groups = &system.Groups().Rows(group_by, n);
+        } else if (sort_key != SortKey::kCpu) {
+          ProcessSort::Top(*processes, sort_key, n);
+        }
+        break;
+      case KEY_UP:
+      case KEY_DOWN:
+        if (rows == nullptr) {
+          return;
+        }
+        selected = ProcessTree::Neighbor(*rows, selected,
+                                         key == KEY_UP ? -1 : 1);
+        break;
+      case ' ':
+      case '\n':
+      case KEY_ENTER:
+        if (rows == nullptr) {
+          return;
+        }
+        system.Tree().ToggleCollapsed(selected);
+        rows = &system.Tree().Rows(n);
+        break;
+      case '+':
+        // An --interval below the minimum can be returned to.
+        loop.SetTimer(std::max(loop.Interval() / 2,
+                               std::min(kMinRefreshInterval, options.interval)),
+                      tick);
+        break;
+      case '-':
+        loop.SetTimer(std::min(loop.Interval() * 2, kMaxRefreshInterval), tick);
+        break;
+      default:
+        return;
+    }
+    draw(false);
+  };
+
+  loop.Add(STDIN_FILENO, EPOLLIN, [&](uint32_t events) {
+    if (events & (EPOLLHUP | EPOLLERR)) {
+      loop.Stop();
+      return;
+    }
+    int key;
+    while ((key = getch()) != ERR) {
+      onKey(key);
+    }
+  });
+  loop.HandleSignals({SIGWINCH, SIGINT, SIGTERM}, [&](int signal) {
+    if (signal != SIGWINCH) {
+      loop.Stop();
+      return;
+    }
+    winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+      resizeterm(size.ws_row, size.ws_col);
+    }
+    layout();
+    draw(false);
+  });
+  // A fired trigger draws right away, so the frame samples the stall while it
+  // is happening.
+  for (const int fd : std::vector<int>(pressure.TriggerFds())) {
+    loop.Add(fd, EPOLLPRI, [&, fd](uint32_t events) {
+      if (events & EPOLLERR) {
+        loop.Remove(fd);
+      }
+      if (pressure.Handle(fd, events) && !paused) {
+        draw(true);
+      }
+    });
   }
+  loop.SetTimer(options.interval, tick);
+  draw(true);
+  loop.Run();
+
+  delwin(system_window);
+  delwin(process_window);
   endwin();
 }
@@ -0,0 +1,241 @@
+#include "options.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "low_impact.h"
+#include "process_watch.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+// Parses the whole of `value` as the integer argument of `flag`.
+// Throws std::invalid_argument for anything else, out of range values
+// included.
+int ParseInt(const string& flag, const string& value) {
+  int number = 0;
+  const char* end = value.data() + value.size();
+  const auto [last, error] = std::from_chars(value.data(), end, number);
+  if (error != std::errc() || last != end) {
+    throw std::invalid_argument(flag + " requires a number: " + value);
+  }
+  return number;
+}
+}  // namespace
+
+/**
+ *  @brief  Parses the command line arguments of the monitor.
+ *  @param  args  The arguments, excluding the program name.
+ *
+ *  @returns The options, with defaults for anything not specified.
+ *  @throws std::invalid_argument for unknown flags or malformed values.
+ */
+Options CommandLine::Parse(const vector<string>& args) {
+  Options options;
+  bool low_impact{false};
+  for (size_t i = 0; i < args.size(); ++i) {
+    const string& arg = args[i];
+    if (arg == "-n") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("-n requires a value");
+      }
+      options.num_processes = ParseInt(arg, args[++i]);
+      if (options.num_processes <= 0) {
+        throw std::invalid_argument("-n must be a positive number");
+      }
+    } else if (arg == "--cgroups") {
+      options.show_cgroups = true;
+    } else if (arg == "--tree") {
+      options.show_tree = true;
+    } else if (arg == "--group-by") {
+      const string by = i + 1 < args.size() ? args[++i] : "";
+      if (by == "user") {
+        options.group_by = GroupBy::kUser;
+      } else if (by == "command") {
+        options.group_by = GroupBy::kCommand;
+      } else {
+        throw std::invalid_argument("--group-by requires user or command");
+      }
+    } else if (arg == "--sched") {
+      options.show_sched = true;
+    } else if (arg == "--fds") {
+      options.show_fds = true;
+    } else if (arg == "--blocked") {
+      options.show_blocked = true;
+    } else if (arg == "--io") {
+      options.show_io = true;
+    } else if (arg == "--headless") {
+      options.headless = true;
+    } else if (arg == "--filter") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--filter requires an expression");
+      }
+      options.filter = args[++i];
+    } else if (arg == "-p") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("-p requires a pid list");
+      }
+      const vector<int> pids = ProcessWatch::ParsePids(args[++i]);
+      options.watch.pids.insert(options.watch.pids.end(), pids.begin(),
+                                pids.end());
+    } else if (arg == "--name") {
+      if (i + 1 >= args.size() || args[i + 1].empty()) {
+        throw std::invalid_argument("--name requires a command name");
+      }
+      options.watch.names.push_back(args[++i]);
+    } else if (arg == "--cgroup") {
+      if (i + 1 >= args.size() || args[i + 1].empty()) {
+        throw std::invalid_argument("--cgroup requires a cgroup path");
+      }
+      // Relative to the cgroup root, with or without the leading slash of
+      // /proc/<pid>/cgroup.
+      string& cgroup = options.watch.cgroup = args[++i];
+      cgroup.erase(0, cgroup.find_first_not_of('/'));
+    } else if (arg == "--interval") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--interval requires milliseconds");
+      }
+      options.interval = std::chrono::milliseconds(ParseInt(arg, args[++i]));
+      if (options.interval < kFastestRefreshInterval ||
+          options.interval > kSlowestRefreshInterval) {
+        throw std::invalid_argument("--interval must be in 10-8000");
+      }
+    } else if (arg == "--publish") {
+      options.publish = true;
+    } else if (arg == "--attach") {
+      options.attach = true;
+    } else if (arg == "--shm-name") {
+      if (i + 1 >= args.size() || args[i + 1].empty()) {
+        throw std::invalid_argument("--shm-name requires a name");
+      }
+      options.snapshot_name = args[++i];
+      if (options.snapshot_name[0] != '/') {
+        options.snapshot_name = "/" + options.snapshot_name;
+      }
+    } else if (arg == "--metrics-port") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--metrics-port requires a port");
+      }
+      options.metrics_port = ParseInt(arg, args[++i]);
+      if (options.metrics_port <= 0 || options.metrics_port > 65535) {
+        throw std::invalid_argument("--metrics-port must be in 1-65535");
+      }
+    } else if (arg == "--psi-trigger") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--psi-trigger requires a trigger");
+      }
+      options.psi_triggers.push_back(args[++i]);
+    } else if (arg == "--warm-start") {
+      options.warm_start = true;
+    } else if (arg == "--low-impact") {
+      low_impact = true;
+    } else if (arg == "--idle") {
+      options.sched_idle = true;
+    } else if (arg == "--lock-memory") {
+      options.lock_memory = true;
+    } else if (arg == "--cpus") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--cpus requires a CPU list");
+      }
+      options.cpus = LowImpact::ParseCpuList(args[++i]);
+    } else if (arg == "--nice") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--nice requires a level");
+      }
+      options.nice = ParseInt(arg, args[++i]);
+      if (options.nice < -20 || options.nice > 19) {
+        throw std::invalid_argument("--nice must be in -20-19");
+      }
+    } else if (arg == "--cpu-budget") {
+      if (i + 1 >= args.size()) {
+        throw std::invalid_argument("--cpu-budget requires a percentage");
+      }
+      options.cpu_budget = ParseInt(arg, args[++i]);
+      if (options.cpu_budget <= 0 || options.cpu_budget > 100) {
+        throw std::invalid_argument("--cpu-budget must be in 1-100");
+      }
+    } else {
+      throw std::invalid_argument("unknown option: " + arg);
+    }
+  }
+  if (low_impact) {
+    // An explicit nice level or budget is kept.
+    options.sched_idle = options.sched_idle || options.nice == 0;
+    options.lock_memory = true;
+    options.cpu_budget = options.cpu_budget > 0 ? options.cpu_budget
+                                                : kLowImpactCpuBudget;
+  }
+  if (options.publish && options.attach) {
+    throw std::invalid_argument("--publish and --attach are exclusive");
+  }
+  if (options.attach && !options.filter.empty()) {
+    throw std::invalid_argument("the collector applies filters, not --attach");
+  }
+  if (options.attach && !options.watch.Empty()) {
+    throw std::invalid_argument("the collector watches, not --attach");
+  }
+  if (options.attach && options.warm_start) {
+    throw std::invalid_argument("--attach has no sampler state to keep");
+  }
+  return options;
+}
+
+string CommandLine::Usage() {
+  return "usage: monitor [-n rows] [--cgroups] [--tree] [--sched] [--headless]\n"
+         "               [--fds] [--blocked] [--io] [--group-by user|command]\n"
+         "               [--filter expression] [-p pid,...] [--name name]\n"
+         "               [--cgroup path] [--interval ms]\n"
+         "               [--publish | --attach]\n"
+         "               [--shm-name name] [--metrics-port port]\n"
+         "               [--psi-trigger resource:some|full:stall_ms:window_ms]\n"
+         "               [--warm-start] [--low-impact] [--cpus list]\n"
+         "               [--idle] [--nice level] [--lock-memory]\n"
+         "               [--cpu-budget percent]\n"
+         "  -n rows     number of processes to display (default 10)\n"
+         "  --cgroups   show usage per cgroup instead of per process\n"
+         "  --tree      show processes as a tree with subtree totals\n"
+         "  --group-by  show CPU, memory and process count totals per user or\n"
+         "              per command name\n"
+         "  --sched     show run-queue latency and wait, and context switch\n"
+         "              rates\n"
+         "  --fds       show the open file descriptors and the age of the count\n"
+         "  --blocked   show the share of time each process spent blocked in\n"
+         "              D state, sampled at 50 Hz\n"
+         "  --io        show disk, network and paging rates\n"
+         "  --headless  print to stdout instead of the ncurses interface\n"
+         "  --filter    only show matching processes, e.g.\n"
+         "              'user=build cmd~\"clang\" cpu>5'\n"
+         "  -p          only watch these pids and their descendants\n"
+         "  --name      only watch processes with this command name, and their\n"
+         "              descendants (repeatable); new ones are found within\n"
+         "              10s\n"
+         "  --cgroup    only watch the processes of this cgroup, e.g.\n"
+         "              system.slice/nginx.service\n"
+         "  --interval  refresh every this many milliseconds, 10-8000\n"
+         "              (default 1000)\n"
+         "  --publish   collect and publish snapshots to shared memory\n"
+         "  --attach    display the snapshots of a running collector\n"
+         "  --shm-name  shared memory name (default /monitor-snapshot)\n"
+         "  --metrics-port\n"
+         "              serve OpenMetrics on 127.0.0.1:port/metrics\n"
+         "  --psi-trigger\n"
+         "              refresh as soon as a pressure stall exceeds the\n"
+         "              threshold, e.g. memory:some:150:1000 (repeatable)\n"
+         "  --warm-start\n"
+         "              keep the sampler state in $XDG_RUNTIME_DIR across\n"
+         "              restarts, for real rates on the first frame\n"
+         "  --low-impact\n"
+         "              run at SCHED_IDLE (or --nice), lock the memory and\n"
+         "              use at most 5% of a CPU (or --cpu-budget)\n"
+         "  --cpus      only run on these CPUs, e.g. 0-1,4\n"
+         "  --idle      only run when a CPU is otherwise idle (SCHED_IDLE)\n"
+         "  --nice      run at this nice level\n"
+         "  --lock-memory\n"
+         "              lock the memory, so the monitor is not stalled by\n"
+         "              page faults when the host is short of memory\n"
+         "  --cpu-budget\n"
+         "              skip refreshes beyond this percentage of one CPU\n";
+}
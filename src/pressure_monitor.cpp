@@ -0,0 +1,208 @@
+#include "pressure_monitor.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::string;
+using std::vector;
+
+// The window limits enforced by the kernel for PSI triggers.
+const long kMinTriggerWindowMs = 500;
+const long kMaxTriggerWindowMs = 10000;
+
+PressureMonitor::PressureMonitor(std::filesystem::path pressureDirPath)
+    : pressure_dir_path_(pressureDirPath) {}
+
+PressureMonitor::~PressureMonitor() {
+  for (const int fd : this->trigger_fds_) {
+    close(fd);
+  }
+}
+
+bool PressureMonitor::Available() const {
+  std::error_code error;
+  return std::filesystem::is_directory(this->pressure_dir_path_, error);
+}
+
+/**
+ *  @brief  Registers a PSI trigger.
+ *  @param  spec  `resource:some|full:stall_ms:window_ms`, e.g.
+ * `memory:some:150:1000`.
+ *
+ *  @throws std::invalid_argument for a malformed specification.
+ *  @throws std::runtime_error when PSI is unavailable or the kernel rejects
+ * the trigger. Unprivileged users may only use windows that are multiples of
+ * 2 seconds.
+ */
+void PressureMonitor::AddTrigger(const string& spec) {
+  vector<string> fields;
+  std::istringstream specstream(spec);
+  string field;
+  while (std::getline(specstream, field, ':')) {
+    fields.push_back(field);
+  }
+  if (fields.size() != 4) {
+    throw std::invalid_argument("malformed PSI trigger: " + spec);
+  }
+  const string& resource = fields[0];
+  const string& kind = fields[1];
+  bool known = false;
+  for (const string& candidate : kResources) {
+    known = known || candidate == resource;
+  }
+  if (!known) {
+    throw std::invalid_argument("unknown PSI resource: " + resource);
+  }
+  if (kind != LinuxParser::kPressureSomeKey &&
+      kind != LinuxParser::kPressureFullKey) {
+    throw std::invalid_argument("PSI triggers are 'some' or 'full': " + spec);
+  }
+  long stallMs, windowMs;
+  try {
+    size_t stallEnd, windowEnd;
+    stallMs = std::stol(fields[2], &stallEnd);
+    windowMs = std::stol(fields[3], &windowEnd);
+    if (stallEnd != fields[2].size() || windowEnd != fields[3].size()) {
+      throw std::invalid_argument(spec);
+    }
+  } catch (const std::logic_error&) {
+    throw std::invalid_argument("malformed PSI trigger: " + spec);
+  }
+  if (windowMs < kMinTriggerWindowMs || windowMs > kMaxTriggerWindowMs ||
+      stallMs <= 0 || stallMs > windowMs) {
+    throw std::invalid_argument(
+        "PSI triggers need 0 < stall <= window and a 500-10000ms window: " +
+        spec);
+  }
+  if (!Available()) {
+    throw std::runtime_error("pressure stall information is not available");
+  }
+
+  const std::filesystem::path path = this->pressure_dir_path_ / resource;
+  const int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("could not open " + path.string() + ": " +
+                             std::strerror(errno));
+  }
+  const string trigger = kind + " " + std::to_string(stallMs * 1000) + " " +
+                         std::to_string(windowMs * 1000);
+  // The trigger string must be written in one call, including the
+  // terminating null byte.
+  if (write(fd, trigger.c_str(), trigger.size() + 1) < 0) {
+    const string error = std::strerror(errno);
+    close(fd);
+    throw std::runtime_error("could not register PSI trigger " + spec + ": " +
+                             error);
+  }
+  this->trigger_fds_.push_back(fd);
+}
+
+std::size_t PressureMonitor::NumTriggers() const {
+  return this->trigger_fds_.size();
+}
+
+/**
+ *  @brief  Reads the current pressure of every available resource.
+ *
+ *  @returns The stats, including the stall time accumulated since the
+ * previous call, or an empty vector without PSI.
+ */
+vector<PressureStats>& PressureMonitor::Update() {
+  vector<PressureStats> updated;
+  for (const string& resource : kResources) {
+    const std::filesystem::path path = this->pressure_dir_path_ / resource;
+    const vector<double> some =
+        LinuxParser::Pressure(path, LinuxParser::kPressureSomeKey);
+    if (some.empty()) {
+      continue;
+    }
+    PressureStats stats;
+    stats.resource = resource;
+    stats.some = {some[0], some[1], some[2], (long long)some[3], 0};
+    const vector<double> full =
+        LinuxParser::Pressure(path, LinuxParser::kPressureFullKey);
+    stats.has_full = !full.empty();
+    if (stats.has_full) {
+      stats.full = {full[0], full[1], full[2], (long long)full[3], 0};
+    }
+    for (const PressureStats& previous : this->stats_) {
+      if (previous.resource == resource) {
+        stats.some.delta_us = stats.some.total_us - previous.some.total_us;
+        stats.full.delta_us = stats.full.total_us - previous.full.total_us;
+      }
+    }
+    updated.push_back(stats);
+  }
+  this->stats_ = std::move(updated);
+  return this->stats_;
+}
+
+/**
+ *  @brief  Sleeps until the timeout expires or a PSI trigger fires.
+ *  @param  timeout  The longest time to wait.
+ *
+ *  @returns Whether a trigger fired.
+ */
+bool PressureMonitor::Wait(std::chrono::milliseconds timeout) {
+  if (this->trigger_fds_.empty()) {
+    std::this_thread::sleep_for(timeout);
+    return false;
+  }
+  vector<pollfd> fds;
+  for (const int fd : this->trigger_fds_) {
+    fds.push_back({fd, POLLPRI, 0});
+  }
+  const int ready = poll(fds.data(), fds.size(), timeout.count());
+  if (ready <= 0) {
+    return false;
+  }
+  bool fired = false;
+  for (const pollfd& fd : fds) {
+    fired = Handle(fd.fd, fd.revents) || fired;
+  }
+  return fired;
+}
+
+const vector<int>& PressureMonitor::TriggerFds() const {
+  return this->trigger_fds_;
+}
+
+/**
+ *  @brief  Records the poll events of a trigger fd. The epoll event bits for
+ * these conditions are the same, so `epoll` results can be passed as is.
+ *  @param  fd  One of `TriggerFds()`.
+ *  @param  events  The returned events.
+ *
+ *  @returns Whether the trigger fired. A trigger in error, e.g. because its
+ * resource was removed, is closed and dropped.
+ */
+bool PressureMonitor::Handle(int fd, short events) {
+  if (events & POLLERR) {
+    close(fd);
+    this->trigger_fds_.erase(std::remove(this->trigger_fds_.begin(),
+                                         this->trigger_fds_.end(), fd),
+                             this->trigger_fds_.end());
+    return false;
+  }
+  if (events & POLLPRI) {
+    ++this->events_;
+    return true;
+  }
+  return false;
+}
+
+long PressureMonitor::Events() const { return this->events_; }
@@ -1,5 +1,7 @@
 #include "process.h"
 
+#include <algorithm>
+#include <array>
 #include <cctype>
 #include <chrono>
 #include <ctime>
@@ -11,45 +13,201 @@
 #include <vector>
 
 #include "linux_parser.h"
+#include "linux_system.h"
+#include "system_memory.h"
 
 using std::string;
 using std::to_string;
 using std::vector;
 
-Process::Process(System* system, const int pid, const std::string user,
+Process::Process(LinuxSystem* system, const int pid, const std::string user,
                  const std::string command,
                  const std::filesystem::path pathRoot)
-    : system_(system),
-      pid_(pid),
-      user_(user),
-      cmd_(command),
-      fs_path_root_(pathRoot) {
+    : Process(system, pid, pathRoot) {
+  Identify(user, command);
+}
+
+Process::Process(LinuxSystem* system, const int pid,
+                 const std::filesystem::path pathRoot)
+    : system_(system), pid_(pid), fs_path_root_(pathRoot) {
   this->proc_stats_file_path_ = pathRoot /
                                 std::filesystem::path(std::to_string(pid)) /
                                 LinuxParser::kProcStatFilePath;
   UpdateStats();
 }
 
+Process::Process(const int pid, const int ppid, const std::string user,
+                 const std::string command, float cpuUtilization,
+                 long virtualMemoryKb, long int upTime)
+    : system_(nullptr),
+      pid_(pid),
+      ppid_(ppid),
+      user_(user),
+      cmd_(command),
+      identified_(true),
+      uptime_(upTime),
+      virtual_memory_kb_(virtualMemoryKb),
+      cpu_utilization_(cpuUtilization) {}
+
+void Process::Identify(std::string_view user, std::string_view command) {
+  this->user_ = InternedString(user);
+  this->cmd_ = InternedString(command);
+  this->identified_ = true;
+}
+
+bool Process::Identified() { return this->identified_; }
+
 int Process::Pid() { return this->pid_; }
 
+int Process::Ppid() { return this->ppid_; }
+
 float Process::CpuUtilization() {
   UpdateStats();
   return this->cpu_utilization_;
 }
 
-string Process::Command() { return this->cmd_; }
+std::string_view Process::Command() const { return this->cmd_.View(); }
+
+StringTable::Handle Process::CommandHandle() const {
+  return this->cmd_.Handle();
+}
 
 string Process::Ram() {
+  if (this->system_ == nullptr) {
+    return SystemMemory::Utilization(SystemMemory::Unit::kb,
+                                     this->virtual_memory_kb_)
+        .ToMbString();
+  }
   return LinuxParser::Ram(this->fs_path_root_, this->pid_);
 }
 
-string Process::User() { return this->user_; }
+// The same value as `Ram`, but taken from the stat file that is already read
+// for the CPU utilization rather than an extra read of the status file.
+long Process::VirtualMemoryKb() {
+  UpdateStats();
+  return this->virtual_memory_kb_;
+}
+
+std::string_view Process::User() const { return this->user_.View(); }
+
+StringTable::Handle Process::UserHandle() const { return this->user_.Handle(); }
 
 long int Process::UpTime() {
   UpdateStats();
   return this->uptime_;
 }
 
+long Process::StartTime() {
+  UpdateStats();
+  return this->start_time_;
+}
+
+long Process::TotalTicks() {
+  UpdateStats();
+  return this->total_ticks_;
+}
+
+double Process::SampleTime() {
+  UpdateStats();
+  return this->sample_time_;
+}
+
+bool Process::Restore(long startTime, long totalTicks, double sampleTime) {
+  if (this->sample_time_ < 0 || startTime != this->start_time_ ||
+      sampleTime >= this->sample_time_ || totalTicks > this->total_ticks_) {
+    return false;
+  }
+  this->cpu_utilization_ = ((this->total_ticks_ - totalTicks) / kCPUHertz) /
+                           (this->sample_time_ - sampleTime);
+  return true;
+}
+
+bool Process::Gone() const { return this->gone_; }
+
+SampleTier Process::Tier() const {
+  if (this->active_time_ >= this->sample_time_) {
+    return SampleTier::kHot;
+  }
+  return this->sample_time_ - this->active_time_ < kColdAfter.count()
+             ? SampleTier::kWarm
+             : SampleTier::kCold;
+}
+
+bool Process::SampleDue() const {
+  std::chrono::system_clock::duration interval = SampleInterval();
+  switch (Tier()) {
+    case SampleTier::kHot:
+      break;
+    case SampleTier::kWarm:
+      interval = kWarmSampleInterval;
+      break;
+    case SampleTier::kCold:
+      interval = kColdSampleInterval;
+      break;
+  }
+  return std::chrono::system_clock::now() >=
+         this->stats_last_updated_ + interval;
+}
+
+bool Process::Running() const { return this->state_ == 'R'; }
+
+bool Process::Blocked() const { return this->state_ == 'D'; }
+
+int Process::Threads() const { return this->threads_; }
+
+SchedRates Process::Sched() {
+  if (this->system_ == nullptr) {
+    return this->sched_rates_;
+  }
+  const std::chrono::time_point now = std::chrono::system_clock::now();
+  if (now < this->sched_last_updated_ + SampleInterval()) {
+    return this->sched_rates_;
+  }
+  this->sched_last_updated_ = now;
+  const std::filesystem::path dir =
+      this->fs_path_root_ / std::to_string(this->pid_);
+  LinuxParser::SchedStatSchema::Values sched;
+  ProcSchema::Keyed<LinuxParser::StatusSwitchKeys>::Values switches;
+  if (!LinuxParser::SchedStats(dir / LinuxParser::kSchedStatFilePath, sched) ||
+      !LinuxParser::ContextSwitches(dir / LinuxParser::kStatusFilePath,
+                                    switches)) {
+    return this->sched_rates_;
+  }
+  const std::array<long, 5> counters{sched[0], sched[1], sched[2],
+                                     switches[0], switches[1]};
+  const double sampleTime = LinuxParser::BootTime();
+  const double elapsed = sampleTime - this->sched_sample_time_;
+  if (this->sched_sample_time_ >= 0 && elapsed > 0) {
+    std::array<double, 5> deltas;
+    for (std::size_t i = 0; i < counters.size(); ++i) {
+      deltas[i] = std::max(counters[i] - this->sched_counters_[i], 0L);
+    }
+    this->sched_rates_.run = deltas[0] / 1e9 / elapsed;
+    this->sched_rates_.wait = deltas[1] / 1e9 / elapsed;
+    this->sched_rates_.latency = deltas[2] > 0 ? deltas[1] / 1e9 / deltas[2] : 0;
+    this->sched_rates_.timeslices = deltas[2] / elapsed;
+    this->sched_rates_.voluntary_switches = deltas[3] / elapsed;
+    this->sched_rates_.involuntary_switches = deltas[4] / elapsed;
+  }
+  this->sched_counters_ = counters;
+  this->sched_sample_time_ = sampleTime;
+  return this->sched_rates_;
+}
+
+FdCount Process::Fds() {
+  if (this->system_ == nullptr) {
+    return FdCount();
+  }
+  return this->system_->Fds(this->pid_);
+}
+
+RunStates Process::States() {
+  if (this->system_ == nullptr) {
+    return RunStates();
+  }
+  return this->system_->States(this->pid_);
+}
+
 bool Process::operator<(Process const& a) const {
   return this->cpu_utilization_ < a.cpu_utilization_;
 }
@@ -60,27 +218,69 @@ bool Process::operator>(Process const& a) const {
 
 bool Process::operator==(Process b) const { return this->pid_ == b.pid_; }
 
+std::chrono::milliseconds Process::SampleInterval() const {
+  return this->system_ == nullptr ? std::chrono::milliseconds(kUpdateInterval)
+                                  : this->system_->SampleInterval();
+}
+
 void Process::UpdateStats() {
+  if (this->system_ == nullptr) {
+    return;
+  }
   const std::chrono::time_point now = std::chrono::system_clock::now();
-  const std::chrono::time_point nextUpdate = stats_last_updated_ + kUpdateInterval;
+  const std::chrono::time_point nextUpdate =
+      stats_last_updated_ + SampleInterval();
   if (now < nextUpdate) {
     return;
   }
   this->stats_last_updated_ = now;
-  const auto stats = LinuxParser::Stats(this->proc_stats_file_path_);
-  if (stats.size() < LinuxParser::kStarttimeStatIndex + 1) {
+  LinuxParser::ProcessStatSchema::Values stats;
+  if (!LinuxParser::ProcessStats(this->proc_stats_file_path_, stats)) {
+    this->gone_ = true;
     return;
   }
+  using LinuxParser::ProcessStatSchema;
   const long systemUpTime = system_->UpTime();
-  const long procStartTime = std::stol(stats[LinuxParser::kStarttimeStatIndex]);
-  const long procUpTime = std::stol(stats[LinuxParser::kUtimeStatIndex]);
-  const long procSTime = std::stol(stats[LinuxParser::kStimeStatIndex]);
-  const long procCUTime = std::stol(stats[LinuxParser::kCutimeStatIndex]);
-  const long procCSTime = std::stol(stats[LinuxParser::kCstimeStatIndex]);
-  const float procTotalTime =
-      float(procUpTime + procSTime + procCUTime + procCSTime);
+  const long procStartTime =
+      stats[ProcessStatSchema::Position(LinuxParser::kStarttimeStatIndex)];
+  const long procUpTime =
+      stats[ProcessStatSchema::Position(LinuxParser::kUtimeStatIndex)];
+  const long procSTime =
+      stats[ProcessStatSchema::Position(LinuxParser::kStimeStatIndex)];
+  const long procCUTime =
+      stats[ProcessStatSchema::Position(LinuxParser::kCutimeStatIndex)];
+  const long procCSTime =
+      stats[ProcessStatSchema::Position(LinuxParser::kCstimeStatIndex)];
+  const long totalTicks = procUpTime + procSTime + procCUTime + procCSTime;
   const float procElapsedTime =
       float(systemUpTime) - (float(procStartTime) / kCPUHertz);
+  const double sampleTime = LinuxParser::BootTime();
+  if (this->sample_time_ >= 0 && procStartTime != this->start_time_) {
+    this->gone_ = true;
+  }
+  this->state_ =
+      char(stats[ProcessStatSchema::Position(LinuxParser::kStateStatIndex)]);
+  // A new process counts as active until a sample shows it idle.
+  if (this->sample_time_ < 0 || totalTicks != this->total_ticks_ ||
+      this->state_ == 'R') {
+    this->active_time_ = sampleTime;
+  }
+  if (this->sample_time_ >= 0 && procStartTime == this->start_time_ &&
+      sampleTime > this->sample_time_) {
+    // The utilization over the interval since the previous sample.
+    this->cpu_utilization_ = ((totalTicks - this->total_ticks_) / kCPUHertz) /
+                             (sampleTime - this->sample_time_);
+  } else {
+    // The first sample can only give the average since the process started.
+    this->cpu_utilization_ = (float(totalTicks) / kCPUHertz) / procElapsedTime;
+  }
+  this->start_time_ = procStartTime;
+  this->total_ticks_ = totalTicks;
+  this->sample_time_ = sampleTime;
+  this->ppid_ = stats[ProcessStatSchema::Position(LinuxParser::kPpidStatIndex)];
+  this->threads_ = int(
+      stats[ProcessStatSchema::Position(LinuxParser::kNumThreadsStatIndex)]);
+  this->virtual_memory_kb_ =
+      stats[ProcessStatSchema::Position(LinuxParser::kVsizeStatIndex)] / 1024;
   this->uptime_ = (long int)procElapsedTime;
-  this->cpu_utilization_ = (procTotalTime / kCPUHertz) / procElapsedTime;
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "process_filter.h"
+
+#include <cctype>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+using std::string;
+using std::vector;
+
+/**
+ *  @brief  Compiles a filter expression.
+ *  @param  expression  Whitespace separated `<field><op><value>` predicates,
+ * where text values may be double quoted to include spaces.
+ *
+ *  @returns The compiled filter.
+ *  @throws std::invalid_argument if the expression is malformed.
+ */
+ProcessFilter ProcessFilter::Compile(const string& expression) {
+  ProcessFilter filter;
+  filter.expression_ = expression;
+  size_t i = 0;
+  while (true) {
+    while (i < expression.size() && std::isspace(expression[i])) {
+      ++i;
+    }
+    if (i == expression.size()) {
+      break;
+    }
+    const size_t field_start = i;
+    while (i < expression.size() && std::isalpha(expression[i])) {
+      ++i;
+    }
+    const string name = expression.substr(field_start, i - field_start);
+    Predicate predicate;
+    Stage stage;
+    if (name == "pid") {
+      predicate.field = Field::kPid;
+      stage = Stage::kPid;
+    } else if (name == "ppid") {
+      predicate.field = Field::kPpid;
+      stage = Stage::kStat;
+    } else if (name == "cpu") {
+      predicate.field = Field::kCpu;
+      stage = Stage::kStat;
+    } else if (name == "mem") {
+      predicate.field = Field::kMemory;
+      stage = Stage::kStat;
+    } else if (name == "time") {
+      predicate.field = Field::kTime;
+      stage = Stage::kStat;
+    } else if (name == "user") {
+      predicate.field = Field::kUser;
+      stage = Stage::kStatus;
+    } else if (name == "cmd") {
+      predicate.field = Field::kCommand;
+      stage = Stage::kCmdline;
+    } else {
+      throw std::invalid_argument("unknown filter field: '" + name + "'");
+    }
+
+    const string rest = expression.substr(i, 2);
+    if (rest == "!=" || rest == "<=" || rest == ">=" || rest == "!~") {
+      predicate.op = rest == "!="   ? Op::kNe
+                     : rest == "<=" ? Op::kLe
+                     : rest == ">=" ? Op::kGe
+                                    : Op::kNoMatch;
+      i += 2;
+    } else if (!rest.empty() && string("=<>~").find(rest[0]) != string::npos) {
+      predicate.op = rest[0] == '='   ? Op::kEq
+                     : rest[0] == '<' ? Op::kLt
+                     : rest[0] == '>' ? Op::kGt
+                                      : Op::kMatch;
+      i += 1;
+    } else {
+      throw std::invalid_argument("missing operator after '" + name + "'");
+    }
+
+    string value;
+    if (i < expression.size() && expression[i] == '"') {
+      ++i;
+      while (i < expression.size() && expression[i] != '"') {
+        if (expression[i] == '\\' && i + 1 < expression.size()) {
+          ++i;
+        }
+        value += expression[i++];
+      }
+      if (i == expression.size()) {
+        throw std::invalid_argument("unterminated string in filter");
+      }
+      ++i;
+    } else {
+      while (i < expression.size() && !std::isspace(expression[i])) {
+        value += expression[i++];
+      }
+    }
+    if (value.empty()) {
+      throw std::invalid_argument("missing value for '" + name + "'");
+    }
+
+    const bool text = predicate.field == Field::kUser ||
+                      predicate.field == Field::kCommand;
+    const bool ordering = predicate.op == Op::kLt || predicate.op == Op::kLe ||
+                          predicate.op == Op::kGt || predicate.op == Op::kGe;
+    const bool matching =
+        predicate.op == Op::kMatch || predicate.op == Op::kNoMatch;
+    if ((text && ordering) || (!text && matching)) {
+      throw std::invalid_argument("unsupported operator for '" + name + "'");
+    }
+    if (text) {
+      predicate.text = value;
+      if (matching) {
+        try {
+          predicate.pattern = std::regex(value);
+        } catch (const std::regex_error&) {
+          throw std::invalid_argument("invalid pattern: '" + value + "'");
+        }
+      }
+    } else {
+      size_t parsed = 0;
+      try {
+        predicate.number = std::stod(value, &parsed);
+      } catch (const std::logic_error&) {
+      }
+      if (parsed == 0 || parsed != value.size()) {
+        throw std::invalid_argument("invalid number: '" + value + "'");
+      }
+    }
+    filter.predicates_[int(stage)].push_back(std::move(predicate));
+  }
+  return filter;
+}
+
+bool ProcessFilter::Empty() const {
+  for (const auto& predicates : this->predicates_) {
+    if (!predicates.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProcessFilter::HasPredicates(Stage stage) const {
+  return !this->predicates_[int(stage)].empty();
+}
+
+const string& ProcessFilter::Expression() const { return this->expression_; }
+
+bool ProcessFilter::AcceptsPid(int pid) const {
+  for (const auto& predicate : this->predicates_[int(Stage::kPid)]) {
+    if (!Compare(predicate, double(pid))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Only uses values derived from the process' stat file.
+bool ProcessFilter::AcceptsStat(Process& process) const {
+  for (const auto& predicate : this->predicates_[int(Stage::kStat)]) {
+    double value{0};
+    switch (predicate.field) {
+      case Field::kPpid:
+        value = process.Ppid();
+        break;
+      case Field::kCpu:
+        value = process.CpuUtilization() * 100;
+        break;
+      case Field::kMemory:
+        value = process.VirtualMemoryKb() / 1000.0;
+        break;
+      case Field::kTime:
+        value = process.UpTime();
+        break;
+      default:
+        throw std::runtime_error("field is not available from stat");
+    }
+    if (!Compare(predicate, value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProcessFilter::AcceptsUser(const string& user) const {
+  for (const auto& predicate : this->predicates_[int(Stage::kStatus)]) {
+    if (!Compare(predicate, user)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProcessFilter::AcceptsCommand(const string& command) const {
+  for (const auto& predicate : this->predicates_[int(Stage::kCmdline)]) {
+    if (!Compare(predicate, command)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProcessFilter::Compare(const Predicate& predicate, double value) {
+  switch (predicate.op) {
+    case Op::kEq:
+      return value == predicate.number;
+    case Op::kNe:
+      return value != predicate.number;
+    case Op::kLt:
+      return value < predicate.number;
+    case Op::kLe:
+      return value <= predicate.number;
+    case Op::kGt:
+      return value > predicate.number;
+    case Op::kGe:
+      return value >= predicate.number;
+    default:
+      return false;
+  }
+}
+
+bool ProcessFilter::Compare(const Predicate& predicate, const string& value) {
+  switch (predicate.op) {
+    case Op::kEq:
+      return value == predicate.text;
+    case Op::kNe:
+      return value != predicate.text;
+    case Op::kMatch:
+      return std::regex_search(value, predicate.pattern);
+    case Op::kNoMatch:
+      return !std::regex_search(value, predicate.pattern);
+    default:
+      return false;
+  }
+}
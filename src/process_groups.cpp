@@ -0,0 +1,141 @@
+#include "process_groups.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "process.h"
+
+using std::vector;
+
+/**
+ *  @brief  Adds a process to its user and command groups, or updates it.
+ *  @param  process  The process, whose values are read once. Only the change
+ * since its last update is added to its groups.
+ */
+void ProcessGroups::Update(Process& process) {
+  const float cpu = process.CpuUtilization();
+  const long memory = process.VirtualMemoryKb();
+  const std::string_view command = Basename(process.Command());
+  const auto [it, joined] = this->members_.try_emplace(process.Pid());
+  Member& member = it->second;
+  if (!joined && member.user.Handle() == process.UserHandle() &&
+      member.command.View() == command) {
+    const float cpu_delta = cpu - member.cpu_utilization;
+    const long memory_delta = memory - member.memory_kb;
+    Add(this->users_, member.user, 0, cpu_delta, memory_delta);
+    Add(this->commands_, member.command, 0, cpu_delta, memory_delta);
+    member.cpu_utilization = cpu;
+    member.memory_kb = memory;
+    return;
+  }
+  if (!joined) {
+    // A reused pid or an exec, which moves to its new groups.
+    Add(this->users_, member.user, -1, -member.cpu_utilization,
+        -member.memory_kb);
+    Add(this->commands_, member.command, -1, -member.cpu_utilization,
+        -member.memory_kb);
+  }
+  member = {InternedString(process.User()), InternedString(command), cpu,
+            memory};
+  Add(this->users_, member.user, 1, cpu, memory);
+  Add(this->commands_, member.command, 1, cpu, memory);
+}
+
+/**
+ *  @brief  Takes an exited process out of its groups.
+ *  @param  pid  The process to remove. Groups left without processes go.
+ */
+void ProcessGroups::Remove(int pid) {
+  const auto it = this->members_.find(pid);
+  if (it == this->members_.end()) {
+    return;
+  }
+  const Member& member = it->second;
+  Add(this->users_, member.user, -1, -member.cpu_utilization,
+      -member.memory_kb);
+  Add(this->commands_, member.command, -1, -member.cpu_utilization,
+      -member.memory_kb);
+  this->members_.erase(it);
+}
+
+vector<ProcessGroups::Row>& ProcessGroups::Rows(GroupBy by, int n) {
+  this->rows_.clear();
+  if (by == GroupBy::kProcess) {
+    return this->rows_;
+  }
+  const Groups& groups = by == GroupBy::kUser ? this->users_ : this->commands_;
+  for (const auto& [handle, group] : groups) {
+    this->rows_.push_back({group.name.View(), group.num_processes,
+                           group.cpu_utilization, group.memory_kb});
+  }
+  const auto middle =
+      this->rows_.begin() +
+      std::min<std::size_t>(std::max(n, 0), this->rows_.size());
+  std::partial_sort(this->rows_.begin(), middle, this->rows_.end(),
+                    [](const Row& a, const Row& b) {
+                      return a.cpu_utilization > b.cpu_utilization;
+                    });
+  this->rows_.erase(middle, this->rows_.end());
+  return this->rows_;
+}
+
+std::size_t ProcessGroups::Size(GroupBy by) const {
+  switch (by) {
+    case GroupBy::kUser:
+      return this->users_.size();
+    case GroupBy::kCommand:
+      return this->commands_.size();
+    case GroupBy::kProcess:
+      break;
+  }
+  return this->members_.size();
+}
+
+std::string_view ProcessGroups::Basename(std::string_view command) {
+  const std::string_view program = command.substr(0, command.find(' '));
+  const std::size_t slash = program.rfind('/');
+  return slash == std::string_view::npos ? program : program.substr(slash + 1);
+}
+
+const char* ProcessGroups::Name(GroupBy by) {
+  switch (by) {
+    case GroupBy::kUser:
+      return "user";
+    case GroupBy::kCommand:
+      return "command";
+    case GroupBy::kProcess:
+      break;
+  }
+  return "process";
+}
+
+GroupBy ProcessGroups::Next(GroupBy by) {
+  switch (by) {
+    case GroupBy::kProcess:
+      return GroupBy::kUser;
+    case GroupBy::kUser:
+      return GroupBy::kCommand;
+    case GroupBy::kCommand:
+      break;
+  }
+  return GroupBy::kProcess;
+}
+
+// Adds to the totals of a group, creating it as needed and dropping it once it
+// has no processes.
+void ProcessGroups::Add(Groups& groups, const InternedString& name,
+                        int num_processes, float cpu_delta,
+                        long memory_delta) {
+  const auto [it, inserted] = groups.try_emplace(name.Handle());
+  Group& group = it->second;
+  if (inserted) {
+    group.name = name;
+  }
+  group.num_processes += num_processes;
+  group.cpu_utilization += cpu_delta;
+  group.memory_kb += memory_delta;
+  if (group.num_processes <= 0) {
+    groups.erase(it);
+  }
+}
@@ -0,0 +1,117 @@
+#include "process_sort.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "process.h"
+
+using std::string;
+using std::vector;
+
+/**
+ *  @brief  Orders processes by a key, largest first except for pids.
+ *  @param  processes  The processes to reorder in place.
+ *  @param  key  The column to order by.
+ */
+void ProcessSort::Sort(vector<Process>& processes, SortKey key) {
+  Top(processes, key, processes.size());
+}
+
+/**
+ *  @brief  Orders the first processes by a key, largest first except for
+ * pids, as needed to draw the top rows.
+ *  @param  processes  The processes to reorder in place.
+ *  @param  key  The column to order by.
+ *  @param  k  How many processes to order.
+ *
+ * The keys are read once per process up front, so the comparisons do not go
+ * through the (throttled) accessors. Ties keep their previous order.
+ */
+void ProcessSort::Top(vector<Process>& processes, SortKey key, size_t k) {
+  vector<std::pair<double, size_t>> keys;
+  keys.reserve(processes.size());
+  for (size_t i = 0; i < processes.size(); ++i) {
+    Process& process = processes[i];
+    double value = 0;
+    switch (key) {
+      case SortKey::kCpu:
+        value = -process.CpuUtilization();
+        break;
+      case SortKey::kMemory:
+        value = -process.VirtualMemoryKb();
+        break;
+      case SortKey::kTime:
+        value = -process.UpTime();
+        break;
+      case SortKey::kPid:
+        value = process.Pid();
+        break;
+      case SortKey::kWait:
+        value = -process.Sched().wait;
+        break;
+      case SortKey::kSwitches: {
+        const SchedRates rates = process.Sched();
+        value = -(rates.voluntary_switches + rates.involuntary_switches);
+        break;
+      }
+      case SortKey::kFds:
+        // Unknown counts, -1, go last.
+        value = -process.Fds().count;
+        break;
+    }
+    keys.emplace_back(value, i);
+  }
+  k = std::min(k, keys.size());
+  std::partial_sort(keys.begin(), keys.begin() + k, keys.end());
+  // The rest go back in their previous order.
+  std::sort(keys.begin() + k, keys.end(),
+            [](const auto& a, const auto& b) { return a.second < b.second; });
+  vector<Process> sorted;
+  sorted.reserve(processes.size());
+  for (const auto& entry : keys) {
+    sorted.push_back(std::move(processes[entry.second]));
+  }
+  processes = std::move(sorted);
+}
+
+SortKey ProcessSort::Next(SortKey key) {
+  switch (key) {
+    case SortKey::kCpu:
+      return SortKey::kMemory;
+    case SortKey::kMemory:
+      return SortKey::kTime;
+    case SortKey::kTime:
+      return SortKey::kPid;
+    case SortKey::kPid:
+      return SortKey::kWait;
+    case SortKey::kWait:
+      return SortKey::kSwitches;
+    case SortKey::kSwitches:
+      return SortKey::kFds;
+    case SortKey::kFds:
+      break;
+  }
+  return SortKey::kCpu;
+}
+
+string ProcessSort::Name(SortKey key) {
+  switch (key) {
+    case SortKey::kCpu:
+      return "cpu";
+    case SortKey::kMemory:
+      return "mem";
+    case SortKey::kTime:
+      return "time";
+    case SortKey::kPid:
+      return "pid";
+    case SortKey::kWait:
+      return "wait";
+    case SortKey::kSwitches:
+      return "csw";
+    case SortKey::kFds:
+      return "fds";
+  }
+  return "";
+}
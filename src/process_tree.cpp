@@ -0,0 +1,266 @@
+#include "process_tree.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "process.h"
+
+using std::vector;
+
+ProcessTree::ProcessTree() { this->nodes_[kRootPid]; }
+
+/**
+ *  @brief  Adds a process to the tree, or moves it when its parent changed.
+ *  @param  pid  The process to add.
+ *  @param  ppid  The parent reported by the process. Processes whose parent is
+ * not in the tree yet are shown at the top level until the parent is added.
+ */
+void ProcessTree::Insert(int pid, int ppid) {
+  if (pid == kRootPid) {
+    return;
+  }
+  auto [it, inserted] = this->nodes_.try_emplace(pid);
+  Node& node = it->second;
+  if (!inserted && node.ppid == ppid) {
+    return;
+  }
+  if (!inserted) {
+    Unlink(node);
+    Forget(pid, node.ppid);
+  }
+  node.ppid = ppid;
+  if (ppid != kRootPid && this->nodes_.count(ppid) == 0) {
+    this->waiting_[ppid].push_back(pid);
+    Link(pid, node, kRootPid);
+  } else if (IsDescendant(ppid, pid)) {
+    // A reused pid can claim its own descendant as parent; linking it would
+    // make a cycle, so it stays at the top until the tree is consistent.
+    Link(pid, node, kRootPid);
+  } else {
+    Link(pid, node, ppid);
+  }
+  if (!inserted) {
+    return;
+  }
+  // Adopt any children that were added before this process.
+  const auto waiting = this->waiting_.find(pid);
+  if (waiting != this->waiting_.end()) {
+    const vector<int> children = std::move(waiting->second);
+    this->waiting_.erase(waiting);
+    for (const int child_pid : children) {
+      const auto child = this->nodes_.find(child_pid);
+      if (child != this->nodes_.end() && child->second.ppid == pid &&
+          child->second.parent == kRootPid && !IsDescendant(pid, child_pid)) {
+        Unlink(child->second);
+        Link(child_pid, child->second, pid);
+      }
+    }
+  }
+}
+
+/**
+ *  @brief  Removes an exited process from the tree.
+ *  @param  pid  The process to remove. Its children move to the top level
+ * until they are re-inserted with the parent the kernel re-parented them to.
+ */
+void ProcessTree::Remove(int pid) {
+  const auto it = this->nodes_.find(pid);
+  if (pid == kRootPid || it == this->nodes_.end()) {
+    return;
+  }
+  Node& node = it->second;
+  while (node.first_child != kNone) {
+    const int child_pid = node.first_child;
+    Node& child = this->nodes_.at(child_pid);
+    Unlink(child);
+    Link(child_pid, child, kRootPid);
+  }
+  Unlink(node);
+  Forget(pid, node.ppid);
+  this->nodes_.erase(it);
+}
+
+/**
+ *  @brief  Records the latest CPU and memory usage of a process and updates
+ * the totals of its ancestors.
+ */
+void ProcessTree::Update(Process& process) {
+  const auto it = this->nodes_.find(process.Pid());
+  if (it == this->nodes_.end()) {
+    return;
+  }
+  Node& node = it->second;
+  node.process = &process;
+  const float cpu = process.CpuUtilization();
+  const long memory = process.VirtualMemoryKb();
+  const float cpu_delta = cpu - node.cpu_utilization;
+  const long memory_delta = memory - node.memory_kb;
+  node.cpu_utilization = cpu;
+  node.memory_kb = memory;
+  node.subtree_cpu_utilization += cpu_delta;
+  node.subtree_memory_kb += memory_delta;
+  Propagate(node.parent, cpu_delta, memory_delta);
+}
+
+bool ProcessTree::ToggleCollapsed(int pid) {
+  const auto it = this->nodes_.find(pid);
+  if (pid == kRootPid || it == this->nodes_.end()) {
+    return false;
+  }
+  it->second.collapsed = !it->second.collapsed;
+  return it->second.collapsed;
+}
+
+int ProcessTree::Parent(int pid) const {
+  const auto it = this->nodes_.find(pid);
+  return it == this->nodes_.end() ? kNone : it->second.parent;
+}
+
+vector<int> ProcessTree::Children(int pid) const {
+  vector<int> children;
+  const auto it = this->nodes_.find(pid);
+  if (it == this->nodes_.end()) {
+    return children;
+  }
+  for (int child = it->second.first_child; child != kNone;
+       child = this->nodes_.at(child).next_sibling) {
+    children.push_back(child);
+  }
+  return children;
+}
+
+float ProcessTree::SubtreeCpuUtilization(int pid) const {
+  const auto it = this->nodes_.find(pid);
+  return it == this->nodes_.end() ? 0 : it->second.subtree_cpu_utilization;
+}
+
+long ProcessTree::SubtreeMemoryKb(int pid) const {
+  const auto it = this->nodes_.find(pid);
+  return it == this->nodes_.end() ? 0 : it->second.subtree_memory_kb;
+}
+
+std::size_t ProcessTree::Size() const { return this->nodes_.size() - 1; }
+
+vector<ProcessTree::Row>& ProcessTree::Rows(int n) {
+  this->rows_.clear();
+  int pid = this->nodes_.at(kRootPid).first_child;
+  int depth = 0;
+  while (pid != kNone && int(this->rows_.size()) < n) {
+    const Node& node = this->nodes_.at(pid);
+    // Rows are only for processes that can be drawn, so that the selection
+    // never lands on a blank one.
+    if (node.process != nullptr) {
+      this->rows_.push_back({pid, node.process, depth, node.num_children,
+                             node.collapsed, node.subtree_cpu_utilization,
+                             node.subtree_memory_kb});
+    }
+    if (!node.collapsed && node.first_child != kNone) {
+      pid = node.first_child;
+      ++depth;
+      continue;
+    }
+    // Climb until an ancestor has a next sibling to continue with.
+    while (pid != kRootPid && this->nodes_.at(pid).next_sibling == kNone) {
+      pid = this->nodes_.at(pid).parent;
+      --depth;
+    }
+    pid = pid == kRootPid ? kNone : this->nodes_.at(pid).next_sibling;
+  }
+  return this->rows_;
+}
+
+int ProcessTree::Neighbor(const vector<Row>& rows, int pid, int offset) {
+  if (rows.empty()) {
+    return kNone;
+  }
+  int index = 0;
+  for (int i = 0; i < int(rows.size()); ++i) {
+    if (rows[i].pid == pid) {
+      index = std::clamp(i + offset, 0, int(rows.size()) - 1);
+      break;
+    }
+  }
+  return rows[index].pid;
+}
+
+// Children are kept in pid order. New processes usually have the highest pid,
+// so the position is found by scanning back from the last child, which is
+// O(siblings) at worst.
+void ProcessTree::Link(int pid, Node& node, int parent) {
+  Node& parent_node = this->nodes_.at(parent);
+  int prev = parent_node.last_child;
+  while (prev != kNone && prev > pid) {
+    prev = this->nodes_.at(prev).prev_sibling;
+  }
+  const int next = prev == kNone ? parent_node.first_child
+                                  : this->nodes_.at(prev).next_sibling;
+  node.parent = parent;
+  node.prev_sibling = prev;
+  node.next_sibling = next;
+  if (prev != kNone) {
+    this->nodes_.at(prev).next_sibling = pid;
+  } else {
+    parent_node.first_child = pid;
+  }
+  if (next != kNone) {
+    this->nodes_.at(next).prev_sibling = pid;
+  } else {
+    parent_node.last_child = pid;
+  }
+  ++parent_node.num_children;
+  Propagate(parent, node.subtree_cpu_utilization, node.subtree_memory_kb);
+}
+
+void ProcessTree::Unlink(Node& node) {
+  Node& parent_node = this->nodes_.at(node.parent);
+  if (node.prev_sibling != kNone) {
+    this->nodes_.at(node.prev_sibling).next_sibling = node.next_sibling;
+  } else {
+    parent_node.first_child = node.next_sibling;
+  }
+  if (node.next_sibling != kNone) {
+    this->nodes_.at(node.next_sibling).prev_sibling = node.prev_sibling;
+  } else {
+    parent_node.last_child = node.prev_sibling;
+  }
+  --parent_node.num_children;
+  Propagate(node.parent, -node.subtree_cpu_utilization,
+            -node.subtree_memory_kb);
+  node.parent = kNone;
+  node.prev_sibling = kNone;
+  node.next_sibling = kNone;
+}
+
+// Stops waiting for the parent of a process that was moved or removed.
+void ProcessTree::Forget(int pid, int ppid) {
+  const auto waiting = this->waiting_.find(ppid);
+  if (waiting == this->waiting_.end()) {
+    return;
+  }
+  auto& pids = waiting->second;
+  pids.erase(std::remove(pids.begin(), pids.end(), pid), pids.end());
+  if (pids.empty()) {
+    this->waiting_.erase(waiting);
+  }
+}
+
+// Whether `pid` is `ancestor` or lies below it.
+bool ProcessTree::IsDescendant(int pid, int ancestor) const {
+  while (pid != kNone && pid != kRootPid) {
+    if (pid == ancestor) {
+      return true;
+    }
+    pid = this->nodes_.at(pid).parent;
+  }
+  return false;
+}
+
+void ProcessTree::Propagate(int parent, float cpu_delta, long memory_delta) {
+  while (parent != kNone) {
+    Node& node = this->nodes_.at(parent);
+    node.subtree_cpu_utilization += cpu_delta;
+    node.subtree_memory_kb += memory_delta;
+    parent = node.parent;
+  }
+}
@@ -0,0 +1,237 @@
+#include "process_watch.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+// The kernel keeps the first 15 characters of a command name.
+const std::size_t kMaxCommLength = 15;
+const std::size_t kBufferBytes = 16 * 1024;
+const char kCgroupProcsFilename[] = "cgroup.procs";
+
+bool IsDots(const char* name) {
+  return std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0;
+}
+}  // namespace
+
+ProcessWatch::ProcessWatch(string procsDirPath, string cgroupRootPath,
+                           WatchTarget target)
+    : procs_dir_path_(std::move(procsDirPath)),
+      cgroup_root_path_(std::move(cgroupRootPath)),
+      target_(std::move(target)) {}
+
+/**
+ *  @brief  Lists the watched processes and their descendants.
+ *  @param  pids  Receives the pids that still run, in ascending order.
+ *
+ *  The given pids, the named processes, the members of the cgroup and the
+ * processes listed last time are each looked up, and their children added in
+ * turn, so the cost grows with the watched processes alone. A process listed
+ * last time is dropped when its pid now has another start time.
+ */
+void ProcessWatch::List(vector<int>& pids) {
+  const auto now = std::chrono::steady_clock::now();
+  if (!this->target_.names.empty() &&
+      (!this->resolved_ ||
+       now - this->resolved_time_ >= kNameRescanInterval)) {
+    ResolveNames();
+    this->resolved_time_ = now;
+  }
+  this->queue_.assign(this->target_.pids.begin(), this->target_.pids.end());
+  this->queue_.insert(this->queue_.end(), this->named_.begin(),
+                      this->named_.end());
+  this->watched_.erase(
+      std::remove_if(this->watched_.begin(), this->watched_.end(),
+                     [this](const std::pair<int, long>& watched) {
+                       long startTime;
+                       return !StartTime(watched.first, startTime) ||
+                              startTime != watched.second;
+                     }),
+      this->watched_.end());
+  for (const auto& watched : this->watched_) {
+    this->queue_.push_back(watched.first);
+  }
+  if (!this->target_.cgroup.empty()) {
+    AddCgroup(this->cgroup_root_path_ + "/" + this->target_.cgroup);
+  }
+  this->seen_.clear();
+  pids.clear();
+  // The queue grows with the children of the processes taken from it.
+  for (std::size_t i = 0; i < this->queue_.size(); ++i) {
+    const int pid = this->queue_[i];
+    if (pid > 0 && this->seen_.insert(pid).second && AddChildren(pid)) {
+      pids.push_back(pid);
+    }
+  }
+  std::sort(pids.begin(), pids.end());
+  // Both are in order of pid, so the start times still known are found in
+  // one pass.
+  std::size_t known = 0;
+  const std::size_t numKnown = this->watched_.size();
+  for (const int pid : pids) {
+    while (known < numKnown && this->watched_[known].first < pid) {
+      ++known;
+    }
+    long startTime;
+    if (known < numKnown && this->watched_[known].first == pid) {
+      startTime = this->watched_[known].second;
+    } else if (!StartTime(pid, startTime)) {
+      continue;
+    }
+    this->watched_.emplace_back(pid, startTime);
+  }
+  this->watched_.erase(this->watched_.begin(),
+                       this->watched_.begin() + numKnown);
+  this->named_.erase(
+      std::remove_if(this->named_.begin(), this->named_.end(),
+                     [&pids](int pid) {
+                       return !std::binary_search(pids.begin(), pids.end(),
+                                                  pid);
+                     }),
+      this->named_.end());
+}
+
+/**
+ *  @brief  Parses the pids of the -p option.
+ *  @param  list  Comma separated pids, e.g. "12,345".
+ *
+ *  @returns The pids in the order listed.
+ *  @throws std::invalid_argument for malformed lists.
+ */
+vector<int> ProcessWatch::ParsePids(const string& list) {
+  vector<int> pids;
+  std::istringstream items(list);
+  string item;
+  while (std::getline(items, item, ',')) {
+    int pid = 0;
+    const char* end = item.data() + item.size();
+    const auto [last, error] = std::from_chars(item.data(), end, pid);
+    if (error != std::errc() || last != end || pid <= 0) {
+      throw std::invalid_argument("bad pid list: " + list);
+    }
+    pids.push_back(pid);
+  }
+  if (pids.empty()) {
+    throw std::invalid_argument("bad pid list: " + list);
+  }
+  return pids;
+}
+
+// Finds the processes whose command name is one of the watched names, from a
+// scan of every process.
+void ProcessWatch::ResolveNames() {
+  vector<int> all;
+  LinuxParser::Pids(this->procs_dir_path_, all);
+  this->named_.clear();
+  string comm;
+  long startTime;
+  char path[PATH_MAX];
+  for (const int pid : all) {
+    std::snprintf(path, sizeof(path), "%s/%d/stat",
+                  this->procs_dir_path_.c_str(), pid);
+    if (!LinuxParser::ProcessIdentity(path, comm, startTime)) {
+      continue;
+    }
+    for (const string& name : this->target_.names) {
+      if (std::string_view(name).substr(0, kMaxCommLength) == comm) {
+        this->named_.push_back(pid);
+        break;
+      }
+    }
+  }
+  this->resolved_ = true;
+}
+
+void ProcessWatch::AddCgroup(const string& dirPath) {
+  AddPids((dirPath + "/" + kCgroupProcsFilename).c_str());
+  const int fd = open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  // The child groups are collected first, as descending into them reuses the
+  // buffer.
+  vector<string> children;
+  this->buffer_.resize(kBufferBytes);
+  LinuxParser::ForEachEntry(fd, this->buffer_.data(), this->buffer_.size(),
+                            [&children](const dirent64& entry) {
+                              if (entry.d_type == DT_DIR &&
+                                  !IsDots(entry.d_name)) {
+                                children.emplace_back(entry.d_name);
+                              }
+                            });
+  close(fd);
+  for (const string& child : children) {
+    AddCgroup(dirPath + "/" + child);
+  }
+}
+
+bool ProcessWatch::AddChildren(int pid) {
+  char tasksPath[PATH_MAX];
+  std::snprintf(tasksPath, sizeof(tasksPath), "%s/%d/task",
+                this->procs_dir_path_.c_str(), pid);
+  const int fd = open(tasksPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  this->buffer_.resize(kBufferBytes);
+  LinuxParser::ForEachEntry(
+      fd, this->buffer_.data(), this->buffer_.size(),
+      [this, &tasksPath](const dirent64& entry) {
+        if (IsDots(entry.d_name)) {
+          return;
+        }
+        char childrenPath[PATH_MAX];
+        std::snprintf(childrenPath, sizeof(childrenPath), "%s/%s/children",
+                      tasksPath, entry.d_name);
+        AddPids(childrenPath);
+      });
+  close(fd);
+  return true;
+}
+
+bool ProcessWatch::StartTime(int pid, long& startTime) {
+  char path[PATH_MAX];
+  std::snprintf(path, sizeof(path), "%s/%d/stat", this->procs_dir_path_.c_str(),
+                pid);
+  return LinuxParser::ProcessIdentity(path, this->comm_, startTime);
+}
+
+bool ProcessWatch::AddPids(const char* filePath) {
+  if (!LinuxParser::ReadFile(filePath, this->contents_)) {
+    return false;
+  }
+  const char* next = this->contents_.data();
+  const char* end = next + this->contents_.size();
+  while (next < end) {
+    if (std::isspace(static_cast<unsigned char>(*next))) {
+      ++next;
+      continue;
+    }
+    int pid = 0;
+    const auto [last, error] = std::from_chars(next, end, pid);
+    if (error != std::errc()) {
+      return false;
+    }
+    this->queue_.push_back(pid);
+    next = last;
+  }
+  return true;
+}
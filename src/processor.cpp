@@ -1,13 +1,40 @@
 #include "processor.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 
 #include "linux_parser.h"
 
 float Processor::Utilization() {
-  return (float)LinuxParser::ActiveJiffies(this->cpu_stats_file_path_) /
-         (float)LinuxParser::Jiffies(this->cpu_stats_file_path_);
+  const auto now = std::chrono::steady_clock::now();
+  if (this->total_jiffies_ >= 0 && now - this->sampled_ < kMinSampleInterval) {
+    return this->utilization_;
+  }
+  this->sampled_ = now;
+  long active = 0;
+  long idle = 0;
+  LinuxParser::CpuJiffies(this->cpu_stats_file_path_, active, idle);
+  const long total = active + idle;
+  if (this->total_jiffies_ < 0 || total < this->total_jiffies_) {
+    this->utilization_ = (float)active / (float)total;
+  } else if (total > this->total_jiffies_) {
+    this->utilization_ = (float)(active - this->active_jiffies_) /
+                         (float)(total - this->total_jiffies_);
+  }
+  this->active_jiffies_ = active;
+  this->total_jiffies_ = total;
+  return this->utilization_;
+}
+
+std::pair<long, long> Processor::Counters() const {
+  return {this->active_jiffies_, this->total_jiffies_};
+}
+
+void Processor::Restore(long activeJiffies, long totalJiffies) {
+  this->active_jiffies_ = activeJiffies;
+  this->total_jiffies_ = totalJiffies;
+  this->sampled_ = std::chrono::steady_clock::time_point();
 }
 
 bool Processor::operator==(Processor b) const {
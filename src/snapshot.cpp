@@ -0,0 +1,201 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "process.h"
+
+using std::string;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the snapshot region requires lock-free 64 bit atomics");
+
+// Copies a string into a fixed size field, truncating it if needed.
+static void CopyField(char* field, size_t size, std::string_view value) {
+  const size_t length = std::min(size - 1, value.size());
+  std::memcpy(field, value.data(), length);
+  field[length] = '\0';
+}
+
+// Whether the region under `name` was left behind by a collector that is no
+// longer running.
+static bool Abandoned(const string& name) {
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat status;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &status) == 0 &&
+      size_t(status.st_size) >= sizeof(SnapshotRegion)) {
+    mapping =
+        mmap(nullptr, sizeof(SnapshotRegion), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  const auto* region = static_cast<const SnapshotRegion*>(mapping);
+  const bool abandoned =
+      region->magic.load(std::memory_order_acquire) == SnapshotRegion::kMagic &&
+      region->version == SnapshotRegion::kVersion &&
+      kill(region->publisher, 0) != 0 && errno == ESRCH;
+  munmap(mapping, sizeof(SnapshotRegion));
+  return abandoned;
+}
+
+SnapshotPublisher::SnapshotPublisher(const string& name) : name_(name) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0 && errno == EEXIST && Abandoned(name)) {
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  }
+  if (fd < 0 && errno == EEXIST) {
+    throw std::runtime_error("a snapshot is already published at " + name);
+  }
+  if (fd < 0) {
+    throw std::runtime_error("could not create shared memory " + name + ": " +
+                             std::strerror(errno));
+  }
+  if (ftruncate(fd, sizeof(SnapshotRegion)) != 0) {
+    close(fd);
+    throw std::runtime_error("could not size shared memory " + name);
+  }
+  void* mapping = mmap(nullptr, sizeof(SnapshotRegion), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("could not map shared memory " + name);
+  }
+  this->region_ = static_cast<SnapshotRegion*>(mapping);
+  // Readers check the magic number last, after the rest of the header.
+  this->region_->magic.store(0, std::memory_order_relaxed);
+  this->region_->version = SnapshotRegion::kVersion;
+  this->region_->publisher = getpid();
+  this->region_->generation.store(0, std::memory_order_relaxed);
+  for (auto& slot : this->region_->slots) {
+    slot.sequence.store(0, std::memory_order_relaxed);
+  }
+  std::memset(&this->data_, 0, sizeof(this->data_));
+  Publish(this->data_);
+  this->region_->magic.store(SnapshotRegion::kMagic, std::memory_order_release);
+}
+
+SnapshotPublisher::~SnapshotPublisher() {
+  munmap(this->region_, sizeof(SnapshotRegion));
+  shm_unlink(this->name_.c_str());
+}
+
+void SnapshotPublisher::Publish(System& system) {
+  Publish(system, system.Processes());
+}
+
+void SnapshotPublisher::Publish(System& system,
+                                std::vector<Process>& processes) {
+  SnapshotData& data = this->data_;
+  data.cpu_utilization = system.Cpu().Utilization();
+  data.memory_utilization = system.MemoryUtilization();
+  data.uptime = system.UpTime();
+  data.total_processes = system.TotalProcesses();
+  data.running_processes = system.RunningProcesses();
+  data.blocked_processes = system.BlockedProcesses();
+  CopyField(data.kernel, sizeof(data.kernel), system.Kernel());
+  CopyField(data.operating_system, sizeof(data.operating_system),
+            system.OperatingSystem());
+  data.num_processes =
+      std::min(int(processes.size()), kMaxSnapshotProcesses);
+  for (int i = 0; i < data.num_processes; ++i) {
+    Process& process = processes[i];
+    SnapshotProcess& record = data.processes[i];
+    record.pid = process.Pid();
+    record.ppid = process.Ppid();
+    record.cpu_utilization = process.CpuUtilization();
+    record.virtual_memory_kb = process.VirtualMemoryKb();
+    record.uptime = process.UpTime();
+    CopyField(record.user, sizeof(record.user), process.User());
+    CopyField(record.command, sizeof(record.command), process.Command());
+  }
+  Publish(data);
+}
+
+void SnapshotPublisher::Publish(const SnapshotData& data) {
+  const uint64_t generation =
+      this->region_->generation.load(std::memory_order_relaxed) + 1;
+  SnapshotRegion::Slot& slot = this->region_->slots[generation % 2];
+  const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.data, &data, sizeof(SnapshotData));
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+  this->region_->generation.store(generation, std::memory_order_release);
+}
+
+SnapshotReader::SnapshotReader(const string& name) {
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    throw std::runtime_error("no snapshot is published at " + name);
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      size_t(status.st_size) < sizeof(SnapshotRegion)) {
+    close(fd);
+    throw std::runtime_error("shared memory " + name + " is not a snapshot");
+  }
+  // Anyone may create the region first, so only a collector run by this user
+  // or by root, that no one else can write to, is trusted.
+  if ((status.st_uid != geteuid() && status.st_uid != 0) ||
+      (status.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+    close(fd);
+    throw std::runtime_error("shared memory " + name +
+                             " is not owned by this user or root");
+  }
+  void* mapping =
+      mmap(nullptr, sizeof(SnapshotRegion), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("could not map shared memory " + name);
+  }
+  this->region_ = static_cast<const SnapshotRegion*>(mapping);
+  if (this->region_->magic.load(std::memory_order_acquire) !=
+          SnapshotRegion::kMagic ||
+      this->region_->version != SnapshotRegion::kVersion) {
+    munmap(const_cast<SnapshotRegion*>(this->region_), sizeof(SnapshotRegion));
+    throw std::runtime_error("shared memory " + name + " is not a snapshot");
+  }
+}
+
+SnapshotReader::~SnapshotReader() {
+  munmap(const_cast<SnapshotRegion*>(this->region_), sizeof(SnapshotRegion));
+}
+
+uint64_t SnapshotReader::Generation() const {
+  return this->region_->generation.load(std::memory_order_acquire);
+}
+
+uint64_t SnapshotReader::Read(SnapshotData& data) const {
+  while (true) {
+    const uint64_t generation = Generation();
+    const SnapshotRegion::Slot& slot = this->region_->slots[generation % 2];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence % 2 == 1) {
+      continue;
+    }
+    std::memcpy(&data, &slot.data, sizeof(SnapshotData));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      return generation;
+    }
+  }
+}
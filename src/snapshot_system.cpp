@@ -0,0 +1,146 @@
+#include "snapshot_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "process.h"
+#include "snapshot.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+// The region may have been written by anyone who could create it, so a field
+// is only read up to its size, terminated or not.
+template <std::size_t N>
+string Field(const char (&field)[N]) {
+  return string(field, strnlen(field, N));
+}
+}  // namespace
+
+SnapshotSystem::SnapshotSystem(const string& name)
+    : System(Processor("shm:" + name)),
+      reader_(name),
+      data_(std::make_unique<SnapshotData>()),
+      snapshot_cpu_("shm:" + name) {
+  this->generation_ = this->reader_.Read(*this->data_);
+}
+
+// Copies the latest snapshot if the collector has published a new one since
+// the last call. This is a single atomic load when nothing changed.
+void SnapshotSystem::Refresh() {
+  if (this->reader_.Generation() == this->generation_) {
+    return;
+  }
+  this->generation_ = this->reader_.Read(*this->data_);
+}
+
+Processor& SnapshotSystem::Cpu() {
+  Refresh();
+  this->snapshot_cpu_.SetUtilization(this->data_->cpu_utilization);
+  return this->snapshot_cpu_;
+}
+
+vector<Process>& SnapshotSystem::Processes() {
+  Refresh();
+  this->processes_.clear();
+  std::unordered_set<int> live;
+  const int count =
+      std::clamp(this->data_->num_processes, 0, kMaxSnapshotProcesses);
+  for (int i = 0; i < count; ++i) {
+    const SnapshotProcess& record = this->data_->processes[i];
+    this->processes_.emplace_back(record.pid, record.ppid, Field(record.user),
+                                  Field(record.command),
+                                  record.cpu_utilization,
+                                  record.virtual_memory_kb, record.uptime);
+    live.insert(record.pid);
+    if (this->tree_.Parent(record.pid) != record.ppid) {
+      this->tree_.Insert(record.pid, record.ppid);
+    }
+  }
+  for (const int pid : this->known_pids_) {
+    if (!live.count(pid)) {
+      this->tree_.Remove(pid);
+      this->groups_.Remove(pid);
+    }
+  }
+  this->known_pids_.swap(live);
+  return this->processes_;
+}
+
+// A snapshot is always complete.
+vector<Process>& SnapshotSystem::Processes(
+    std::chrono::steady_clock::time_point) {
+  return Processes();
+}
+
+ScanProgress SnapshotSystem::Progress() {
+  return {this->processes_.size(), this->processes_.size()};
+}
+
+float SnapshotSystem::MemoryUtilization() {
+  Refresh();
+  return this->data_->memory_utilization;
+}
+
+long SnapshotSystem::UpTime() {
+  Refresh();
+  return this->data_->uptime;
+}
+
+int SnapshotSystem::TotalProcesses() {
+  Refresh();
+  return this->data_->total_processes;
+}
+
+int SnapshotSystem::RunningProcesses() {
+  Refresh();
+  return this->data_->running_processes;
+}
+
+int SnapshotSystem::BlockedProcesses() {
+  Refresh();
+  return this->data_->blocked_processes;
+}
+
+// Copied out of the shared memory, into a string that keeps its capacity.
+const string& SnapshotSystem::Kernel() {
+  Refresh();
+  this->kernelName_ = Field(this->data_->kernel);
+  return this->kernelName_;
+}
+
+const string& SnapshotSystem::OperatingSystem() {
+  Refresh();
+  this->osName_ = Field(this->data_->operating_system);
+  return this->osName_;
+}
+
+// Cgroups are not part of the snapshot.
+vector<CgroupStats>& SnapshotSystem::Cgroups() { return this->cgroups_; }
+
+void SnapshotSystem::SetFilter(ProcessFilter filter) {
+  if (!filter.Empty()) {
+    throw std::invalid_argument("the collector applies filters, not --attach");
+  }
+}
+
+ProcessTree& SnapshotSystem::Tree() {
+  for (Process& process : this->processes_) {
+    this->tree_.Update(process);
+  }
+  return this->tree_;
+}
+
+ProcessGroups& SnapshotSystem::Groups() {
+  for (Process& process : this->processes_) {
+    this->groups_.Update(process);
+  }
+  return this->groups_;
+}
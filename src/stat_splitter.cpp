@@ -0,0 +1,232 @@
+#include "stat_splitter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STAT_SPLITTER_X86 1
+#endif
+
+using StatSplitter::Fields;
+using StatSplitter::Isa;
+
+namespace {
+constexpr std::size_t kMaxLineSize = UINT16_MAX;
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n'; }
+
+bool SplitScalar(std::string_view line, std::size_t maxFields,
+                 Fields& fields) {
+  fields.count = 0;
+  const std::size_t commEnd = line.rfind(')');
+  if (commEnd == std::string_view::npos || line.size() >= kMaxLineSize) {
+    return false;
+  }
+  fields.comm_end = commEnd;
+  maxFields = std::min(maxFields, StatSplitter::kMaxFields);
+  std::size_t position = commEnd + 1;
+  while (fields.count < maxFields) {
+    while (position < line.size() && IsSpace(line[position])) {
+      ++position;
+    }
+    if (position == line.size()) {
+      break;
+    }
+    fields.begin[fields.count] = position;
+    while (position < line.size() && !IsSpace(line[position])) {
+      ++position;
+    }
+    fields.end[fields.count++] = position;
+  }
+  return true;
+}
+
+#ifdef STAT_SPLITTER_X86
+// The boundaries of the fields in a block of `Width` bytes at `base`, given
+// the mask of its delimiters. `inField` tells whether the previous block ended
+// within a field, and `starts` counts the fields begun. Returns false once
+// `maxFields` fields are complete.
+template <int Width>
+inline bool AddBoundaries(uint32_t delimiters, std::size_t base,
+                          std::size_t maxFields, bool& inField,
+                          std::size_t& starts, Fields& fields) {
+  constexpr uint32_t kBlockMask = Width == 32 ? ~0u : (1u << Width) - 1;
+  const uint32_t data = ~delimiters & kBlockMask;
+  const uint32_t previous = (data << 1) | uint32_t(inField);
+  uint32_t begins = data & ~previous;
+  uint32_t ends = ~data & previous & kBlockMask;
+  inField = (data >> (Width - 1)) & 1;
+  for (; begins != 0 && starts < maxFields; begins &= begins - 1) {
+    fields.begin[starts++] = base + __builtin_ctz(begins);
+  }
+  for (; ends != 0; ends &= ends - 1) {
+    fields.end[fields.count++] = base + __builtin_ctz(ends);
+    if (fields.count == maxFields) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline uint32_t Delimiters(__m128i block) {
+  const __m128i spaces =
+      _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                   _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')),
+                                _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+  return uint32_t(_mm_movemask_epi8(spaces));
+}
+
+std::size_t FindCommEndSse2(std::string_view line) {
+  std::size_t end = line.size();
+  for (; end >= 16; end -= 16) {
+    const __m128i block = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(line.data() + end - 16));
+    const uint32_t parens =
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(')')));
+    if (parens != 0) {
+      return end - 16 + (31 - __builtin_clz(parens));
+    }
+  }
+  return line.substr(0, end).rfind(')');
+}
+
+bool SplitSse2(std::string_view line, std::size_t maxFields, Fields& fields) {
+  fields.count = 0;
+  const std::size_t commEnd = FindCommEndSse2(line);
+  if (commEnd == std::string_view::npos || line.size() >= kMaxLineSize) {
+    return false;
+  }
+  fields.comm_end = commEnd;
+  maxFields = std::min(maxFields, StatSplitter::kMaxFields);
+  if (maxFields == 0) {
+    return true;
+  }
+  bool inField = false;
+  std::size_t starts = 0;
+  std::size_t position = commEnd + 1;
+  for (; position + 16 <= line.size(); position += 16) {
+    const __m128i block = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(line.data() + position));
+    if (!AddBoundaries<16>(Delimiters(block), position, maxFields, inField,
+                           starts, fields)) {
+      return true;
+    }
+  }
+  // The rest, padded with spaces to end its last field.
+  char tail[16];
+  std::memset(tail, ' ', sizeof(tail));
+  std::memcpy(tail, line.data() + position, line.size() - position);
+  AddBoundaries<16>(
+      Delimiters(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tail))),
+      position, maxFields, inField, starts, fields);
+  return true;
+}
+
+__attribute__((target("avx2"))) inline uint32_t Delimiters(__m256i block) {
+  const __m256i spaces = _mm256_or_si256(
+      _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+      _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')),
+                      _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))));
+  return uint32_t(_mm256_movemask_epi8(spaces));
+}
+
+__attribute__((target("avx2"))) std::size_t FindCommEndAvx2(
+    std::string_view line) {
+  std::size_t end = line.size();
+  for (; end >= 32; end -= 32) {
+    const __m256i block = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(line.data() + end - 32));
+    const uint32_t parens = uint32_t(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(')'))));
+    if (parens != 0) {
+      return end - 32 + (31 - __builtin_clz(parens));
+    }
+  }
+  return line.substr(0, end).rfind(')');
+}
+
+__attribute__((target("avx2"))) bool SplitAvx2(std::string_view line,
+                                               std::size_t maxFields,
+                                               Fields& fields) {
+  fields.count = 0;
+  const std::size_t commEnd = FindCommEndAvx2(line);
+  if (commEnd == std::string_view::npos || line.size() >= kMaxLineSize) {
+    return false;
+  }
+  fields.comm_end = commEnd;
+  maxFields = std::min(maxFields, StatSplitter::kMaxFields);
+  if (maxFields == 0) {
+    return true;
+  }
+  bool inField = false;
+  std::size_t starts = 0;
+  std::size_t position = commEnd + 1;
+  for (; position + 32 <= line.size(); position += 32) {
+    const __m256i block = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(line.data() + position));
+    if (!AddBoundaries<32>(Delimiters(block), position, maxFields, inField,
+                           starts, fields)) {
+      return true;
+    }
+  }
+  // The rest, padded with spaces to end its last field.
+  char tail[32];
+  std::memset(tail, ' ', sizeof(tail));
+  std::memcpy(tail, line.data() + position, line.size() - position);
+  AddBoundaries<32>(
+      Delimiters(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail))),
+      position, maxFields, inField, starts, fields);
+  return true;
+}
+#endif
+
+Isa Detect() {
+#ifdef STAT_SPLITTER_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return Isa::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return Isa::kSse2;
+  }
+#endif
+  return Isa::kScalar;
+}
+}  // namespace
+
+Isa StatSplitter::Selected() {
+  static const Isa isa = Detect();
+  return isa;
+}
+
+bool StatSplitter::Supported(Isa isa) {
+  switch (Selected()) {
+    case Isa::kAvx2:
+      return true;
+    case Isa::kSse2:
+      return isa != Isa::kAvx2;
+    case Isa::kScalar:
+      break;
+  }
+  return isa == Isa::kScalar;
+}
+
+bool StatSplitter::Split(Isa isa, std::string_view line,
+                         std::size_t maxFields, Fields& fields) {
+#ifdef STAT_SPLITTER_X86
+  if (isa == Isa::kAvx2 && Supported(isa)) {
+    return SplitAvx2(line, maxFields, fields);
+  }
+  if (isa == Isa::kSse2 && Supported(isa)) {
+    return SplitSse2(line, maxFields, fields);
+  }
+#endif
+  return SplitScalar(line, maxFields, fields);
+}
+
+bool StatSplitter::Split(std::string_view line, std::size_t maxFields,
+                         Fields& fields) {
+  return Split(Selected(), line, maxFields, fields);
+}
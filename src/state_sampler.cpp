@@ -0,0 +1,165 @@
+#include "state_sampler.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+namespace {
+// "<pid> (<command>) <state>": pids have at most 7 digits and the kernel keeps
+// 15 characters of the command.
+const std::size_t kStatPrefixBytes = 64;
+}  // namespace
+
+void RunStates::Add(char state) {
+  switch (state) {
+    case 'R':
+      ++this->running;
+      break;
+    case 'S':
+    case 'I':
+      ++this->sleeping;
+      break;
+    case 'D':
+      ++this->blocked;
+      break;
+    case 'Z':
+      ++this->zombie;
+      break;
+    default:
+      ++this->other;
+      break;
+  }
+}
+
+StateSampler::StateSampler(std::string procsDirPath,
+                           std::chrono::milliseconds interval)
+    : procs_dir_path_(std::move(procsDirPath)), interval_(interval) {}
+
+StateSampler::~StateSampler() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stop_ = true;
+  }
+  this->wake_.notify_one();
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+  for (const auto& [pid, fd] : this->files_) {
+    close(fd);
+  }
+}
+
+void StateSampler::Start() {
+  // Like the fd sampler, the thread blocks every signal, so that they reach
+  // the display's handlers.
+  sigset_t all;
+  sigset_t previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+  this->thread_ = std::thread(&StateSampler::Run, this);
+  pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+void StateSampler::Tick(const vector<int>& pids) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->pids_.assign(
+      pids.begin(),
+      pids.begin() + std::min(pids.size(), kMaxCandidates));
+  std::sort(this->pids_.begin(), this->pids_.end());
+  this->last_.swap(this->current_);
+  this->current_.clear();
+}
+
+RunStates StateSampler::Get(int pid) const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  const auto it = this->last_.find(pid);
+  return it == this->last_.end() ? RunStates() : it->second;
+}
+
+/**
+ *  @brief  Reads the state of every candidate once.
+ *
+ *  Files are opened the first time a pid is sampled and kept open while it
+ * is a candidate. A failed read closes the file, which is opened again by
+ * the next step in case the pid was reused.
+ */
+void StateSampler::Step() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->step_pids_.assign(this->pids_.begin(), this->pids_.end());
+  }
+  for (auto it = this->files_.begin(); it != this->files_.end();) {
+    if (std::binary_search(this->step_pids_.begin(), this->step_pids_.end(),
+                           it->first)) {
+      ++it;
+      continue;
+    }
+    close(it->second);
+    it = this->files_.erase(it);
+  }
+  this->states_.clear();
+  for (const int pid : this->step_pids_) {
+    auto it = this->files_.find(pid);
+    if (it == this->files_.end()) {
+      char path[PATH_MAX];
+      std::snprintf(path, sizeof(path), "%s/%d/stat",
+                    this->procs_dir_path_.c_str(), pid);
+      const int fd = open(path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        continue;
+      }
+      it = this->files_.emplace(pid, fd).first;
+    }
+    const char state = ReadState(it->second);
+    if (state == '\0') {
+      close(it->second);
+      this->files_.erase(it);
+      continue;
+    }
+    this->states_.emplace_back(pid, state);
+  }
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  for (const auto& [pid, state] : this->states_) {
+    this->current_[pid].Add(state);
+  }
+}
+
+char StateSampler::ReadState(int fd) {
+  char buffer[kStatPrefixBytes];
+  const ssize_t size = pread(fd, buffer, sizeof(buffer), 0);
+  if (size <= 0) {
+    return '\0';
+  }
+  // The command may hold parentheses, the state follows the last one.
+  const std::string_view prefix(buffer, size);
+  const std::size_t end = prefix.rfind(')');
+  if (end == std::string_view::npos || end + 2 >= prefix.size()) {
+    return '\0';
+  }
+  return prefix[end + 2];
+}
+
+void StateSampler::Run() {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point next = Clock::now();
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (!this->wake_.wait_until(lock, next, [this] { return this->stop_; })) {
+    lock.unlock();
+    Step();
+    lock.lock();
+    // A step that overran its interval is not caught up with.
+    next = std::max(next + this->interval_, Clock::now());
+  }
+}
@@ -0,0 +1,167 @@
+#include "string_table.h"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+StringTable::StringTable() {
+  // Handle 0 is reserved for the empty string.
+  this->entries_.push_back({0, 0, 0, 0});
+  this->chunks_.push_back(
+      {std::make_unique<char[]>(kChunkSize), kChunkSize, 0, 0});
+  this->current_chunk_ = 0;
+}
+
+StringTable& StringTable::Global() {
+  static StringTable table;
+  return table;
+}
+
+StringTable::Handle StringTable::Intern(std::string_view value) {
+  if (value.empty()) {
+    return kEmpty;
+  }
+  const auto found = this->index_.find(value);
+  if (found != this->index_.end()) {
+    ++this->entries_[found->second].references;
+    return found->second;
+  }
+  const uint32_t chunk = Allocate(value.size() + 1);
+  Chunk& storage = this->chunks_[chunk];
+  const uint32_t offset = storage.used;
+  std::memcpy(storage.data.get() + offset, value.data(), value.size());
+  storage.data[offset + value.size()] = '\0';
+  storage.used += value.size() + 1;
+  ++storage.live;
+
+  Handle handle;
+  if (!this->free_handles_.empty()) {
+    handle = this->free_handles_.back();
+    this->free_handles_.pop_back();
+  } else {
+    handle = this->entries_.size();
+    this->entries_.emplace_back();
+  }
+  this->entries_[handle] = {chunk, offset, uint32_t(value.size()), 1};
+  this->index_.emplace(View(handle), handle);
+  return handle;
+}
+
+void StringTable::Retain(Handle handle) {
+  if (handle != kEmpty) {
+    ++this->entries_[handle].references;
+  }
+}
+
+void StringTable::Release(Handle handle) {
+  if (handle == kEmpty || --this->entries_[handle].references > 0) {
+    return;
+  }
+  this->index_.erase(View(handle));
+  const uint32_t chunk = this->entries_[handle].chunk;
+  this->entries_[handle] = {0, 0, 0, 0};
+  this->free_handles_.push_back(handle);
+  Chunk& storage = this->chunks_[chunk];
+  if (--storage.live == 0) {
+    // Nothing in the chunk is referenced any more, so it can be reused.
+    storage.used = 0;
+    if (chunk != this->current_chunk_) {
+      this->free_chunks_.push_back(chunk);
+    }
+  }
+}
+
+std::string_view StringTable::View(Handle handle) const {
+  const Entry& entry = this->entries_[handle];
+  if (entry.length == 0) {
+    return std::string_view();
+  }
+  return std::string_view(this->chunks_[entry.chunk].data.get() + entry.offset,
+                          entry.length);
+}
+
+std::size_t StringTable::Size() const { return this->index_.size(); }
+
+std::size_t StringTable::ArenaBytes() const {
+  std::size_t bytes = 0;
+  for (const Chunk& chunk : this->chunks_) {
+    bytes += chunk.capacity;
+  }
+  return bytes;
+}
+
+// Finds room for `size` bytes, moving on to a recycled or new chunk when the
+// current one is full. Strings longer than a chunk get a chunk of their own.
+uint32_t StringTable::Allocate(std::size_t size) {
+  Chunk& current = this->chunks_[this->current_chunk_];
+  if (current.used + size <= current.capacity) {
+    return this->current_chunk_;
+  }
+  if (current.live == 0) {
+    current.used = 0;
+    if (size <= current.capacity) {
+      return this->current_chunk_;
+    }
+  }
+  if (size <= kChunkSize && !this->free_chunks_.empty()) {
+    const uint32_t previous = this->current_chunk_;
+    this->current_chunk_ = this->free_chunks_.back();
+    this->free_chunks_.pop_back();
+    if (this->chunks_[previous].live == 0) {
+      this->free_chunks_.push_back(previous);
+    }
+    return this->current_chunk_;
+  }
+  const std::size_t capacity = size > kChunkSize ? size : kChunkSize;
+  this->chunks_.push_back(
+      {std::make_unique<char[]>(capacity), capacity, 0, 0});
+  const uint32_t chunk = this->chunks_.size() - 1;
+  if (size > kChunkSize) {
+    return chunk;
+  }
+  if (this->chunks_[this->current_chunk_].live == 0) {
+    this->free_chunks_.push_back(this->current_chunk_);
+  }
+  this->current_chunk_ = chunk;
+  return chunk;
+}
+
+InternedString::InternedString(std::string_view value)
+    : handle_(StringTable::Global().Intern(value)) {}
+
+InternedString::InternedString(const InternedString& other)
+    : handle_(other.handle_) {
+  StringTable::Global().Retain(this->handle_);
+}
+
+InternedString::InternedString(InternedString&& other) noexcept
+    : handle_(std::exchange(other.handle_, StringTable::kEmpty)) {}
+
+InternedString& InternedString::operator=(const InternedString& other) {
+  StringTable::Global().Retain(other.handle_);
+  StringTable::Global().Release(this->handle_);
+  this->handle_ = other.handle_;
+  return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& other) noexcept {
+  if (this != &other) {
+    StringTable::Global().Release(this->handle_);
+    this->handle_ = std::exchange(other.handle_, StringTable::kEmpty);
+  }
+  return *this;
+}
+
+InternedString::~InternedString() { StringTable::Global().Release(this->handle_); }
+
+std::string_view InternedString::View() const {
+  return StringTable::Global().View(this->handle_);
+}
+
+StringTable::Handle InternedString::Handle() const { return this->handle_; }
+
+bool InternedString::operator==(const InternedString& other) const {
+  return this->handle_ == other.handle_;
+}
@@ -0,0 +1,225 @@
+#include "warm_state.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "linux_parser.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+const char kStateFileName[] = "monitor-state";
+// The smallest encodings of a uid map entry (two empty strings), a string
+// and a process.
+const size_t kMinUidEntryBytes = 2 * sizeof(uint32_t);
+const size_t kMinStringBytes = sizeof(uint32_t);
+const size_t kProcessBytes = sizeof(int32_t) + 2 * sizeof(int64_t) +
+                             sizeof(double) + 2 * sizeof(uint32_t);
+
+class Writer {
+ public:
+  template <typename T>
+  void Put(T value) {
+    this->buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void Put(const string& value) {
+    Put<uint32_t>(value.size());
+    this->buffer_.append(value);
+  }
+  const string& Buffer() const { return this->buffer_; }
+
+ private:
+  string buffer_;
+};
+
+// Reads values back, failing (for good) on the first read past the end.
+class Reader {
+ public:
+  explicit Reader(const string& buffer) : buffer_(buffer) {}
+  template <typename T>
+  bool Get(T& value) {
+    if (this->buffer_.size() - this->position_ < sizeof(value)) {
+      return false;
+    }
+    std::memcpy(&value, this->buffer_.data() + this->position_, sizeof(value));
+    this->position_ += sizeof(value);
+    return true;
+  }
+  bool Get(string& value) {
+    uint32_t size;
+    if (!Get(size) || this->buffer_.size() - this->position_ < size) {
+      return false;
+    }
+    value.assign(this->buffer_, this->position_, size);
+    this->position_ += size;
+    return true;
+  }
+  bool AtEnd() const { return this->position_ == this->buffer_.size(); }
+  // Whether the rest of the buffer can hold `count` entries of at least
+  // `minBytes` each, so that a corrupt count is caught before anything is
+  // allocated for it.
+  bool Holds(uint32_t count, size_t minBytes) const {
+    return count <= (this->buffer_.size() - this->position_) / minBytes;
+  }
+
+ private:
+  const string& buffer_;
+  size_t position_{0};
+};
+}  // namespace
+
+std::filesystem::path WarmStart::DefaultPath() {
+  const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+  if (runtimeDir == nullptr || runtimeDir[0] == '\0') {
+    return std::filesystem::path();
+  }
+  return std::filesystem::path(runtimeDir) / kStateFileName;
+}
+
+bool WarmStart::Save(const WarmState& state,
+                     const std::filesystem::path& filePath) {
+  Writer writer;
+  writer.Put(kMagic);
+  writer.Put(kVersion);
+  writer.Put(state.boot_id);
+  writer.Put(state.time);
+  writer.Put<int64_t>(state.cpu_active_jiffies);
+  writer.Put<int64_t>(state.cpu_total_jiffies);
+  writer.Put<int64_t>(state.passwd_mtime);
+  writer.Put<uint32_t>(state.uid_map.size());
+  for (const auto& [uid, user] : state.uid_map) {
+    writer.Put(uid);
+    writer.Put(user);
+  }
+  // Every distinct user and command once, referenced by index.
+  vector<const string*> strings;
+  std::unordered_map<string, uint32_t> indices;
+  const auto index = [&strings, &indices](const string& value) {
+    const auto [it, added] = indices.emplace(value, strings.size());
+    if (added) {
+      strings.push_back(&it->first);
+    }
+    return it->second;
+  };
+  vector<std::pair<uint32_t, uint32_t>> references;
+  for (const WarmProcess& process : state.processes) {
+    const uint32_t user = index(process.user);
+    references.emplace_back(user, index(process.command));
+  }
+  writer.Put<uint32_t>(strings.size());
+  for (const string* value : strings) {
+    writer.Put(*value);
+  }
+  writer.Put<uint32_t>(state.processes.size());
+  for (size_t i = 0; i < state.processes.size(); ++i) {
+    const WarmProcess& process = state.processes[i];
+    writer.Put<int32_t>(process.pid);
+    writer.Put<int64_t>(process.start_time);
+    writer.Put<int64_t>(process.total_ticks);
+    writer.Put(process.sample_time);
+    writer.Put(references[i].first);
+    writer.Put(references[i].second);
+  }
+
+  const string temporary = filePath.string() + ".tmp";
+  const int fd =
+      open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  const string& buffer = writer.Buffer();
+  size_t written = 0;
+  while (written < buffer.size()) {
+    const ssize_t count =
+        write(fd, buffer.data() + written, buffer.size() - written);
+    if (count <= 0) {
+      break;
+    }
+    written += count;
+  }
+  close(fd);
+  if (written != buffer.size() ||
+      std::rename(temporary.c_str(), filePath.c_str()) != 0) {
+    unlink(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ *  @brief  Loads a state file written by `Save`.
+ *  @param  filePath  The state file.
+ *  @param  state  Receives the state.
+ *
+ *  @returns Whether the file exists and is a complete state of this version.
+ * Whether it still applies is up to the caller, see `LinuxSystem::Restore`.
+ */
+bool WarmStart::Load(const std::filesystem::path& filePath, WarmState& state) {
+  string buffer;
+  if (!LinuxParser::ReadFile(filePath, buffer)) {
+    return false;
+  }
+  Reader reader(buffer);
+  uint32_t magic, version, count;
+  int64_t active, total, mtime;
+  if (!reader.Get(magic) || magic != kMagic || !reader.Get(version) ||
+      version != kVersion || !reader.Get(state.boot_id) ||
+      !reader.Get(state.time) || !reader.Get(active) || !reader.Get(total) ||
+      !reader.Get(mtime) || !reader.Get(count) ||
+      !reader.Holds(count, kMinUidEntryBytes)) {
+    return false;
+  }
+  state.cpu_active_jiffies = active;
+  state.cpu_total_jiffies = total;
+  state.passwd_mtime = mtime;
+  state.uid_map.clear();
+  for (uint32_t i = 0; i < count; ++i) {
+    string uid, user;
+    if (!reader.Get(uid) || !reader.Get(user)) {
+      return false;
+    }
+    state.uid_map.emplace(std::move(uid), std::move(user));
+  }
+  if (!reader.Get(count) || !reader.Holds(count, kMinStringBytes)) {
+    return false;
+  }
+  vector<string> strings(count);
+  for (string& value : strings) {
+    if (!reader.Get(value)) {
+      return false;
+    }
+  }
+  if (!reader.Get(count) || !reader.Holds(count, kProcessBytes)) {
+    return false;
+  }
+  state.processes.clear();
+  state.processes.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    WarmProcess process;
+    int32_t pid;
+    int64_t startTime, totalTicks;
+    uint32_t user, command;
+    if (!reader.Get(pid) || !reader.Get(startTime) || !reader.Get(totalTicks) ||
+        !reader.Get(process.sample_time) || !reader.Get(user) ||
+        !reader.Get(command) || user >= strings.size() ||
+        command >= strings.size()) {
+      return false;
+    }
+    process.pid = pid;
+    process.start_time = startTime;
+    process.total_ticks = totalTicks;
+    process.user = strings[user];
+    process.command = strings[command];
+    state.processes.push_back(std::move(process));
+  }
+  return reader.AtEnd();
+}
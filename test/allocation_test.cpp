@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/headless_display.h"
+#include "../include/io_monitor.h"
+#include "../include/linux_system.h"
+#include "../include/ncurses_display.h"
+#include "../include/pressure_monitor.h"
+#include "../include/process.h"
+
+#include <curses.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+/*
+Counts the allocations of the test thread, so that a refresh that starts
+allocating again fails here rather than showing up as a slower monitor.
+*/
+namespace {
+thread_local bool counting = false;
+thread_local long allocations = 0;
+
+// An output that throws everything away, without buffering it.
+class NullBuffer : public std::streambuf {
+ protected:
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+}  // namespace
+
+void* operator new(std::size_t size) {
+  if (counting) {
+    ++allocations;
+  }
+  if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+// A refresh of the headless display: the processes are collected and ranked,
+// and the system panel and the process table are rendered.
+static void Tick(LinuxSystem& system, std::ostream& out) {
+  std::vector<Process>& processes = system.Processes();
+  HeadlessDisplay::DisplaySystem(system, out);
+  HeadlessDisplay::DisplayProcesses(processes, out, 10);
+}
+
+TEST(AllocationTest, SteadyStateTickTest) {
+  constexpr int kWarmUpTicks = 2;
+  constexpr int kTicks = 3;
+  // Past the interval, so that every tick reads the files again.
+  const auto interval = kUpdateInterval + std::chrono::milliseconds(20);
+  LinuxSystem system = FixtureSystem();
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  for (int i = 0; i < kWarmUpTicks; ++i) {
+    Tick(system, out);
+    std::this_thread::sleep_for(interval);
+  }
+  ASSERT_FALSE(system.Processes().empty());
+  for (int i = 0; i < kTicks; ++i) {
+    allocations = 0;
+    counting = true;
+    Tick(system, out);
+    counting = false;
+    EXPECT_EQ(allocations, 0) << "tick " << i;
+    std::this_thread::sleep_for(interval);
+  }
+}
+
+// Once the devices are known, the I/O rates are read into the same buffer
+// and counters.
+TEST(AllocationTest, IoMonitorUpdateTest) {
+  IoMonitor io;
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 2; ++i) {
+    now += std::chrono::seconds(1);
+    io.Update(now);
+  }
+  allocations = 0;
+  counting = true;
+  now += std::chrono::seconds(1);
+  io.Update(now);
+  counting = false;
+  EXPECT_EQ(allocations, 0);
+}
+
+// The ncurses panels, drawn on a screen that writes to /dev/null, print
+// their rows without building strings. The status line, the overhead and
+// the sparklines are not drawn here.
+TEST(AllocationTest, NCursesRenderTest) {
+  FILE* out = std::fopen("/dev/null", "w");
+  FILE* in = std::fopen("/dev/null", "r");
+  ASSERT_NE(out, nullptr);
+  ASSERT_NE(in, nullptr);
+  SCREEN* screen = newterm("xterm", out, in);
+  if (screen == nullptr) {
+    std::fclose(out);
+    std::fclose(in);
+    GTEST_SKIP() << "no terminfo entry for xterm";
+  }
+  WINDOW* window = newwin(40, 200, 0, 0);
+  LinuxSystem system = FixtureSystem();
+  PressureMonitor pressure(kTestDataDirPath / "pressure");
+  std::vector<Process>& processes = system.Processes();
+  std::vector<ProcessTree::Row>& rows = system.Tree().Rows(10);
+  std::vector<ProcessGroups::Row>& groups =
+      system.Groups().Rows(GroupBy::kUser, 10);
+  std::vector<PressureStats>& stats = pressure.Update();
+  std::vector<CgroupStats> cgroups(2);
+  cgroups[0].path = "/system.slice/a-service-with-a-long-name.service";
+  cgroups[0].cpu_limit = 1.5;
+  cgroups[1].path = "/user.slice";
+  ASSERT_FALSE(processes.empty());
+  ASSERT_FALSE(rows.empty());
+  ASSERT_FALSE(groups.empty());
+  auto render = [&]() {
+    NCursesDisplay::DisplaySystem(system, window);
+    NCursesDisplay::DisplayPressure(stats, pressure, window, 8);
+    NCursesDisplay::DisplayProcesses(processes, window, 10);
+    NCursesDisplay::DisplayTree(rows, window, rows[0].pid);
+    NCursesDisplay::DisplayCgroups(cgroups, window, 10);
+    NCursesDisplay::DisplayGroups(groups, window, GroupBy::kUser);
+  };
+  render();
+  allocations = 0;
+  counting = true;
+  render();
+  counting = false;
+  EXPECT_EQ(allocations, 0);
+  delwin(window);
+  endwin();
+  delscreen(screen);
+  std::fclose(out);
+  std::fclose(in);
+}
+
+// The counter itself works.
+TEST(AllocationTest, CountsTest) {
+  allocations = 0;
+  counting = true;
+  auto* value = new long(1);
+  counting = false;
+  delete value;
+  EXPECT_EQ(allocations, 1);
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/cgroup_view.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::filesystem::path;
+
+const path kCgroupRootPath = kTestDataDirPath / path("cgroup");
+
+class CgroupViewTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    // Rates need the counters to change between updates, so work on a copy
+    // of the fake cgroup filesystem.
+    ScratchDir::SetUp();
+    cgroup_root_ = dir_ / "cgroup";
+    std::filesystem::copy(kCgroupRootPath, cgroup_root_, std::filesystem::copy_options::recursive);
+  }
+  void SetUsage(const path& cgroup, long usage_usec) {
+    std::ofstream stream(cgroup_root_ / cgroup / path("cpu.stat"));
+    stream << "usage_usec " << usage_usec << "\n";
+  }
+  path cgroup_root_;
+  const std::vector<int> pids_{1, 75, 78, 103};
+};
+
+TEST_F(CgroupViewTest, GroupsProcessesTest) {
+  CgroupView view{kTestDataDirPath, kCgroupRootPath, 4};
+  auto& groups = view.Update(pids_);
+  ASSERT_EQ(groups.size(), 3);
+  // Without a previous sample every group reports no utilization, so they are
+  // ordered by path.
+  EXPECT_EQ(groups[0].path, "/init.scope");
+  EXPECT_EQ(groups[0].num_processes, 1);
+  EXPECT_FLOAT_EQ(groups[0].cpu_limit, 0);
+  EXPECT_EQ(groups[1].path, "/system.slice/snapd.service");
+  EXPECT_EQ(groups[1].num_processes, 2);
+  EXPECT_FLOAT_EQ(groups[1].cpu_limit, 0.5);
+  EXPECT_EQ(groups[1].memory_bytes, 8388608);
+  EXPECT_EQ(groups[2].path, "/user.slice/user-1000.slice");
+  EXPECT_FLOAT_EQ(groups[2].cpu_limit, 2);
+  EXPECT_FLOAT_EQ(groups[2].cpu_utilization, 0);
+}
+
+TEST_F(CgroupViewTest, UtilizationRelativeToQuotaTest) {
+  CgroupView view{kTestDataDirPath, cgroup_root_, 4};
+  const auto start = std::chrono::steady_clock::now();
+  view.Update(pids_, start);
+  SetUsage(path("system.slice") / path("snapd.service"), 250000 + 25000);
+  SetUsage(path("user.slice") / path("user-1000.slice"), 91000000 + 50000);
+  SetUsage(path("init.scope"), 1520000 + 40000);
+  auto& groups = view.Update(pids_, start + std::chrono::milliseconds(100));
+  ASSERT_EQ(groups.size(), 3);
+  // 25ms of a 0.5 CPU quota over 100ms.
+  EXPECT_EQ(groups[0].path, "/system.slice/snapd.service");
+  EXPECT_FLOAT_EQ(groups[0].cpu_utilization, 0.5);
+  // 50ms of a 2 CPU quota over 100ms.
+  EXPECT_EQ(groups[1].path, "/user.slice/user-1000.slice");
+  EXPECT_FLOAT_EQ(groups[1].cpu_utilization, 0.25);
+  // Unlimited groups are measured against every CPU.
+  EXPECT_EQ(groups[2].path, "/init.scope");
+  EXPECT_FLOAT_EQ(groups[2].cpu_utilization, 0.1);
+}
+
+TEST_F(CgroupViewTest, ExitedProcessesTest) {
+  CgroupView view{kTestDataDirPath, kCgroupRootPath, 4};
+  view.Update(pids_);
+  auto& groups = view.Update({75, 1234});
+  ASSERT_EQ(groups.size(), 1);
+  EXPECT_EQ(groups[0].path, "/system.slice/snapd.service");
+  EXPECT_EQ(groups[0].num_processes, 1);
+}
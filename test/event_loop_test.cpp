@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+#include "../include/event_loop.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <string>
+
+using std::chrono::milliseconds;
+
+TEST(EventLoopTest, TimerTest) {
+  EventLoop loop;
+  int ticks = 0;
+  loop.SetTimer(milliseconds(5), [&]() {
+    if (++ticks == 3) {
+      loop.Stop();
+    }
+  });
+  EXPECT_EQ(loop.Interval(), milliseconds(5));
+  const auto start = std::chrono::steady_clock::now();
+  loop.Run();
+  EXPECT_EQ(ticks, 3);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(15));
+}
+
+TEST(EventLoopTest, FdTest) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  EventLoop loop;
+  char received = 0;
+  loop.Add(fds[0], EPOLLIN, [&](uint32_t events) {
+    EXPECT_TRUE(events & EPOLLIN);
+    ASSERT_EQ(read(fds[0], &received, 1), 1);
+  });
+  EXPECT_EQ(loop.RunOnce(milliseconds(0)), 0);
+  ASSERT_EQ(write(fds[1], "q", 1), 1);
+  EXPECT_EQ(loop.RunOnce(milliseconds(100)), 1);
+  EXPECT_EQ(received, 'q');
+  loop.Remove(fds[0]);
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+  EXPECT_EQ(loop.RunOnce(milliseconds(0)), 0);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTest, RemoveWhileRunningTest) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  EventLoop loop;
+  int calls = 0;
+  loop.Add(fds[0], EPOLLIN, [&](uint32_t) {
+    ++calls;
+    loop.Remove(fds[0]);
+  });
+  ASSERT_EQ(write(fds[1], "ab", 2), 2);
+  loop.RunOnce(milliseconds(100));
+  loop.RunOnce(milliseconds(0));
+  EXPECT_EQ(calls, 1);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTest, DeferTest) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  EventLoop loop;
+  std::string order;
+  loop.Add(fds[0], EPOLLIN, [&](uint32_t) {
+    char key;
+    ASSERT_EQ(read(fds[0], &key, 1), 1);
+    order += key;
+  });
+  int slices = 0;
+  std::function<void()> slice = [&]() {
+    order += '0' + ++slices;
+    if (slices < 3) {
+      loop.Defer(slice);
+    }
+  };
+  loop.Defer(slice);
+  ASSERT_EQ(write(fds[1], "k", 1), 1);
+  // Pending tasks keep the loop from blocking.
+  const auto start = std::chrono::steady_clock::now();
+  loop.RunOnce(milliseconds(1000));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, milliseconds(500));
+  EXPECT_EQ(order, "k1");
+  // Input that arrives between slices is handled before the next one.
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+  loop.RunOnce(milliseconds(1000));
+  loop.RunOnce(milliseconds(1000));
+  EXPECT_EQ(order, "k1x23");
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTest, SignalTest) {
+  sigset_t previous;
+  sigprocmask(SIG_BLOCK, nullptr, &previous);
+  {
+    EventLoop loop;
+    int received = 0;
+    loop.HandleSignals({SIGUSR1}, [&](int signal) {
+      received = signal;
+      loop.Stop();
+    });
+    raise(SIGUSR1);
+    loop.Run();
+    EXPECT_EQ(received, SIGUSR1);
+  }
+  sigprocmask(SIG_SETMASK, &previous, nullptr);
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/fd_sampler.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::filesystem::path;
+
+// A proc filesystem of processes with a number of files in their fd
+// directories.
+class FdSamplerTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    ScratchDir::SetUp();
+    AddFds(10, 3);
+    AddFds(20, 5);
+  }
+  void AddFds(int pid, int count) {
+    const path fds = dir_ / std::to_string(pid) / "fd";
+    std::filesystem::create_directories(fds);
+    for (int fd = 0; fd < count; ++fd) {
+      std::ofstream(fds / std::to_string(1000 + fd));
+    }
+  }
+};
+
+TEST_F(FdSamplerTest, CountTest) {
+  std::vector<char> buffer;
+  EXPECT_EQ(FdSampler::Count((dir_ / "10" / "fd").c_str(), buffer), 3);
+  EXPECT_EQ(FdSampler::Count((dir_ / "30" / "fd").c_str(), buffer), -1);
+  EXPECT_EQ(FdSampler::Count("/proc/self/fd", buffer),
+            FdSampler::Count("/proc/self/fd", buffer));
+  EXPECT_GE(FdSampler::Count("/proc/self/fd", buffer), 3);
+}
+
+TEST_F(FdSamplerTest, StepTest) {
+  FdSampler sampler(dir_.string());
+  EXPECT_FALSE(sampler.Get(10).Known());
+  sampler.Tick({10, 20, 30});
+  sampler.Step(FdCount::Clock::time_point::max());
+  EXPECT_EQ(sampler.Get(10).count, 3);
+  EXPECT_EQ(sampler.Get(20).count, 5);
+  // Gone, or not readable.
+  EXPECT_FALSE(sampler.Get(30).Known());
+  EXPECT_NE(sampler.Get(30).time, FdCount::Clock::time_point());
+
+  // Past the deadline, the cached counts stay.
+  AddFds(20, 7);
+  sampler.Step(FdCount::Clock::now());
+  EXPECT_EQ(sampler.Get(20).count, 5);
+  sampler.Step(FdCount::Clock::time_point::max());
+  EXPECT_EQ(sampler.Get(20).count, 7);
+
+  // Pids that are not handed over again are dropped.
+  sampler.Tick({10});
+  sampler.Step(FdCount::Clock::time_point::max());
+  EXPECT_EQ(sampler.Get(10).count, 3);
+  EXPECT_FALSE(sampler.Get(20).Known());
+  EXPECT_EQ(sampler.Get(20).time, FdCount::Clock::time_point());
+}
+
+TEST_F(FdSamplerTest, NewFirstTest) {
+  FdSampler sampler(dir_.string());
+  sampler.Tick({10});
+  sampler.Step(FdCount::Clock::time_point::max());
+  const FdCount::Clock::time_point counted = sampler.Get(10).time;
+  // A new process is counted before the known ones take their turn, so a
+  // step that runs out of time at once still counts nothing new...
+  sampler.Tick({10, 20});
+  sampler.Step(FdCount::Clock::now());
+  EXPECT_FALSE(sampler.Get(20).Known());
+  // ...and one with time counts both, each once.
+  sampler.Step(FdCount::Clock::time_point::max());
+  EXPECT_EQ(sampler.Get(20).count, 5);
+  EXPECT_GT(sampler.Get(10).time, counted);
+}
+
+TEST_F(FdSamplerTest, BackgroundTest) {
+  FdSampler sampler(dir_.string());
+  sampler.Start();
+  sampler.Tick({10, 20});
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!sampler.Get(20).Known() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(sampler.Get(10).count, 3);
+  EXPECT_EQ(sampler.Get(20).count, 5);
+}
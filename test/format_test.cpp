@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "../include/format.h"
 
+#include <limits>
+
 TEST(FormatTest, CorrectlyFormatsDataOnlySeconds) {
   EXPECT_EQ(Format::ElapsedTime(10), "00:00:10");
   EXPECT_EQ(Format::ElapsedTime(1), "00:00:01");
@@ -19,4 +21,12 @@ TEST(FormatTest, CorrectlyFormatsData) {
   EXPECT_EQ(Format::ElapsedTime(3600), "01:00:00");
   EXPECT_EQ(Format::ElapsedTime(3661), "01:01:01");
   EXPECT_EQ(Format::ElapsedTime(356400), "99:00:00");
-}
\ No newline at end of file
+}
+
+TEST(FormatTest, SparklineTest) {
+  const float none = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_EQ(Format::Sparkline({0, 0.5, 1, 2}, 1), "▁▅██");
+  EXPECT_EQ(Format::Sparkline({none, 4, none}, 8), " ▅ ");
+  EXPECT_EQ(Format::Sparkline({3}, 0), "▁");
+  EXPECT_EQ(Format::Sparkline({}, 1), "");
+}
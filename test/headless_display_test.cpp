@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/headless_display.h"
+#include "../include/linux_system.h"
+#include "../include/process_columns.h"
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::filesystem::path;
+
+
+class HeadlessDisplayTest : public testing::Test {
+ protected:
+  LinuxSystem system_{FixtureSystem()};
+};
+
+TEST_F(HeadlessDisplayTest, SystemTest) {
+  std::ostringstream out;
+  HeadlessDisplay::DisplaySystem(system_, out);
+  EXPECT_NE(out.str().find("OS: Ubuntu 22.04.4 LTS\n"), std::string::npos);
+  EXPECT_NE(out.str().find("Total Processes: 3464\n"), std::string::npos);
+  EXPECT_NE(out.str().find("Up Time: 00:09:12\n"), std::string::npos);
+}
+
+TEST_F(HeadlessDisplayTest, ProcessesTest) {
+  std::ostringstream out;
+  HeadlessDisplay::DisplayProcesses(system_.Processes(), out, 2);
+  std::istringstream lines(out.str());
+  std::string header, first, second, third;
+  std::getline(lines, header);
+  std::getline(lines, first);
+  std::getline(lines, second);
+  EXPECT_EQ(header.rfind("PID", 0), 0);
+  EXPECT_EQ(first.rfind("103    foo", 0), 0);
+  EXPECT_NE(first.find("/usr/lib/chromium-browser"), std::string::npos);
+  EXPECT_FALSE(std::getline(lines, third));
+}
+
+TEST_F(HeadlessDisplayTest, FilteredTest) {
+  std::ostringstream out;
+  system_.SetFilter(ProcessFilter::Compile("cmd~^/sbin"));
+  HeadlessDisplay::DisplayProcesses(system_.Processes(), out, 10);
+  EXPECT_NE(out.str().find("/sbin/init"), std::string::npos);
+  EXPECT_EQ(out.str().find("chromium"), std::string::npos);
+}
+
+TEST_F(HeadlessDisplayTest, PressureTest) {
+  std::ostringstream out;
+  PressureMonitor pressure(kTestDataDirPath / "pressure");
+  HeadlessDisplay::DisplayPressure(pressure.Update(), out);
+  EXPECT_NE(out.str().find("Pressure cpu:   some 1.50% 0.75% (+0ms)\n"),
+            std::string::npos);
+  EXPECT_NE(out.str().find("Pressure memory:some 12.34% 5.00% (+0ms) full "
+                           "3.21% 1.00% (+0ms)\n"),
+            std::string::npos);
+}
+
+TEST_F(HeadlessDisplayTest, IoTest) {
+  std::ostringstream out;
+  IoStats io;
+  io.vm.faults = 1234;
+  io.vm.swap_out = 8;
+  io.disks.push_back({"sda", 20, 60, 81920, 245760, 0.5, 3});
+  io.interfaces.push_back({"eth0", 10000, 2000, 100, 20, 4, 2});
+  HeadlessDisplay::DisplayIo(io, out);
+  EXPECT_EQ(out.str(),
+            "Paging: faults 1234/s major 0/s swap in 0/s out 8/s scan 0/s "
+            "steal 0/s\n"
+            "Disk sda: r 20/s 0.1MB/s w 60/s 0.2MB/s util 50.0% await "
+            "3.00ms\n"
+            "Net eth0: rx 0.0MB/s 100p/s tx 0.0MB/s 20p/s drop 6/s\n");
+}
+
+TEST_F(HeadlessDisplayTest, ColumnsTest) {
+  using namespace ProcessColumns;
+  using Table = Columns<Pid, Cpu, Command>;
+  std::ostringstream out;
+  out << std::left;
+  Table::Header(out);
+  EXPECT_EQ(out.str(), "PID    CPU[%]  COMMAND");
+  std::vector<Process> processes{{42, 1, "foo", "make", 0.25, 500, 5}};
+  out.str("");
+  Table::Row(processes[0], out);
+  EXPECT_EQ(out.str(), "42     25.0    make");
+}
+
+TEST_F(HeadlessDisplayTest, FdsTest) {
+  using namespace ProcessColumns;
+  using Table = Columns<Pid, Fds, FdAge, Command>;
+  std::ostringstream out;
+  out << std::left;
+  Table::Header(out);
+  EXPECT_EQ(out.str(), "PID    FDS     AGE   COMMAND");
+  // Published processes have no counts.
+  std::vector<Process> processes{{42, 1, "foo", "make", 0.25, 500, 5}};
+  out.str("");
+  Table::Row(processes[0], out);
+  EXPECT_EQ(out.str(), "42     -       -     make");
+}
+
+TEST_F(HeadlessDisplayTest, BlockedTest) {
+  using namespace ProcessColumns;
+  using Table = Columns<Pid, Blocked, Command>;
+  std::ostringstream out;
+  out << std::left;
+  Table::Header(out);
+  EXPECT_EQ(out.str(), "PID    BLK[%]  COMMAND");
+  // Published processes are not sampled.
+  std::vector<Process> processes{{42, 1, "foo", "make", 0.25, 500, 5}};
+  out.str("");
+  Table::Row(processes[0], out);
+  EXPECT_EQ(out.str(), "42     -       make");
+}
+
+TEST_F(HeadlessDisplayTest, GroupsTest) {
+  std::ostringstream out;
+  system_.Processes();
+  HeadlessDisplay::DisplayGroups(system_.Groups().Rows(GroupBy::kUser, 10),
+                                 out, GroupBy::kUser);
+  std::istringstream lines(out.str());
+  std::string header, row;
+  std::getline(lines, header);
+  EXPECT_EQ(header, "CPU[%]  RAM[MB]  PROCS  USER");
+  ASSERT_TRUE(std::getline(lines, row));
+}
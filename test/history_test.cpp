@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+#include "../include/history.h"
+
+#include <chrono>
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+const SeriesKey kSystemCpu{0, 0, SeriesKey::Metric::kCpu};
+const SeriesKey kProcessCpu{42, 1000, SeriesKey::Metric::kCpu};
+const SeriesKey kProcessMemory{42, 1000, SeriesKey::Metric::kMemory};
+
+// An hour past the epoch of the clock, leaving room for times before it.
+const History::Clock::time_point kStart =
+    History::Clock::time_point(std::chrono::hours(1));
+
+// A busy CPU share, changing every second.
+float Utilization(int i) { return 0.2f + 0.05f * (i % 7); }
+
+// Irregular intervals, with gaps of minutes, exercise the wider time
+// encodings.
+History::Clock::time_point Time(int i) {
+  return kStart + seconds(i) + milliseconds((i % 5) * 200) +
+         std::chrono::minutes(2) * (i / 50) +
+         std::chrono::minutes(10) * (i / 100);
+}
+}  // namespace
+
+TEST(HistoryTest, RoundTripTest) {
+  History history;
+  for (int i = 0; i < 300; ++i) {
+    history.Add(kProcessCpu, Time(i), Utilization(i));
+  }
+  const std::vector<History::Point> points = history.Points(kProcessCpu);
+  ASSERT_EQ(points.size(), 300);
+  for (int i = 0; i < 300; ++i) {
+    EXPECT_EQ(points[i].time, Time(i));
+    // 8 significant bits.
+    EXPECT_NEAR(points[i].value, Utilization(i), Utilization(i) / 256);
+  }
+}
+
+TEST(HistoryTest, OutOfOrderTest) {
+  History history;
+  history.Add(kSystemCpu, kStart + seconds(2), 0.5);
+  history.Add(kSystemCpu, kStart + seconds(1), 0.25);
+  history.Add(kSystemCpu, kStart + seconds(2), 0.75);
+  const std::vector<History::Point> points = history.Points(kSystemCpu);
+  ASSERT_EQ(points.size(), 2);
+  EXPECT_EQ(points[1].value, 0.75);
+  EXPECT_TRUE(history.Points(kProcessMemory).empty());
+}
+
+TEST(HistoryTest, CompressionTest) {
+  History history;
+  // Ten minutes of samples every second: one flat series, one that changes
+  // every sample and one of a growing resident set.
+  const SeriesKey flat{1, 1, SeriesKey::Metric::kCpu};
+  for (int i = 0; i < 600; ++i) {
+    const History::Clock::time_point time = kStart + seconds(i);
+    history.Add(flat, time, 0);
+    history.Add(kProcessCpu, time, Utilization(i));
+    history.Add(kProcessMemory, time, 100000 + 64 * i);
+  }
+  EXPECT_EQ(history.NumSeries(), 3);
+  // Tens of bytes a minute per series, against 120 for raw 8 byte samples
+  // of a float and a 32 bit time.
+  EXPECT_LE(history.Bytes() / 10 / 3, 90);
+  EXPECT_EQ(history.Points(flat).size(), 600);
+  EXPECT_NEAR(history.Points(kProcessMemory).back().value, 100000 + 64 * 599,
+              (100000 + 64 * 599) / 256);
+}
+
+TEST(HistoryTest, MaxBytesTest) {
+  History history(seconds(3600), 1024);
+  for (int i = 0; i < 3600; ++i) {
+    history.Add(kProcessCpu, kStart + seconds(i), Utilization(i));
+  }
+  EXPECT_LE(history.Bytes(), 1024);
+  // The newest points survive.
+  const std::vector<History::Point> points = history.Points(kProcessCpu);
+  ASSERT_FALSE(points.empty());
+  EXPECT_EQ(points.back().time, kStart + seconds(3599));
+  EXPECT_GT(points.front().time, kStart);
+}
+
+TEST(HistoryTest, RetainTest) {
+  History history(seconds(60));
+  for (int i = 0; i < 600; ++i) {
+    history.Add(kSystemCpu, kStart + seconds(i), Utilization(i));
+    history.Add(kProcessCpu, kStart + seconds(i), Utilization(i));
+  }
+  const std::size_t bytes = history.Bytes();
+  history.Retain({42}, kStart + seconds(600));
+  EXPECT_LT(history.Bytes(), bytes);
+  EXPECT_EQ(history.NumSeries(), 2);
+  // Whole blocks go, so the first may reach back before the window.
+  EXPECT_GE(history.Points(kSystemCpu).front().time, kStart + seconds(480));
+  // The process exited.
+  history.Retain({}, kStart + seconds(600));
+  EXPECT_EQ(history.NumSeries(), 1);
+  EXPECT_TRUE(history.Points(kProcessCpu).empty());
+  EXPECT_FALSE(history.Points(kSystemCpu).empty());
+}
+
+TEST(HistoryTest, ResampleTest) {
+  History history(seconds(10));
+  history.Add(kSystemCpu, kStart + seconds(1), 0.25);
+  history.Add(kSystemCpu, kStart + seconds(6), 0.5);
+  history.Add(kSystemCpu, kStart + milliseconds(7500), 1);
+  history.Add(kSystemCpu, kStart + seconds(8), 0.125);
+  const std::vector<float> values =
+      history.Resample(kSystemCpu, kStart + seconds(12), 5);
+  ASSERT_EQ(values.size(), 5);
+  // The first point fell out of the window; each span has its largest value.
+  EXPECT_TRUE(std::isnan(values[0]));
+  EXPECT_TRUE(std::isnan(values[1]));
+  EXPECT_EQ(values[2], 1);
+  EXPECT_EQ(values[3], 0.125);
+  EXPECT_TRUE(std::isnan(values[4]));
+  EXPECT_EQ(history.Resample(kProcessCpu, kStart, 3).size(), 3);
+}
@@ -0,0 +1,177 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/io_monitor.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using std::filesystem::path;
+
+// The files of the proc filesystem with a disk, a partition of it, an unused
+// loop device and two interfaces, one unused.
+class IoMonitorTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    ScratchDir::SetUp();
+    WriteDisks(100, 2000, 50, 400, 8000, 150, 300);
+    WriteInterfaces(1000, 10, 0, 500, 5, 0);
+    WriteVm(1000, 10, 0, 0, 0);
+  }
+  path diskstats() const { return dir_ / "diskstats"; }
+  path netDev() const { return dir_ / "dev"; }
+  path vmstat() const { return dir_ / "vmstat"; }
+  // Rewritten in place, as the monitor keeps the files open.
+  void WriteDisks(long reads, long sectorsRead, long readMs, long writes,
+                  long sectorsWritten, long writeMs, long ioMs) {
+    std::ofstream(diskstats())
+        << "   7       0 loop0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+        << " 259       0 nvme0n1 " << reads << " 7 " << sectorsRead << " "
+        << readMs << " " << writes << " 3 " << sectorsWritten << " "
+        << writeMs << " 0 " << ioMs << " 900 0 0 0 0 0 0\n"
+        << " 259       1 nvme0n1p1 10 0 80 5 0 0 0 0 0 5 5 0 0 0 0 0 0\n";
+  }
+  void WriteInterfaces(long rxBytes, long rxPackets, long rxDrops,
+                       long txBytes, long txPackets, long txDrops) {
+    std::ofstream(netDev())
+        << "Inter-|   Receive                                                "
+           "|  Transmit\n"
+        << " face |bytes    packets errs drop fifo frame compressed "
+           "multicast|bytes    packets errs drop fifo colls carrier "
+           "compressed\n"
+        << "  eth0: " << rxBytes << " " << rxPackets << " 0 " << rxDrops
+        << " 0 0 0 0 " << txBytes << " " << txPackets << " 0 " << txDrops
+        << " 0 0 0 0\n"
+        << "  tun0:       0       0    0    0    0     0          0         0"
+           "        0       0    0    0    0     0       0          0\n";
+  }
+  void WriteVm(long faults, long majorFaults, long swapOut, long scanned,
+               long stolen) {
+    std::ofstream(vmstat()) << "nr_free_pages 12345\n"
+                            << "pswpin 0\n"
+                            << "pswpout " << swapOut << "\n"
+                            << "pgfault " << faults << "\n"
+                            << "pgmajfault " << majorFaults << "\n"
+                            << "pgsteal_kswapd " << stolen << "\n"
+                            << "pgsteal_direct " << stolen << "\n"
+                            << "pgscan_kswapd " << scanned << "\n"
+                            << "pgscan_direct " << scanned << "\n"
+                            << "pgscan_direct_throttle 7\n";
+  }
+};
+
+TEST_F(IoMonitorTest, FirstUpdateTest) {
+  IoMonitor monitor(diskstats().string(), netDev().string(),
+                    vmstat().string());
+  const IoStats& stats = monitor.Update();
+  // Devices without any I/O are left out.
+  ASSERT_EQ(stats.disks.size(), 2);
+  EXPECT_EQ(stats.disks[0].name, "nvme0n1");
+  EXPECT_EQ(stats.disks[1].name, "nvme0n1p1");
+  EXPECT_EQ(stats.disks[0].reads, 0);
+  ASSERT_EQ(stats.interfaces.size(), 1);
+  EXPECT_EQ(stats.interfaces[0].name, "eth0");
+  EXPECT_EQ(stats.interfaces[0].rx_bytes, 0);
+  EXPECT_EQ(stats.vm.faults, 0);
+}
+
+TEST_F(IoMonitorTest, RatesTest) {
+  IoMonitor monitor(diskstats().string(), netDev().string(),
+                    vmstat().string());
+  const auto start = std::chrono::steady_clock::now();
+  monitor.Update(start);
+  // 10 reads of 4 KiB taking 30ms, and 30 writes taking 90ms, with requests
+  // in flight for 250ms of the 500ms.
+  WriteDisks(110, 2080, 80, 430, 8240, 240, 550);
+  WriteInterfaces(6000, 60, 2, 1500, 15, 1);
+  WriteVm(3000, 15, 4, 100, 40);
+  const IoStats& stats =
+      monitor.Update(start + std::chrono::milliseconds(500));
+  ASSERT_EQ(stats.disks.size(), 2);
+  const DiskRates& disk = stats.disks[0];
+  EXPECT_DOUBLE_EQ(disk.reads, 20);
+  EXPECT_DOUBLE_EQ(disk.writes, 60);
+  EXPECT_DOUBLE_EQ(disk.read_bytes, 80 * 512 * 2);
+  EXPECT_DOUBLE_EQ(disk.write_bytes, 240 * 512 * 2);
+  EXPECT_DOUBLE_EQ(disk.utilization, 0.5);
+  EXPECT_DOUBLE_EQ(disk.await_ms, 3);
+  EXPECT_EQ(stats.disks[1].reads, 0);
+  EXPECT_EQ(stats.disks[1].await_ms, 0);
+
+  ASSERT_EQ(stats.interfaces.size(), 1);
+  const NetRates& eth = stats.interfaces[0];
+  EXPECT_DOUBLE_EQ(eth.rx_bytes, 10000);
+  EXPECT_DOUBLE_EQ(eth.rx_packets, 100);
+  EXPECT_DOUBLE_EQ(eth.rx_drops, 4);
+  EXPECT_DOUBLE_EQ(eth.tx_bytes, 2000);
+  EXPECT_DOUBLE_EQ(eth.tx_packets, 20);
+  EXPECT_DOUBLE_EQ(eth.tx_drops, 2);
+
+  EXPECT_DOUBLE_EQ(stats.vm.faults, 4000);
+  EXPECT_DOUBLE_EQ(stats.vm.major_faults, 10);
+  EXPECT_DOUBLE_EQ(stats.vm.swap_in, 0);
+  EXPECT_DOUBLE_EQ(stats.vm.swap_out, 8);
+  // kswapd and direct reclaim add up.
+  EXPECT_DOUBLE_EQ(stats.vm.scanned, 400);
+  EXPECT_DOUBLE_EQ(stats.vm.stolen, 160);
+
+  // A redraw right after the update does not sample again.
+  WriteVm(9000, 15, 4, 100, 40);
+  EXPECT_DOUBLE_EQ(
+      monitor.Update(start + std::chrono::milliseconds(510)).vm.faults, 4000);
+}
+
+TEST_F(IoMonitorTest, DevicesChangeTest) {
+  IoMonitor monitor(diskstats().string(), netDev().string(),
+                    vmstat().string());
+  const auto start = std::chrono::steady_clock::now();
+  monitor.Update(start);
+  // The loop device is used for the first time, ahead of the disk.
+  std::ofstream(diskstats())
+      << "   7       0 loop0 5 0 40 1 0 0 0 0 0 1 1 0 0 0 0 0 0\n"
+      << " 259       0 nvme0n1 200 7 4000 50 400 3 8000 150 0 300 900\n";
+  const IoStats& stats = monitor.Update(start + std::chrono::seconds(1));
+  ASSERT_EQ(stats.disks.size(), 2);
+  EXPECT_EQ(stats.disks[0].name, "loop0");
+  EXPECT_EQ(stats.disks[0].reads, 0);
+  EXPECT_EQ(stats.disks[1].name, "nvme0n1");
+  // Found by its name, so the move keeps its counters.
+  EXPECT_DOUBLE_EQ(stats.disks[1].reads, 100);
+  std::ofstream(diskstats())
+      << "   7       0 loop0 5 0 40 1 0 0 0 0 0 1 1 0 0 0 0 0 0\n"
+      << " 259       0 nvme0n1 300 7 4000 50 400 3 8000 150 0 300 900\n";
+  EXPECT_EQ(monitor.Update(start + std::chrono::seconds(2)).disks[1].reads,
+            100);
+  // An interface that appears ahead of another one.
+  std::ofstream(netDev()) << "  lo: 400 4 0 0 0 0 0 0 400 4 0 0 0 0 0 0\n"
+                          << "  eth0: 2000 20 0 0 0 0 0 0 500 5 0 0 0 0 0 0\n";
+  const IoStats& next = monitor.Update(start + std::chrono::seconds(3));
+  ASSERT_EQ(next.interfaces.size(), 2);
+  EXPECT_EQ(next.interfaces[0].name, "lo");
+  EXPECT_EQ(next.interfaces[0].rx_bytes, 0);
+  EXPECT_EQ(next.interfaces[1].name, "eth0");
+  EXPECT_DOUBLE_EQ(next.interfaces[1].rx_bytes, 1000);
+}
+
+TEST_F(IoMonitorTest, MissingFilesTest) {
+  IoMonitor monitor((dir_ / "bogus").string(), (dir_ / "bogus").string(),
+                    vmstat().string());
+  const IoStats& stats = monitor.Update();
+  EXPECT_TRUE(stats.disks.empty());
+  EXPECT_TRUE(stats.interfaces.empty());
+}
+
+// The files of the running kernel parse into named devices.
+TEST(IoMonitorProcTest, ProcTest) {
+  IoMonitor monitor;
+  const IoStats& stats = monitor.Update();
+  for (const DiskRates& disk : stats.disks) {
+    EXPECT_FALSE(disk.name.empty());
+  }
+  for (const NetRates& interface : stats.interfaces) {
+    EXPECT_FALSE(interface.name.empty());
+    EXPECT_EQ(interface.name.find(' '), std::string::npos);
+  }
+  EXPECT_EQ(stats.vm.faults, 0);
+}
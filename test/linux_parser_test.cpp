@@ -4,13 +4,11 @@
 #include <unordered_map>
 
 #include "gtest/gtest.h"
+#include "test_data.h"
 #include "../include/linux_parser.h"
 
 using std::string;
 
-const std::filesystem::path kTestDir("test");
-const std::filesystem::path kTestDataDir("testdata");
-const std::filesystem::path kTestDataDirPath = std::filesystem::current_path() / kTestDir / kTestDataDir;
 
 TEST(OperatingSystemTest, LinuxOSTest) {
   std::filesystem::path file("fake_os_release");
@@ -30,12 +28,23 @@ TEST(NumberOfProcessesTest, LinuxOSTest) {
   EXPECT_EQ(LinuxParser::RunningProcesses(stat_data_path), 2);
 }
 
+TEST(BlockedProcessesTest, LinuxOSTest) {
+  EXPECT_EQ(LinuxParser::BlockedProcesses(kTestDataDirPath / "fake_stat"), 0);
+  EXPECT_EQ(LinuxParser::BlockedProcesses(kTestDataDirPath / "missing_stat"),
+            0);
+}
+
 TEST(TotalNumberOfProcessesTest, LinuxOSTest) {
   std::filesystem::path file("fake_stat");
   std::filesystem::path stat_data_path = kTestDataDirPath / file;
   EXPECT_EQ(LinuxParser::TotalProcesses(stat_data_path), 90601);
 }
 
+TEST(LastPidTest, LinuxOSTest) {
+  EXPECT_EQ(LinuxParser::LastPid(kTestDataDirPath / "fake_loadavg"), 48211);
+  EXPECT_EQ(LinuxParser::LastPid(kTestDataDirPath / "missing_loadavg"), -1);
+}
+
 TEST(UptimeTest, LinuxOSTest) {
   std::filesystem::path file("fake_uptime");
   std::filesystem::path stat_data_path = kTestDataDirPath / file;
@@ -50,7 +59,7 @@ TEST(MemoryUtilizationTest, LinuxOSTest) {
 
 TEST(PidTest, LinuxOSTest) {
   std::filesystem::path pid_dir_path = kTestDataDirPath;
-  std::vector<int> expected{1, 103, 75, 78};
+  std::vector<int> expected{1, 75, 78, 103};
   std::vector<int> actual = LinuxParser::Pids(pid_dir_path.string());
   EXPECT_EQ(actual, expected);
 }
@@ -201,4 +210,62 @@ TEST(ProcStatsTest, Process103Test) {
   EXPECT_EQ(actual[LinuxParser::kCutimeStatIndex], "91213");
   EXPECT_EQ(actual[LinuxParser::kCstimeStatIndex], "12278");
   EXPECT_EQ(actual[LinuxParser::kStarttimeStatIndex], "3570");
-}
\ No newline at end of file
+}
+TEST(ProcIdentityTest, Process103Test) {
+  std::string comm;
+  long startTime = 0;
+  ASSERT_TRUE(LinuxParser::ProcessIdentity(kTestDataDirPath / "103" / "stat", comm, startTime));
+  EXPECT_EQ(comm, "chromium-browse");
+  EXPECT_EQ(startTime, 3570);
+  EXPECT_FALSE(LinuxParser::ProcessIdentity(kTestDataDirPath / "999" / "stat", comm, startTime));
+}
+
+TEST(ProcSchedStatsTest, Process103Test) {
+  LinuxParser::SchedStatSchema::Values values;
+  ASSERT_TRUE(LinuxParser::SchedStats(kTestDataDirPath / "103" / "schedstat", values));
+  EXPECT_EQ(values, (LinuxParser::SchedStatSchema::Values{1234567890, 98765432, 4321}));
+  EXPECT_FALSE(LinuxParser::SchedStats(kTestDataDirPath / "1" / "schedstat", values));
+}
+
+TEST(ProcContextSwitchesTest, Process103Test) {
+  ProcSchema::Keyed<LinuxParser::StatusSwitchKeys>::Values values;
+  ASSERT_TRUE(LinuxParser::ContextSwitches(kTestDataDirPath / "103" / "status", values));
+  EXPECT_EQ(values[0], 137765);
+  EXPECT_EQ(values[1], 108);
+}
+
+TEST(ProcCgroupTest, UnifiedHierarchyTest) {
+  EXPECT_EQ(LinuxParser::Cgroup(kTestDataDirPath, 1), "/init.scope");
+  EXPECT_EQ(LinuxParser::Cgroup(kTestDataDirPath, 103), "/user.slice/user-1000.slice");
+}
+
+TEST(ProcCgroupTest, MissingFileTest) {
+  EXPECT_EQ(LinuxParser::Cgroup(kTestDataDirPath, 1234), "");
+}
+
+TEST(CgroupStatsTest, SnapdServiceTest) {
+  std::filesystem::path cgroup_path = kTestDataDirPath / "cgroup" / "system.slice" / "snapd.service";
+  EXPECT_EQ(LinuxParser::CgroupCpuUsage(cgroup_path), 250000);
+  EXPECT_EQ(LinuxParser::CgroupMemoryCurrent(cgroup_path), 8388608);
+  EXPECT_EQ(LinuxParser::CgroupCpuMax(cgroup_path), std::make_pair(50000L, 100000L));
+}
+
+TEST(CgroupStatsTest, UnlimitedTest) {
+  std::filesystem::path cgroup_path = kTestDataDirPath / "cgroup" / "init.scope";
+  EXPECT_EQ(LinuxParser::CgroupCpuMax(cgroup_path), std::make_pair(-1L, 100000L));
+  EXPECT_EQ(LinuxParser::CgroupCpuMax(kTestDataDirPath / "cgroup"), std::make_pair(-1L, 0L));
+}
+
+TEST(ProcPressureTest, SomeAndFullTest) {
+  const std::filesystem::path kPressureFilePath = kTestDataDirPath / "pressure" / "memory";
+  EXPECT_EQ(LinuxParser::Pressure(kPressureFilePath, "some"),
+            std::vector<double>({12.34, 5.00, 1.25, 9876543}));
+  EXPECT_EQ(LinuxParser::Pressure(kPressureFilePath, "full"),
+            std::vector<double>({3.21, 1.00, 0.10, 4567890}));
+}
+
+TEST(ProcPressureTest, MissingLineTest) {
+  const std::filesystem::path kPressureDirPath = kTestDataDirPath / "pressure";
+  EXPECT_TRUE(LinuxParser::Pressure(kPressureDirPath / "cpu", "full").empty());
+  EXPECT_TRUE(LinuxParser::Pressure(kPressureDirPath / "bogus", "some").empty());
+}
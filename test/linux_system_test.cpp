@@ -1,27 +1,25 @@
 #include "gtest/gtest.h"
+#include "test_data.h"
 #include "../include/linux_system.h"
 #include "../include/linux_parser.h"
 #include "../include/processor.h"
 
-#include <string>
+#include <unistd.h>
+
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <thread>
 
 using std::string;
 using std::filesystem::path;
 
-const path kTestDir("test");
-const path kTestDataDir("testdata");
-const path kTestDataDirPath = std::filesystem::current_path() / kTestDir / kTestDataDir;
-const path kMemInfoFilePath = kTestDataDirPath / path("recent_meminfo");
-const path kOSVersionFilePath = kTestDataDirPath / path("fake_os_release");
-const path kStatsFilePath = kTestDataDirPath / path("recent_stat");
-const path kUptimeFilePath = kTestDataDirPath / path("recent_uptime");
-const path kkernelInfoFilePath = kTestDataDirPath / path("fake_proc_version");
-const path kEtcPasswdFilePath = kTestDataDirPath / path("fake_etc_passwd");
 
 class LinuxSystemTest : public testing::Test {
  protected:
- LinuxSystem system_{kTestDataDirPath.generic_string(), kTestDataDirPath.generic_string(), kMemInfoFilePath.generic_string(), kOSVersionFilePath.generic_string(), kTestDataDirPath.generic_string(), kStatsFilePath.generic_string(), kUptimeFilePath.generic_string(), kkernelInfoFilePath.generic_string(), kEtcPasswdFilePath.generic_string()};
+ LinuxSystem system_{FixtureSystem()};
 };
 
 TEST_F(LinuxSystemTest, CpuTest) {
@@ -40,6 +38,164 @@ TEST_F(LinuxSystemTest, ProcessesTest) {
  EXPECT_EQ(processes[0].Command(), "/usr/lib/chromium-browser/chromium-browser --type=zygote --ppapi-flash-path=/usr/lib/adobe-fl");
 }
 
+TEST_F(LinuxSystemTest, ProgressiveProcessesTest) {
+ const auto expired = std::chrono::steady_clock::now();
+ EXPECT_TRUE(system_.Processes(expired).empty());
+ ScanProgress progress = system_.Progress();
+ EXPECT_EQ(progress.scanned, 0);
+ EXPECT_EQ(progress.total, 4);
+ EXPECT_FALSE(progress.Done());
+ // The scan carries on where it stopped.
+ EXPECT_EQ(system_.Processes().size(), 4);
+ EXPECT_TRUE(system_.Progress().Done());
+ // A new scan finds nothing new and keeps the listed processes.
+ EXPECT_EQ(system_.Processes(expired).size(), 4);
+ progress = system_.Progress();
+ EXPECT_EQ(progress.total, 0);
+ EXPECT_TRUE(progress.Done());
+}
+
+// Adds `delta` to a field of the stat file of a process in a copied proc
+// directory, counting the fields after the command from 1.
+static void AddToStatField(const path& procsDirPath, int pid, int field,
+                           long delta) {
+  const path statPath = procsDirPath / std::to_string(pid) / "stat";
+  string stat;
+  std::getline(std::ifstream(statPath), stat);
+  size_t begin = stat.rfind(')') + 1;
+  for (int i = 0; i < field; ++i) {
+    begin = stat.find(' ', begin) + 1;
+  }
+  const size_t end = stat.find(' ', begin);
+  const long value = std::stol(stat.substr(begin, end - begin));
+  stat.replace(begin, end - begin, std::to_string(value + delta));
+  std::ofstream(statPath) << stat << "\n";
+}
+
+// Adds CPU ticks to the utime of a process in a copied proc directory.
+static void AddTicks(const path& procsDirPath, int pid, long ticks) {
+  AddToStatField(procsDirPath, pid, 12, ticks);
+}
+
+// A proc directory holding copies of some fixture processes.
+static path CopyProcs(const string& name,
+                      std::initializer_list<const char*> pids) {
+  const path procsDirPath = std::filesystem::temp_directory_path() /
+                            (name + "_" + std::to_string(getpid()));
+  std::filesystem::remove_all(procsDirPath);
+  std::filesystem::create_directory(procsDirPath);
+  for (const char* pid : pids) {
+    std::filesystem::copy(kTestDataDirPath / pid, procsDirPath / pid,
+                          std::filesystem::copy_options::recursive);
+  }
+  return procsDirPath;
+}
+
+TEST(LinuxSystemSortTest, ResampledBeforeSortTest) {
+  const path procsDirPath = CopyProcs("linux_system_test", {"1", "103"});
+  LinuxSystem system = FixtureSystem(procsDirPath);
+  ASSERT_EQ(system.Processes().size(), 2);
+  // The process at the bottom starts using the CPU.
+  const int idle = system.Processes()[1].Pid();
+  AddTicks(procsDirPath, idle, 100000);
+  std::this_thread::sleep_for(kUpdateInterval + std::chrono::milliseconds(100));
+  EXPECT_EQ(system.Processes()[0].Pid(), idle);
+  std::filesystem::remove_all(procsDirPath);
+}
+
+// Copies the fixture /proc/stat with another number of runnable tasks.
+static void WriteStats(const path& statsFilePath, int procsRunning) {
+  string stats;
+  LinuxParser::ReadFile(kStatsFilePath, stats);
+  const string key = "procs_running ";
+  const size_t begin = stats.find(key) + key.size();
+  stats.replace(begin, stats.find('\n', begin) - begin,
+                std::to_string(procsRunning));
+  std::ofstream(statsFilePath) << stats;
+}
+
+TEST(LinuxSystemTierTest, IdleProcessesSampledLessOftenTest) {
+  const path procsDirPath = CopyProcs("linux_system_tier_test", {"1", "103"});
+  const path statsFilePath = procsDirPath / "stat";
+  WriteStats(statsFilePath, 0);
+  LinuxSystem system =
+      FixtureSystem(procsDirPath, kMemInfoFilePath, statsFilePath);
+  ASSERT_EQ(system.Processes().size(), 2);
+  // Idle since the first sample, so both drop out of the hot tier.
+  std::this_thread::sleep_for(kUpdateInterval + std::chrono::milliseconds(100));
+  system.Processes();
+  const int idle = system.Processes()[1].Pid();
+  AddTicks(procsDirPath, idle, 100000);
+  std::this_thread::sleep_for(kUpdateInterval + std::chrono::milliseconds(100));
+  EXPECT_EQ(system.Processes()[1].Pid(), idle);
+  // A runnable task nobody accounts for wakes the sampler up.
+  WriteStats(statsFilePath, 1);
+  EXPECT_EQ(system.Processes()[0].Pid(), idle);
+  std::filesystem::remove_all(procsDirPath);
+}
+
+TEST(LinuxSystemChurnTest, VanishedProcessTest) {
+  const path procsDirPath = CopyProcs("linux_system_churn_test", {"1", "103"});
+  // Listed, but exited before its stat file was read.
+  std::filesystem::create_directory(procsDirPath / "200");
+  LinuxSystem system = FixtureSystem(procsDirPath);
+  EXPECT_EQ(system.Processes().size(), 2);
+  std::filesystem::remove_all(procsDirPath / "103");
+  std::this_thread::sleep_for(kUpdateInterval + std::chrono::milliseconds(100));
+  ASSERT_EQ(system.Processes().size(), 1);
+  EXPECT_EQ(system.Processes()[0].Pid(), 1);
+  std::filesystem::remove_all(procsDirPath);
+}
+
+TEST(LinuxSystemChurnTest, ReusedPidTest) {
+  const path procsDirPath = CopyProcs("linux_system_reuse_test", {"103"});
+  LinuxSystem system = FixtureSystem(procsDirPath);
+  ASSERT_EQ(system.Processes().size(), 1);
+  // Another process starts later with the same pid.
+  AddToStatField(procsDirPath, 103, 20, 5000);
+  std::ofstream(procsDirPath / "103" / "cmdline") << "make -j8";
+  std::this_thread::sleep_for(kUpdateInterval + std::chrono::milliseconds(100));
+  ASSERT_EQ(system.Processes().size(), 1);
+  EXPECT_EQ(system.Processes()[0].Command(), "make -j8");
+  std::filesystem::remove_all(procsDirPath);
+}
+
+TEST(LinuxSystemQuietTest, NoForkNoWalkTest) {
+  const path procsDirPath = CopyProcs("linux_system_quiet_test", {"1", "103"});
+  std::ofstream(procsDirPath / "loadavg") << "0.00 0.00 0.00 1/2 103\n";
+  LinuxSystem system = FixtureSystem(procsDirPath);
+  ASSERT_EQ(system.Processes().size(), 2);
+  // Without a fork in the counters, a new directory is not looked for...
+  std::filesystem::copy(procsDirPath / "103", procsDirPath / "104",
+                        std::filesystem::copy_options::recursive);
+  EXPECT_EQ(system.Processes().size(), 2);
+  // ...until the last pid moves.
+  std::ofstream(procsDirPath / "loadavg") << "0.00 0.00 0.00 1/3 104\n";
+  EXPECT_EQ(system.Processes().size(), 3);
+  // Exits are found on quiet ticks, before the exited process is due for
+  // another sample.
+  std::filesystem::remove_all(procsDirPath / "104");
+  EXPECT_EQ(system.Processes().size(), 2);
+  std::filesystem::remove_all(procsDirPath);
+}
+
+TEST(LinuxSystemWatchTest, WatchTest) {
+  LinuxSystem system;
+  system.SetWatch({{getpid()}, {}, ""});
+  ASSERT_EQ(system.Processes().size(), 1);
+  EXPECT_EQ(system.Processes()[0].Pid(), getpid());
+  // Back to every process.
+  system.SetWatch({});
+  EXPECT_GT(system.Processes().size(), 1);
+}
+
+TEST(LinuxSystemWatchTest, SampleIntervalTest) {
+  LinuxSystem system;
+  EXPECT_EQ(system.SampleInterval(), kUpdateInterval);
+  system.SetSampleInterval(std::chrono::milliseconds(5));
+  EXPECT_EQ(system.SampleInterval(), std::chrono::milliseconds(5));
+}
+
 TEST_F(LinuxSystemTest, MemoryUtilizationTest) {
   EXPECT_FLOAT_EQ(system_.MemoryUtilization(), 0.034009644);
 }
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/low_impact.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+namespace {
+const SelfMonitor::Clock::time_point kStart =
+    SelfMonitor::Clock::time_point(std::chrono::hours(1));
+}  // namespace
+
+TEST(LowImpactTest, ParseCpuListTest) {
+  EXPECT_EQ(LowImpact::ParseCpuList("3"), std::vector<int>({3}));
+  EXPECT_EQ(LowImpact::ParseCpuList("0-2,5"), std::vector<int>({0, 1, 2, 5}));
+  EXPECT_EQ(LowImpact::ParseCpuList("7,1-1"), std::vector<int>({7, 1}));
+  for (const char* list : {"", ",", "a", "1-", "-1", "2-1", "1,,2", "1x",
+                           "0-1x", "99999"}) {
+    EXPECT_THROW(LowImpact::ParseCpuList(list), std::invalid_argument) << list;
+  }
+}
+
+TEST(LowImpactTest, UnlimitedTest) {
+  SelfMonitor self;
+  double cpu = 0;
+  for (int i = 0; i < 10; ++i) {
+    // Far more CPU than time.
+    cpu += 5;
+    EXPECT_TRUE(self.Admit(kStart + milliseconds(100 * i), cpu));
+  }
+  EXPECT_EQ(self.Report().skipped_ticks, 0);
+}
+
+TEST(LowImpactTest, BudgetTest) {
+  SelfMonitor self(0.1, kStatmFilePath);
+  ASSERT_TRUE(self.Admit(kStart, 0));
+  // Within the budget: 50ms of CPU per second.
+  ASSERT_TRUE(self.Admit(kStart + milliseconds(1000), 0.05));
+  SelfMonitor::Overhead overhead = self.Report();
+  EXPECT_NEAR(overhead.cpu_share, 0.05, 1e-9);
+  EXPECT_NEAR(overhead.cpu_ms, 50, 1e-6);
+  // The 50ms saved, and 100ms more earned, do not pay for a 340ms scan...
+  EXPECT_FALSE(self.Admit(kStart + milliseconds(2000), 0.39));
+  // ...which takes the next two seconds to pay off.
+  EXPECT_FALSE(self.Admit(kStart + milliseconds(3000), 0.39));
+  EXPECT_TRUE(self.Admit(kStart + milliseconds(4000), 0.39));
+  EXPECT_EQ(self.Report().skipped_ticks, 2);
+}
+
+TEST(LowImpactTest, CreditCapTest) {
+  SelfMonitor self(0.1);
+  ASSERT_TRUE(self.Admit(kStart, 0));
+  // An hour idle earns no more than kMaxCredit at the budgeted share, i.e. 1s.
+  ASSERT_TRUE(self.Admit(kStart + std::chrono::hours(1), 0));
+  const SelfMonitor::Clock::time_point later =
+      kStart + std::chrono::hours(1) + milliseconds(1);
+  EXPECT_TRUE(self.Admit(later, 0.9));
+  EXPECT_FALSE(self.Admit(later + milliseconds(1), 1.1));
+}
+
+TEST(LowImpactTest, ReportTest) {
+  SelfMonitor self(0, kStatmFilePath);
+  EXPECT_EQ(self.Report().rss_kb, 1536 * (sysconf(_SC_PAGESIZE) / 1024));
+  // The monitor's own memory, by default.
+  EXPECT_GT(SelfMonitor().Report().rss_kb, 0);
+  EXPECT_EQ(SelfMonitor(0, kTestDataDirPath / "missing").Report().rss_kb, 0);
+}
+
+TEST(LowImpactTest, DescribeTest) {
+  SelfMonitor::Overhead overhead;
+  overhead.cpu_share = 0.004;
+  overhead.cpu_ms = 2.125;
+  overhead.rss_kb = 6 * 1024;
+  overhead.skipped_ticks = 3;
+  EXPECT_EQ(SelfMonitor::Describe(overhead),
+            "Monitor: 0.4% CPU, 2.1 ms/tick, 6 MB RSS, 3 skipped");
+}
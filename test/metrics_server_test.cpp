@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/event_loop.h"
+#include "../include/linux_system.h"
+#include "../include/metrics_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::filesystem::path;
+using std::string;
+
+
+// A plain TCP client sending a single request.
+string Scrape(int port, const string& target = "/metrics") {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return "";
+  }
+  const string request = "GET " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  send(fd, request.data(), request.size(), 0);
+  string response;
+  char buffer[4096];
+  ssize_t count;
+  while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+    response.append(buffer, count);
+  }
+  close(fd);
+  return response;
+}
+
+class MetricsServerTest : public testing::Test {
+ protected:
+  LinuxSystem system_{FixtureSystem()};
+  MetricsServer server_{0};
+};
+
+TEST_F(MetricsServerTest, RenderTest) {
+  const string body = MetricsServer::Render(system_, 0.25, system_.Processes(), 2);
+  EXPECT_NE(body.find("# TYPE monitor_cpu_utilization gauge\n"), string::npos);
+  EXPECT_NE(body.find("monitor_cpu_utilization 0.25\n"), string::npos);
+  EXPECT_NE(body.find("monitor_processes_created_total 3464\n"), string::npos);
+  EXPECT_NE(body.find("monitor_processes_running 1\n"), string::npos);
+  EXPECT_NE(body.find("monitor_processes_blocked 0\n"), string::npos);
+  EXPECT_NE(body.find("monitor_uptime_seconds 552\n"), string::npos);
+  EXPECT_NE(body.find("monitor_process_uptime_seconds{pid=\"103\",user=\"foo\",command=\"/usr/lib/chromium-browser/"), string::npos);
+  EXPECT_NE(body.find("monitor_process_virtual_memory_bytes{pid=\"1\",user=\"root\",command=\"/sbin/init\"} 169852928\n"), string::npos);
+  // Only the top two processes are included.
+  EXPECT_EQ(body.find("pid=\"78\""), string::npos);
+  EXPECT_EQ(body.substr(body.size() - 6), "# EOF\n");
+}
+
+TEST_F(MetricsServerTest, NoDataTest) {
+  EXPECT_EQ(Scrape(server_.Port()).rfind("HTTP/1.1 503", 0), 0);
+}
+
+TEST_F(MetricsServerTest, ScrapeTest) {
+  const string body = MetricsServer::Render(system_, 0.25, system_.Processes(), 10);
+  server_.Publish(body);
+  const string response = Scrape(server_.Port());
+  EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+  EXPECT_NE(response.find("Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"), string::npos);
+  EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), body);
+  EXPECT_EQ(Scrape(server_.Port(), "/").rfind("HTTP/1.1 404", 0), 0);
+}
+
+TEST_F(MetricsServerTest, ConcurrentScrapesTest) {
+  server_.Publish("# EOF\n");
+  std::vector<string> responses(8);
+  std::vector<std::thread> clients;
+  for (auto& response : responses) {
+    clients.emplace_back([this, &response]() { response = Scrape(server_.Port()); });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  for (const auto& response : responses) {
+    EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), "# EOF\n");
+  }
+}
+
+// A client sending its request a byte at a time is dropped after one
+// timeout, however often it sends.
+TEST_F(MetricsServerTest, SlowClientTest) {
+  server_.Publish("# EOF\n");
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(server_.Port());
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(
+      connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+  std::thread slow([fd]() {
+    for (int i = 0; i < 15; ++i) {
+      if (send(fd, "G", 1, MSG_NOSIGNAL) <= 0) {
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+  });
+  // Let the server take the slow client first.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const auto start = std::chrono::steady_clock::now();
+  const string response = Scrape(server_.Port());
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  slow.join();
+  close(fd);
+  EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), "# EOF\n");
+  EXPECT_LT(elapsed, std::chrono::milliseconds(2000));
+}
+
+TEST_F(MetricsServerTest, SignalsSkipServerThreadTest) {
+  sigset_t previous;
+  sigprocmask(SIG_BLOCK, nullptr, &previous);
+  {
+    // The loop blocks the signal only after the server thread started, as in
+    // main.
+    EventLoop loop;
+    int received = 0;
+    loop.HandleSignals({SIGUSR2}, [&](int signal) { received = signal; });
+    // Sent to the process, so any thread not blocking it may take it.
+    kill(getpid(), SIGUSR2);
+    loop.RunOnce(std::chrono::milliseconds(1000));
+    EXPECT_EQ(received, SIGUSR2);
+  }
+  sigprocmask(SIG_SETMASK, &previous, nullptr);
+}
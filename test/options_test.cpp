@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+#include "../include/options.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(OptionsTest, DefaultsTest) {
+  Options options = CommandLine::Parse({});
+  EXPECT_EQ(options.num_processes, 10);
+  EXPECT_FALSE(options.show_cgroups);
+  EXPECT_FALSE(options.show_tree);
+  EXPECT_FALSE(options.show_sched);
+  EXPECT_FALSE(options.headless);
+  EXPECT_EQ(options.filter, "");
+}
+
+TEST(OptionsTest, FlagsTest) {
+  Options options =
+      CommandLine::Parse({"-n", "25", "--cgroups", "--tree", "--sched"});
+  EXPECT_EQ(options.num_processes, 25);
+  EXPECT_TRUE(options.show_cgroups);
+  EXPECT_TRUE(options.show_tree);
+  EXPECT_TRUE(options.show_sched);
+}
+
+TEST(OptionsTest, GroupByTest) {
+  EXPECT_EQ(CommandLine::Parse({}).group_by, GroupBy::kProcess);
+  EXPECT_EQ(CommandLine::Parse({"--group-by", "user"}).group_by,
+            GroupBy::kUser);
+  EXPECT_EQ(CommandLine::Parse({"--group-by", "command"}).group_by,
+            GroupBy::kCommand);
+  ASSERT_THROW(CommandLine::Parse({"--group-by"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--group-by", "pid"}),
+               std::invalid_argument);
+}
+
+TEST(OptionsTest, FilterTest) {
+  Options options = CommandLine::Parse({"--headless", "--filter", "user=foo cpu>5"});
+  EXPECT_TRUE(options.headless);
+  EXPECT_EQ(options.filter, "user=foo cpu>5");
+  ASSERT_THROW(CommandLine::Parse({"--filter"}), std::invalid_argument);
+}
+
+TEST(OptionsTest, HandlesBadInput) {
+  ASSERT_THROW(CommandLine::Parse({"--bogus"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"-n"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"-n", "0"}), std::invalid_argument);
+  // Out of range and trailing junk are malformed too, not exceptions of
+  // their own.
+  ASSERT_THROW(CommandLine::Parse({"-n", "99999999999"}),
+               std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"-n", "5x"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"-n", " 5"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--interval", "100ms"}),
+               std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--metrics-port", "99999999999"}),
+               std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--nice", "-99999999999"}),
+               std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--cpu-budget", "5%"}),
+               std::invalid_argument);
+}
+
+TEST(OptionsTest, MetricsPortTest) {
+  EXPECT_EQ(CommandLine::Parse({}).metrics_port, -1);
+  EXPECT_EQ(CommandLine::Parse({"--metrics-port", "9105"}).metrics_port, 9105);
+  ASSERT_THROW(CommandLine::Parse({"--metrics-port", "0"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--metrics-port"}), std::invalid_argument);
+}
+
+TEST(OptionsTest, PsiTriggerTest) {
+  EXPECT_TRUE(CommandLine::Parse({}).psi_triggers.empty());
+  Options options = CommandLine::Parse(
+      {"--psi-trigger", "memory:some:150:1000", "--psi-trigger", "io:full:50:500"});
+  EXPECT_EQ(options.psi_triggers,
+            std::vector<std::string>({"memory:some:150:1000", "io:full:50:500"}));
+  ASSERT_THROW(CommandLine::Parse({"--psi-trigger"}), std::invalid_argument);
+}
+
+TEST(OptionsTest, WarmStartTest) {
+  EXPECT_FALSE(CommandLine::Parse({}).warm_start);
+  EXPECT_TRUE(CommandLine::Parse({"--warm-start"}).warm_start);
+  ASSERT_THROW(CommandLine::Parse({"--attach", "--warm-start"}), std::invalid_argument);
+}
+
+TEST(OptionsTest, LowImpactTest) {
+  Options options = CommandLine::Parse({});
+  EXPECT_TRUE(options.cpus.empty());
+  EXPECT_FALSE(options.sched_idle);
+  EXPECT_FALSE(options.lock_memory);
+  EXPECT_EQ(options.cpu_budget, 0);
+
+  options = CommandLine::Parse({"--low-impact"});
+  EXPECT_TRUE(options.sched_idle);
+  EXPECT_TRUE(options.lock_memory);
+  EXPECT_EQ(options.cpu_budget, kLowImpactCpuBudget);
+
+  // An explicit nice level or budget wins over the defaults.
+  options = CommandLine::Parse(
+      {"--nice", "10", "--low-impact", "--cpu-budget", "2", "--cpus", "0-1,3"});
+  EXPECT_FALSE(options.sched_idle);
+  EXPECT_EQ(options.nice, 10);
+  EXPECT_EQ(options.cpu_budget, 2);
+  EXPECT_EQ(options.cpus, std::vector<int>({0, 1, 3}));
+
+  ASSERT_THROW(CommandLine::Parse({"--cpus"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--cpus", "1-"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--nice", "20"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--cpu-budget", "0"}), std::invalid_argument);
+}
+
+TEST(OptionsTest, BlockedTest) {
+  EXPECT_FALSE(CommandLine::Parse({}).show_blocked);
+  EXPECT_TRUE(CommandLine::Parse({"--blocked"}).show_blocked);
+}
+
+TEST(OptionsTest, IoTest) {
+  EXPECT_FALSE(CommandLine::Parse({}).show_io);
+  EXPECT_TRUE(CommandLine::Parse({"--io"}).show_io);
+}
+
+TEST(OptionsTest, FdsTest) {
+  EXPECT_FALSE(CommandLine::Parse({}).show_fds);
+  EXPECT_TRUE(CommandLine::Parse({"--fds"}).show_fds);
+}
+
+TEST(OptionsTest, WatchTest) {
+  EXPECT_TRUE(CommandLine::Parse({}).watch.Empty());
+  const Options options = CommandLine::Parse(
+      {"-p", "12,34", "-p", "56", "--name", "nginx", "--cgroup",
+       "/system.slice/nginx.service"});
+  EXPECT_EQ(options.watch.pids, std::vector<int>({12, 34, 56}));
+  EXPECT_EQ(options.watch.names, std::vector<std::string>({"nginx"}));
+  EXPECT_EQ(options.watch.cgroup, "system.slice/nginx.service");
+  ASSERT_THROW(CommandLine::Parse({"-p"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"-p", "12,x"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--name"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--attach", "-p", "12"}),
+               std::invalid_argument);
+}
+
+TEST(OptionsTest, IntervalTest) {
+  EXPECT_EQ(CommandLine::Parse({}).interval, kDefaultRefreshInterval);
+  EXPECT_EQ(CommandLine::Parse({"--interval", "10"}).interval,
+            std::chrono::milliseconds(10));
+  ASSERT_THROW(CommandLine::Parse({"--interval", "5"}), std::invalid_argument);
+  ASSERT_THROW(CommandLine::Parse({"--interval", "9000"}),
+               std::invalid_argument);
+}
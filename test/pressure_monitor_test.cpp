@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/pressure_monitor.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using std::filesystem::path;
+
+const path kPressureDirPath = kTestDataDirPath / path("pressure");
+
+class PressureMonitorTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    ScratchDir::SetUp();
+    for (const std::string& resource : PressureMonitor::kResources) {
+      std::filesystem::copy_file(kPressureDirPath / resource, dir_ / resource);
+    }
+  }
+};
+
+TEST(PressureTest, UpdateTest) {
+  PressureMonitor monitor(kPressureDirPath);
+  EXPECT_TRUE(monitor.Available());
+  auto& stats = monitor.Update();
+  ASSERT_EQ(stats.size(), 3);
+  EXPECT_EQ(stats[0].resource, "cpu");
+  EXPECT_DOUBLE_EQ(stats[0].some.avg10, 1.5);
+  EXPECT_FALSE(stats[0].has_full);
+  EXPECT_EQ(stats[1].resource, "memory");
+  EXPECT_TRUE(stats[1].has_full);
+  EXPECT_EQ(stats[1].full.total_us, 4567890);
+  EXPECT_EQ(stats[2].resource, "io");
+  EXPECT_EQ(stats[2].some.delta_us, 0);
+}
+
+TEST(PressureTest, UnavailableTest) {
+  PressureMonitor monitor(kTestDataDirPath / "bogus");
+  EXPECT_FALSE(monitor.Available());
+  EXPECT_TRUE(monitor.Update().empty());
+  ASSERT_THROW(monitor.AddTrigger("cpu:some:100:1000"), std::runtime_error);
+  // Without triggers waiting is a plain sleep.
+  EXPECT_FALSE(monitor.Wait(std::chrono::milliseconds(1)));
+}
+
+TEST(PressureTest, BadTriggerTest) {
+  PressureMonitor monitor(kPressureDirPath);
+  ASSERT_THROW(monitor.AddTrigger("cpu:some:100"), std::invalid_argument);
+  ASSERT_THROW(monitor.AddTrigger("gpu:some:100:1000"), std::invalid_argument);
+  ASSERT_THROW(monitor.AddTrigger("cpu:most:100:1000"), std::invalid_argument);
+  ASSERT_THROW(monitor.AddTrigger("cpu:some:1x:1000"), std::invalid_argument);
+  ASSERT_THROW(monitor.AddTrigger("cpu:some:100:100"), std::invalid_argument);
+  ASSERT_THROW(monitor.AddTrigger("cpu:some:2000:1000"), std::invalid_argument);
+  EXPECT_EQ(monitor.NumTriggers(), 0);
+}
+
+TEST_F(PressureMonitorTest, DeltaTest) {
+  PressureMonitor monitor(dir_);
+  monitor.Update();
+  std::ofstream(dir_ / "memory")
+      << "some avg10=20.00 avg60=6.00 avg300=1.50 total=9976543\n"
+      << "full avg10=4.00 avg60=1.20 avg300=0.20 total=4577890\n";
+  auto& stats = monitor.Update();
+  ASSERT_EQ(stats.size(), 3);
+  EXPECT_EQ(stats[1].some.delta_us, 100000);
+  EXPECT_EQ(stats[1].full.delta_us, 10000);
+  EXPECT_EQ(stats[0].some.delta_us, 0);
+}
+
+TEST_F(PressureMonitorTest, TriggerTest) {
+  PressureMonitor monitor(dir_);
+  monitor.AddTrigger("memory:some:150:1000");
+  EXPECT_EQ(monitor.NumTriggers(), 1);
+  std::ifstream stream(dir_ / "memory");
+  std::string written((std::istreambuf_iterator<char>(stream)),
+                      std::istreambuf_iterator<char>());
+  EXPECT_EQ(written.substr(0, 20), std::string("some 150000 1000000\0", 20));
+  // Regular files never raise POLLPRI, so the wait runs to its timeout.
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(monitor.Wait(std::chrono::milliseconds(20)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+  EXPECT_EQ(monitor.Events(), 0);
+}
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/linux_parser.h"
+#include "../include/proc_schema.h"
+
+#include <array>
+#include <filesystem>
+#include <string_view>
+
+using std::filesystem::path;
+
+
+struct TestKeys {
+  static constexpr std::array<std::string_view, 3> kKeys{"MemTotal:", "Cached:",
+                                                         "SwapFree:"};
+};
+
+static_assert(ProcSchema::Keyed<TestKeys>::Index("Cached:") == 1);
+static_assert(ProcSchema::Keyed<TestKeys>::Index("Cached") == 3);
+static_assert(ProcSchema::Stat<3, 13, 22>::Position(13) == 1);
+
+TEST(ProcSchemaTest, PositionalTest) {
+  using Statm = ProcSchema::Positional<1, 2>;
+  Statm::Values values;
+  EXPECT_TRUE(Statm::Extract("41466 2737 1877 24 0 6052 0\n", values));
+  EXPECT_EQ(values, (Statm::Values{2737, 1877}));
+  EXPECT_FALSE(Statm::Extract("41466 2737", values));
+}
+
+TEST(ProcSchemaTest, StatTest) {
+  using Schema = ProcSchema::Stat<0, 2, 3, 22>;
+  Schema::Values values;
+  EXPECT_TRUE(Schema::Extract(
+      "2879 (chromium-browse) S 2879 2371 2371 1026 2371 4194624 5867 8050999 "
+      "0 340 3 48 91213 12278 20 0 1 0 3570 169844736 2737 1",
+      values));
+  EXPECT_EQ(values, (Schema::Values{2879, 'S', 2879, 169844736}));
+}
+
+TEST(ProcSchemaTest, StatCommTest) {
+  // A command name can hold spaces and parentheses, only the last `)` ends it.
+  using Schema = ProcSchema::Stat<2, 3, 4>;
+  Schema::Values values;
+  EXPECT_TRUE(Schema::Extract("42 (a) b (c)) R 7 42 1", values));
+  EXPECT_EQ(values, (Schema::Values{'R', 7, 42}));
+  EXPECT_FALSE(Schema::Extract("42 (truncated", values));
+  EXPECT_FALSE(Schema::Extract("42 (short) R 7", values));
+}
+
+TEST(ProcSchemaTest, BadValueTest) {
+  using Statm = ProcSchema::Positional<0, 1>;
+  Statm::Values values;
+  // An overflowing counter is not taken for a state character.
+  EXPECT_FALSE(Statm::Extract("1 99999999999999999999999", values));
+  EXPECT_FALSE(Statm::Extract("1 abc", values));
+  EXPECT_TRUE(Statm::Extract("1 x", values));
+  EXPECT_EQ(values, (Statm::Values{1, 'x'}));
+  using Schema = ProcSchema::Stat<2, 13>;
+  Schema::Values stat;
+  EXPECT_FALSE(Schema::Extract(
+      "42 (a) R 1 1 1 0 -1 0 0 0 0 0 99999999999999999999999 1", stat));
+  using Keys = ProcSchema::Keyed<TestKeys>;
+  Keys::Values keyed;
+  EXPECT_FALSE(Keys::Extract("MemTotal: 99999999999999999999999 kB\n"
+                             "Cached: 5 kB\nSwapFree: 7 kB\n",
+                             keyed));
+  EXPECT_EQ(keyed, (Keys::Values{0, 5, 7}));
+}
+
+TEST(ProcSchemaTest, KeyedTest) {
+  using Schema = ProcSchema::Keyed<TestKeys>;
+  Schema::Values values;
+  EXPECT_TRUE(Schema::Extract("MemTotal:       16158544 kB\n"
+                              "MemFree:         7728836 kB\n"
+                              "Cached:          3012340 kB\n"
+                              "SwapFree:        2097148 kB\n",
+                              values));
+  EXPECT_EQ(values, (Schema::Values{16158544, 3012340, 2097148}));
+  EXPECT_FALSE(Schema::Extract("MemTotal:\t100 kB\nCached: 5 kB", values));
+  EXPECT_EQ(values, (Schema::Values{100, 5, 0}));
+}
+
+TEST(ProcSchemaTest, ProcessStatsTest) {
+  LinuxParser::ProcessStatSchema::Values values;
+  ASSERT_TRUE(LinuxParser::ProcessStats(kTestDataDirPath / "103" / "stat", values));
+  EXPECT_EQ(values[LinuxParser::ProcessStatSchema::Position(LinuxParser::kPpidStatIndex)], 2879);
+  EXPECT_EQ(values[LinuxParser::ProcessStatSchema::Position(LinuxParser::kVsizeStatIndex)], 169844736);
+  EXPECT_FALSE(LinuxParser::ProcessStats(kTestDataDirPath / "1234" / "stat", values));
+}
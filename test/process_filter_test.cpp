@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/linux_system.h"
+#include "../include/process.h"
+#include "../include/process_filter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+using std::filesystem::path;
+using std::vector;
+
+
+TEST(ProcessFilterTest, EmptyTest) {
+  ProcessFilter filter = ProcessFilter::Compile("  ");
+  EXPECT_TRUE(filter.Empty());
+  EXPECT_TRUE(filter.AcceptsPid(1));
+  EXPECT_TRUE(filter.AcceptsUser("root"));
+  EXPECT_TRUE(filter.AcceptsCommand("/sbin/init"));
+}
+
+TEST(ProcessFilterTest, StagesTest) {
+  ProcessFilter filter = ProcessFilter::Compile("user=build cmd~\"clang\" cpu>5");
+  EXPECT_FALSE(filter.HasPredicates(ProcessFilter::Stage::kPid));
+  EXPECT_TRUE(filter.HasPredicates(ProcessFilter::Stage::kStat));
+  EXPECT_TRUE(filter.HasPredicates(ProcessFilter::Stage::kStatus));
+  EXPECT_TRUE(filter.HasPredicates(ProcessFilter::Stage::kCmdline));
+  EXPECT_EQ(filter.Expression(), "user=build cmd~\"clang\" cpu>5");
+}
+
+TEST(ProcessFilterTest, PidTest) {
+  ProcessFilter filter = ProcessFilter::Compile("pid>=75 pid!=78");
+  EXPECT_FALSE(filter.AcceptsPid(1));
+  EXPECT_TRUE(filter.AcceptsPid(75));
+  EXPECT_FALSE(filter.AcceptsPid(78));
+  EXPECT_TRUE(filter.AcceptsPid(103));
+}
+
+TEST(ProcessFilterTest, TextTest) {
+  ProcessFilter filter = ProcessFilter::Compile("user!=root cmd~\"clang(\\\\+\\\\+)? -c\" cmd!~werror");
+  EXPECT_FALSE(filter.AcceptsUser("root"));
+  EXPECT_TRUE(filter.AcceptsUser("build"));
+  EXPECT_TRUE(filter.AcceptsCommand("/usr/bin/clang++ -c main.cpp"));
+  EXPECT_FALSE(filter.AcceptsCommand("/usr/bin/clang -c -werror main.cpp"));
+  EXPECT_FALSE(filter.AcceptsCommand("/usr/bin/gcc -c main.cpp"));
+}
+
+TEST(ProcessFilterTest, HandlesBadInput) {
+  ASSERT_THROW(ProcessFilter::Compile("size>5"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("cpu"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("cpu>"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("cpu>five"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("cpu~5"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("user>root"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("cmd=\"unterminated"), std::invalid_argument);
+  ASSERT_THROW(ProcessFilter::Compile("cmd~\"(\""), std::invalid_argument);
+}
+
+class ProcessFilterSystemTest : public testing::Test {
+ protected:
+  vector<int> Pids(const std::string& expression) {
+    system_.SetFilter(ProcessFilter::Compile(expression));
+    vector<int> pids;
+    for (auto& process : system_.Processes()) {
+      pids.push_back(process.Pid());
+    }
+    std::sort(pids.begin(), pids.end());
+    return pids;
+  }
+  LinuxSystem system_{FixtureSystem()};
+};
+
+TEST_F(ProcessFilterSystemTest, UnfilteredTest) {
+  EXPECT_EQ(Pids(""), vector<int>({1, 75, 78, 103}));
+}
+
+TEST_F(ProcessFilterSystemTest, PredicatesTest) {
+  EXPECT_EQ(Pids("user=foo"), vector<int>({103}));
+  EXPECT_EQ(Pids("cmd~snapfuse"), vector<int>({75, 78}));
+  EXPECT_EQ(Pids("ppid=1 pid<78"), vector<int>({75}));
+  EXPECT_EQ(Pids("user=root mem>100"), vector<int>({1}));
+  EXPECT_EQ(Pids("cpu>1000"), vector<int>());
+}
+
+TEST_F(ProcessFilterSystemTest, RepeatedCollectionTest) {
+  system_.SetFilter(ProcessFilter::Compile("user=root"));
+  EXPECT_EQ(system_.Processes().size(), 3);
+  EXPECT_EQ(system_.Processes().size(), 3);
+  EXPECT_EQ(system_.Tree().Size(), 3);
+}
+
+TEST(ProcessFilterExecTest, RejectionEndsAtExecTest) {
+  const path procsDirPath = std::filesystem::temp_directory_path() /
+                            ("process_filter_test_" + std::to_string(getpid()));
+  std::filesystem::remove_all(procsDirPath);
+  std::filesystem::create_directory(procsDirPath);
+  std::filesystem::copy(kTestDataDirPath / "103", procsDirPath / "103",
+                        std::filesystem::copy_options::recursive);
+  LinuxSystem system = FixtureSystem(procsDirPath);
+  system.SetFilter(ProcessFilter::Compile("cmd~clang"));
+  EXPECT_TRUE(system.Processes().empty());
+  EXPECT_TRUE(system.Processes().empty());
+
+  // The forked child execs the compiler.
+  const path statPath = procsDirPath / "103" / "stat";
+  std::string stat;
+  std::getline(std::ifstream(statPath), stat);
+  stat.replace(stat.find('('), stat.rfind(')') - stat.find('(') + 1, "(clang)");
+  std::ofstream(statPath) << stat << "\n";
+  std::ofstream(procsDirPath / "103" / "cmdline") << "clang -c main.c";
+  ASSERT_EQ(system.Processes().size(), 1);
+  EXPECT_EQ(system.Processes()[0].Command(), "clang -c main.c");
+  std::filesystem::remove_all(procsDirPath);
+}
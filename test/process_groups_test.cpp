@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/linux_system.h"
+#include "../include/process.h"
+#include "../include/process_groups.h"
+
+#include <string>
+#include <vector>
+
+using std::vector;
+
+
+namespace {
+Process Make(int pid, const std::string& user, const std::string& command,
+             float cpu, long memoryKb = 1000) {
+  return Process(pid, 1, user, command, cpu, memoryKb, 10);
+}
+}  // namespace
+
+TEST(ProcessGroupsTest, ManySmallProcessesTest) {
+  ProcessGroups groups;
+  vector<Process> processes;
+  for (int pid = 1000; pid < 1400; ++pid) {
+    processes.push_back(
+        Make(pid, "build", "/usr/bin/clang -c file" + std::to_string(pid) +
+                               ".cc", 0.003));
+  }
+  processes.push_back(Make(7, "root", "/usr/sbin/sshd -D", 0.5));
+  processes.push_back(Make(8, "foo", "vim notes", 0.1));
+  for (Process& process : processes) {
+    groups.Update(process);
+  }
+  EXPECT_EQ(groups.Size(GroupBy::kCommand), 3);
+  EXPECT_EQ(groups.Size(GroupBy::kUser), 3);
+  EXPECT_EQ(groups.Size(GroupBy::kProcess), 402);
+  const vector<ProcessGroups::Row> rows = groups.Rows(GroupBy::kCommand, 2);
+  ASSERT_EQ(rows.size(), 2);
+  EXPECT_EQ(rows[0].name, "clang");
+  EXPECT_EQ(rows[0].num_processes, 400);
+  EXPECT_NEAR(rows[0].cpu_utilization, 1.2, 1e-3);
+  EXPECT_EQ(rows[0].memory_kb, 400000);
+  EXPECT_EQ(rows[1].name, "sshd");
+  EXPECT_EQ(groups.Rows(GroupBy::kUser, 1)[0].name, "build");
+  EXPECT_TRUE(groups.Rows(GroupBy::kProcess, 10).empty());
+}
+
+TEST(ProcessGroupsTest, UpdateTest) {
+  ProcessGroups groups;
+  Process first = Make(10, "foo", "make all", 0.25, 100);
+  Process second = Make(11, "foo", "make -C sub", 0.5, 200);
+  groups.Update(first);
+  groups.Update(second);
+  // Only the change of a process is applied to its groups.
+  Process busier = Make(10, "foo", "make all", 0.75, 300);
+  groups.Update(busier);
+  groups.Update(second);
+  const ProcessGroups::Row row = groups.Rows(GroupBy::kCommand, 1)[0];
+  EXPECT_EQ(row.num_processes, 2);
+  EXPECT_FLOAT_EQ(row.cpu_utilization, 1.25);
+  EXPECT_EQ(row.memory_kb, 500);
+}
+
+TEST(ProcessGroupsTest, RemoveTest) {
+  ProcessGroups groups;
+  Process first = Make(10, "foo", "make", 0.25);
+  Process second = Make(11, "bar", "make", 0.5);
+  groups.Update(first);
+  groups.Update(second);
+  groups.Remove(10);
+  EXPECT_EQ(groups.Size(GroupBy::kUser), 1);
+  const ProcessGroups::Row row = groups.Rows(GroupBy::kCommand, 5)[0];
+  EXPECT_EQ(row.num_processes, 1);
+  EXPECT_FLOAT_EQ(row.cpu_utilization, 0.5);
+  groups.Remove(11);
+  groups.Remove(11);
+  EXPECT_EQ(groups.Size(GroupBy::kCommand), 0);
+  EXPECT_EQ(groups.Size(GroupBy::kProcess), 0);
+}
+
+TEST(ProcessGroupsTest, ExecTest) {
+  ProcessGroups groups;
+  Process shell = Make(10, "foo", "/bin/bash", 0.25);
+  groups.Update(shell);
+  // The pid now runs another command, and moves to its group.
+  Process exec = Make(10, "foo", "/usr/bin/python3 script.py", 0.5);
+  groups.Update(exec);
+  const vector<ProcessGroups::Row> rows = groups.Rows(GroupBy::kCommand, 5);
+  ASSERT_EQ(rows.size(), 1);
+  EXPECT_EQ(rows[0].name, "python3");
+  EXPECT_FLOAT_EQ(rows[0].cpu_utilization, 0.5);
+  EXPECT_EQ(groups.Rows(GroupBy::kUser, 5)[0].num_processes, 1);
+}
+
+TEST(ProcessGroupsTest, BasenameTest) {
+  EXPECT_EQ(ProcessGroups::Basename("/usr/bin/clang -c a.cc"), "clang");
+  EXPECT_EQ(ProcessGroups::Basename("vim"), "vim");
+  EXPECT_EQ(ProcessGroups::Basename(""), "");
+}
+
+TEST(ProcessGroupsTest, NextTest) {
+  EXPECT_EQ(ProcessGroups::Next(GroupBy::kProcess), GroupBy::kUser);
+  EXPECT_EQ(ProcessGroups::Next(GroupBy::kUser), GroupBy::kCommand);
+  EXPECT_EQ(ProcessGroups::Next(GroupBy::kCommand), GroupBy::kProcess);
+  EXPECT_STREQ(ProcessGroups::Name(GroupBy::kCommand), "command");
+}
+
+TEST(ProcessGroupsTest, LinuxSystemTest) {
+  LinuxSystem system{FixtureSystem()};
+  system.Processes();
+  ProcessGroups& groups = system.Groups();
+  EXPECT_EQ(groups.Size(GroupBy::kProcess), system.Processes().size());
+  int num_processes = 0;
+  for (const ProcessGroups::Row& row : groups.Rows(GroupBy::kUser, 100)) {
+    num_processes += row.num_processes;
+  }
+  EXPECT_EQ(num_processes, int(system.Processes().size()));
+}
@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include "../include/process_sort.h"
+
+#include <vector>
+
+static std::vector<int> Pids(std::vector<Process>& processes) {
+  std::vector<int> pids;
+  for (Process& process : processes) {
+    pids.push_back(process.Pid());
+  }
+  return pids;
+}
+
+class ProcessSortTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    processes_.emplace_back(7, 1, "root", "init", 0.10, 2000, 50);
+    processes_.emplace_back(3, 1, "foo", "bash", 0.50, 1000, 10);
+    processes_.emplace_back(12, 3, "foo", "vim", 0.25, 9000, 30);
+  }
+  std::vector<Process> processes_;
+};
+
+TEST_F(ProcessSortTest, KeysTest) {
+  ProcessSort::Sort(processes_, SortKey::kCpu);
+  EXPECT_EQ(Pids(processes_), std::vector<int>({3, 12, 7}));
+  ProcessSort::Sort(processes_, SortKey::kMemory);
+  EXPECT_EQ(Pids(processes_), std::vector<int>({12, 7, 3}));
+  ProcessSort::Sort(processes_, SortKey::kTime);
+  EXPECT_EQ(Pids(processes_), std::vector<int>({7, 12, 3}));
+  ProcessSort::Sort(processes_, SortKey::kPid);
+  EXPECT_EQ(Pids(processes_), std::vector<int>({3, 7, 12}));
+  EXPECT_EQ(processes_[2].Command(), "vim");
+}
+
+TEST_F(ProcessSortTest, TopTest) {
+  processes_.emplace_back(5, 1, "foo", "make", 0.75, 500, 5);
+  ProcessSort::Top(processes_, SortKey::kCpu, 2);
+  // The others keep their order after the top ones.
+  EXPECT_EQ(Pids(processes_), std::vector<int>({5, 3, 7, 12}));
+  ProcessSort::Top(processes_, SortKey::kPid, 10);
+  EXPECT_EQ(Pids(processes_), std::vector<int>({3, 5, 7, 12}));
+}
+
+TEST(ProcessSortKeyTest, CycleTest) {
+  SortKey key = SortKey::kCpu;
+  std::vector<std::string> names;
+  for (int i = 0; i < 7; ++i) {
+    names.push_back(ProcessSort::Name(key));
+    key = ProcessSort::Next(key);
+  }
+  EXPECT_EQ(key, SortKey::kCpu);
+  EXPECT_EQ(names, std::vector<std::string>(
+                       {"cpu", "mem", "time", "pid", "wait", "csw", "fds"}));
+}
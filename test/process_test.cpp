@@ -1,34 +1,26 @@
 #include "gtest/gtest.h"
+#include "test_data.h"
 #include "../include/linux_system.h"
 #include "../include/linux_parser.h"
 #include "../include/processor.h"
 #include "../include/process.h"
 
 #include <algorithm>
+#include <chrono>
 #include <string>
 #include <filesystem>
+#include <fstream>
+#include <thread>
 #include <unistd.h>
 
 using std::string;
 using std::filesystem::path;
 
-const path kTestDir("test");
-const path kTestDataDir("testdata");
-const path kTestDataDirPath = std::filesystem::current_path() / kTestDir / kTestDataDir;
-const path kOSVersionFilePath = kTestDataDirPath / path("fake_os_release");
-const path kkernelInfoFilePath = kTestDataDirPath / path("fake_proc_version");
-const path kEtcPasswdFilePath = kTestDataDirPath / path("fake_etc_passwd");
-const path kMemInfoFilePath = kTestDataDirPath / path("fake_meminfo");
-const path kStatsFilePath = kTestDataDirPath / path("fake_stat");
-const path kUptimeFilePath = kTestDataDirPath / path("fake_uptime");
-const path kRecentMemInfoFilePath = kTestDataDirPath / path("recent_meminfo");
-const path kRecentStatsFilePath = kTestDataDirPath / path("recent_stat");
-const path kRecentUptimeFilePath = kTestDataDirPath / path("recent_uptime");
 
 class ProcTest : public testing::Test {
  protected:
- LinuxSystem system_{kTestDataDirPath.generic_string(), kTestDataDirPath.generic_string(), kMemInfoFilePath.generic_string(), kOSVersionFilePath.generic_string(), kTestDataDirPath.generic_string(), kStatsFilePath.generic_string(), kUptimeFilePath.generic_string(), kkernelInfoFilePath.generic_string(), kEtcPasswdFilePath.generic_string()};
- LinuxSystem recent_system_{kTestDataDirPath.generic_string(), kTestDataDirPath.generic_string(), kRecentMemInfoFilePath.generic_string(), kOSVersionFilePath.generic_string(), kTestDataDirPath.generic_string(), kRecentStatsFilePath.generic_string(), kRecentUptimeFilePath.generic_string(), kkernelInfoFilePath.generic_string(), kEtcPasswdFilePath.generic_string()};
+ LinuxSystem system_{FixtureSystem(kTestDataDirPath, kFakeMemInfoFilePath, kFakeStatsFilePath, kFakeUptimeFilePath)};
+ LinuxSystem recent_system_{FixtureSystem()};
  Process p1_{&recent_system_, 1, "root", "/sbin/init", kTestDataDirPath};
  Process p75_{&system_, 75, "root", "snapfuse /var/lib/snapd/snaps/bare_5.snap /snap/bare/5 -o ro,nodev,allow_other,suid ", kTestDataDirPath};
  Process p78_{&recent_system_, 78, "root", "snapfuse /var/lib/snapd/snaps/bare_5.snap /snap/bare/5 -o ro,nodev,allow_other,suid ", kTestDataDirPath};
@@ -133,4 +125,59 @@ TEST_F(ProcTest, SortTest) {
  EXPECT_EQ(procs[1], p1_);
  EXPECT_EQ(procs[2], p78_);
  EXPECT_EQ(procs[3], p75_);
-}
\ No newline at end of file
+}
+TEST_F(ProcTest, PpidTest) {
+ EXPECT_EQ(p1_.Ppid(), 0);
+ EXPECT_EQ(p75_.Ppid(), 1);
+}
+
+TEST_F(ProcTest, VirtualMemoryTest) {
+ EXPECT_EQ(p1_.VirtualMemoryKb(), 165872);
+ EXPECT_EQ(p103_.VirtualMemoryKb(), 165864);
+}
+
+TEST_F(ProcTest, RestoreTest) {
+ const long ticks = p1_.TotalTicks();
+ const double sampleTime = p1_.SampleTime();
+ EXPECT_FALSE(p1_.Restore(p1_.StartTime() + 1, ticks - 100, sampleTime - 2));
+ EXPECT_FALSE(p1_.Restore(p1_.StartTime(), ticks + 1, sampleTime - 2));
+ ASSERT_TRUE(p1_.Restore(p1_.StartTime(), ticks - 100, sampleTime - 2));
+ EXPECT_FLOAT_EQ(p1_.CpuUtilization(), (100 / cpuHertz) / 2);
+}
+
+TEST_F(ProcTest, SampleTierTest) {
+ // Active until a later sample shows it idle.
+ EXPECT_EQ(p1_.Tier(), SampleTier::kHot);
+ EXPECT_FALSE(p1_.SampleDue());
+ EXPECT_FALSE(p1_.Running());
+ EXPECT_EQ(p1_.Threads(), 1);
+}
+
+TEST(ProcessSchedTest, RatesTest) {
+ const path procsDirPath = std::filesystem::temp_directory_path() /
+                           ("process_sched_test_" + std::to_string(getpid()));
+ std::filesystem::remove_all(procsDirPath);
+ std::filesystem::create_directory(procsDirPath);
+ std::filesystem::copy(kTestDataDirPath / "103", procsDirPath / "103",
+                       std::filesystem::copy_options::recursive);
+ LinuxSystem system = FixtureSystem(procsDirPath);
+ Process process(&system, 103, procsDirPath);
+ SchedRates rates = process.Sched();
+ EXPECT_EQ(rates.wait, 0);
+ EXPECT_EQ(rates.involuntary_switches, 0);
+
+ // 10 timeslices after waiting 50ms in all, and 10 preemptions.
+ std::ofstream(procsDirPath / "103" / "schedstat") << "1334567890 148765432 4331\n";
+ string status;
+ LinuxParser::ReadFile(procsDirPath / "103" / "status", status);
+ status.replace(status.find("108"), 3, "118");
+ std::ofstream(procsDirPath / "103" / "status") << status;
+ std::this_thread::sleep_for(kUpdateInterval + std::chrono::milliseconds(100));
+ rates = process.Sched();
+ EXPECT_DOUBLE_EQ(rates.latency, 0.005);
+ EXPECT_GT(rates.run, rates.wait);
+ EXPECT_GT(rates.wait, 0);
+ EXPECT_GT(rates.involuntary_switches, 0);
+ EXPECT_EQ(rates.voluntary_switches, 0);
+ std::filesystem::remove_all(procsDirPath);
+}
@@ -0,0 +1,196 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/linux_system.h"
+#include "../include/process.h"
+#include "../include/process_tree.h"
+
+#include <filesystem>
+#include <vector>
+
+using std::filesystem::path;
+using std::vector;
+
+// Passes a process for each of `pids` to the tree, which gives them rows. The
+// rows refer to the returned processes.
+static vector<Process> Show(ProcessTree& tree, const vector<int>& pids) {
+  vector<Process> processes;
+  for (const int pid : pids) {
+    processes.emplace_back(pid, tree.Parent(pid), "root", "cmd", 0, 0, 0);
+  }
+  for (Process& process : processes) {
+    tree.Update(process);
+  }
+  return processes;
+}
+
+TEST(ProcessTreeTest, InsertTest) {
+  ProcessTree tree;
+  tree.Insert(1, 0);
+  tree.Insert(2, 1);
+  tree.Insert(3, 1);
+  tree.Insert(4, 2);
+  EXPECT_EQ(tree.Size(), 4);
+  EXPECT_EQ(tree.Children(0), vector<int>({1}));
+  EXPECT_EQ(tree.Children(1), vector<int>({2, 3}));
+  EXPECT_EQ(tree.Children(2), vector<int>({4}));
+  EXPECT_EQ(tree.Parent(4), 2);
+}
+
+TEST(ProcessTreeTest, PidOrderTest) {
+  ProcessTree tree;
+  tree.Insert(1, 0);
+  tree.Insert(30, 1);
+  tree.Insert(10, 1);
+  tree.Insert(20, 1);
+  tree.Insert(40, 1);
+  EXPECT_EQ(tree.Children(1), vector<int>({10, 20, 30, 40}));
+}
+
+TEST(ProcessTreeTest, ParentInsertedLaterTest) {
+  ProcessTree tree;
+  tree.Insert(10, 5);
+  EXPECT_EQ(tree.Parent(10), 0);
+  tree.Insert(5, 0);
+  EXPECT_EQ(tree.Parent(10), 5);
+  EXPECT_EQ(tree.Children(0), vector<int>({5}));
+}
+
+TEST(ProcessTreeTest, CycleTest) {
+  ProcessTree tree;
+  tree.Insert(5, 5);
+  EXPECT_EQ(tree.Parent(5), 0);
+  tree.Insert(1, 0);
+  tree.Insert(2, 1);
+  tree.Insert(3, 2);
+  // A reused pid 1 that claims its grandchild as parent.
+  tree.Insert(1, 3);
+  EXPECT_EQ(tree.Parent(1), 0);
+  EXPECT_EQ(tree.Parent(3), 2);
+  // A child waiting for a parent that turns out to be below it.
+  tree.Insert(10, 11);
+  tree.Insert(11, 10);
+  EXPECT_EQ(tree.Parent(11), 10);
+  EXPECT_EQ(tree.Parent(10), 0);
+}
+
+TEST(ProcessTreeTest, NeighborTest) {
+  ProcessTree tree;
+  EXPECT_EQ(ProcessTree::Neighbor(tree.Rows(10), 1, 1), -1);
+  tree.Insert(1, 0);
+  tree.Insert(2, 1);
+  tree.Insert(3, 2);
+  tree.Insert(4, 1);
+  vector<Process> processes = Show(tree, {1, 2, 3, 4});
+  auto& rows = tree.Rows(10);
+  EXPECT_EQ(rows[2].pid, 3);
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 2, 1), 3);
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 3, -2), 1);
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 1, -1), 1);
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 4, 1), 4);
+  // A pid that is not shown starts from the top.
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 99, 0), 1);
+  // Collapsing the selected row hides its children from the selection.
+  tree.ToggleCollapsed(2);
+  EXPECT_EQ(ProcessTree::Neighbor(tree.Rows(10), 2, 1), 4);
+}
+
+TEST(ProcessTreeTest, RemoveTest) {
+  ProcessTree tree;
+  tree.Insert(1, 0);
+  tree.Insert(2, 1);
+  tree.Insert(3, 2);
+  tree.Insert(4, 2);
+  tree.Remove(2);
+  EXPECT_EQ(tree.Size(), 3);
+  EXPECT_EQ(tree.Parent(2), -1);
+  EXPECT_EQ(tree.Children(1), vector<int>());
+  // The orphans stay visible until they are re-inserted with their new parent.
+  EXPECT_EQ(tree.Children(0), vector<int>({1, 3, 4}));
+  tree.Insert(3, 1);
+  tree.Insert(4, 1);
+  EXPECT_EQ(tree.Children(0), vector<int>({1}));
+  EXPECT_EQ(tree.Children(1), vector<int>({3, 4}));
+}
+
+TEST(ProcessTreeTest, CollapseTest) {
+  ProcessTree tree;
+  tree.Insert(1, 0);
+  tree.Insert(2, 1);
+  tree.Insert(3, 2);
+  tree.Insert(4, 1);
+  vector<Process> processes = Show(tree, {1, 2, 3, 4});
+  auto& rows = tree.Rows(10);
+  ASSERT_EQ(rows.size(), 4);
+  EXPECT_EQ(rows[0].depth, 0);
+  EXPECT_EQ(rows[1].depth, 1);
+  EXPECT_EQ(rows[2].depth, 2);
+  EXPECT_EQ(rows[3].depth, 1);
+  EXPECT_TRUE(tree.ToggleCollapsed(2));
+  auto& collapsed = tree.Rows(10);
+  ASSERT_EQ(collapsed.size(), 3);
+  EXPECT_TRUE(collapsed[1].collapsed);
+  EXPECT_EQ(collapsed[1].num_children, 1);
+  EXPECT_EQ(collapsed[2].depth, 1);
+  EXPECT_FALSE(tree.ToggleCollapsed(2));
+  EXPECT_EQ(tree.Rows(2).size(), 2);
+}
+
+TEST(ProcessTreeTest, UnshownRowsTest) {
+  ProcessTree tree;
+  tree.Insert(1, 0);
+  tree.Insert(2, 1);
+  tree.Insert(3, 2);
+  tree.Insert(4, 1);
+  // 2 has not been passed to the tree, so it has no row to select.
+  vector<Process> processes = Show(tree, {1, 3, 4});
+  auto& rows = tree.Rows(10);
+  ASSERT_EQ(rows.size(), 3);
+  EXPECT_EQ(rows[1].pid, 3);
+  EXPECT_EQ(rows[1].depth, 2);
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 1, 1), 3);
+  EXPECT_EQ(ProcessTree::Neighbor(rows, 3, 1), 4);
+  // Every row has a process to draw.
+  for (const ProcessTree::Row& row : rows) {
+    EXPECT_NE(row.process, nullptr);
+  }
+  EXPECT_EQ(tree.Rows(2).size(), 2);
+}
+
+class ProcessTreeSystemTest : public testing::Test {
+ protected:
+  LinuxSystem system_{FixtureSystem()};
+};
+
+TEST_F(ProcessTreeSystemTest, SubtreeTotalsTest) {
+  auto& processes = system_.Processes();
+  ProcessTree& tree = system_.Tree();
+  EXPECT_EQ(tree.Size(), 4);
+  EXPECT_EQ(tree.Children(1), vector<int>({75, 78}));
+  float cpu = 0;
+  long memory = 0;
+  for (auto& process : processes) {
+    if (process.Pid() != 103) {
+      cpu += process.CpuUtilization();
+      memory += process.VirtualMemoryKb();
+    }
+  }
+  EXPECT_FLOAT_EQ(tree.SubtreeCpuUtilization(1), cpu);
+  EXPECT_EQ(tree.SubtreeMemoryKb(1), memory);
+  auto& rows = tree.Rows(10);
+  ASSERT_EQ(rows.size(), 4);
+  EXPECT_EQ(rows[0].process->Pid(), 1);
+  EXPECT_EQ(rows[1].process->Pid(), 75);
+  EXPECT_EQ(rows[2].process->Pid(), 78);
+  // The parent of the chromium fixture is not running.
+  EXPECT_EQ(rows[3].process->Pid(), 103);
+  EXPECT_EQ(rows[3].depth, 0);
+}
+
+TEST_F(ProcessTreeSystemTest, IncrementalUpdateTest) {
+  system_.Processes();
+  ProcessTree& tree = system_.Tree();
+  system_.Processes();
+  EXPECT_EQ(&system_.Tree(), &tree);
+  EXPECT_EQ(tree.Size(), 4);
+  EXPECT_EQ(tree.Children(1), vector<int>({75, 78}));
+}
@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/process_watch.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::filesystem::path;
+using std::vector;
+
+// A proc filesystem where 1 forked 10 from its main thread and 20 from
+// another thread, 10 forked 30, and 99 is unrelated; and a cgroup hierarchy
+// with 10 in app.slice and 20 in a child group of it.
+class ProcessWatchTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    ScratchDir::SetUp();
+    AddProcess(1, "init", {{1, "10 "}, {2, "20 "}});
+    AddProcess(10, "nginx", {{10, "30 "}});
+    AddProcess(20, "a-very-long-command", {{20, ""}});
+    AddProcess(30, "worker", {{30, ""}});
+    AddProcess(99, "nginx-unrelated", {{99, ""}});
+    Write(cgroups() / "app.slice" / "cgroup.procs", "10\n");
+    Write(cgroups() / "app.slice" / "child" / "cgroup.procs", "20\n");
+  }
+  path procs() const { return dir_ / "proc"; }
+  path cgroups() const { return dir_ / "cgroup"; }
+  static void Write(const path& filePath, const std::string& contents) {
+    std::filesystem::create_directories(filePath.parent_path());
+    std::ofstream(filePath) << contents;
+  }
+  // Adds a process with its threads, each with the children it forked.
+  void AddProcess(int pid, const std::string& comm,
+                  const vector<std::pair<int, std::string>>& tasks,
+                  long startTime = 100) {
+    const path process = procs() / std::to_string(pid);
+    Write(process / "stat", std::to_string(pid) + " (" + comm.substr(0, 15) +
+                                ") S 1 1 1 0 -1 0 0 0 0 0 1 1 0 0 20 0 1 0 " +
+                                std::to_string(startTime) + " 4096 1");
+    for (const auto& [tid, children] : tasks) {
+      Write(process / "task" / std::to_string(tid) / "children", children);
+    }
+  }
+  vector<int> List(WatchTarget target) {
+    ProcessWatch watch(procs().string(), cgroups().string(),
+                       std::move(target));
+    vector<int> pids;
+    watch.List(pids);
+    return pids;
+  }
+};
+
+TEST_F(ProcessWatchTest, DescendantsTest) {
+  EXPECT_EQ(List({{10}, {}, ""}), vector<int>({10, 30}));
+  // Through the children of every thread.
+  EXPECT_EQ(List({{1}, {}, ""}), vector<int>({1, 10, 20, 30}));
+  EXPECT_EQ(List({{20, 99}, {}, ""}), vector<int>({20, 99}));
+  EXPECT_TRUE(List({{42}, {}, ""}).empty());
+}
+
+TEST_F(ProcessWatchTest, OrphansTest) {
+  ProcessWatch watch(procs().string(), cgroups().string(), {{10}, {}, ""});
+  vector<int> pids;
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({10, 30}));
+  // 10 exits, and 30 is re-parented elsewhere.
+  std::filesystem::remove_all(procs() / "10");
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({30}));
+  std::filesystem::remove_all(procs() / "30");
+  watch.List(pids);
+  EXPECT_TRUE(pids.empty());
+}
+
+TEST_F(ProcessWatchTest, ReusedPidTest) {
+  ProcessWatch watch(procs().string(), cgroups().string(), {{10}, {}, ""});
+  vector<int> pids;
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({10, 30}));
+  // 30 is orphaned and followed, until its pid goes to another process.
+  Write(procs() / "10" / "task" / "10" / "children", "");
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({10, 30}));
+  AddProcess(30, "unrelated", {{30, ""}}, 500);
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({10}));
+  // Forked by 10 again, it is watched with its new start time.
+  Write(procs() / "10" / "task" / "10" / "children", "30 ");
+  watch.List(pids);
+  Write(procs() / "10" / "task" / "10" / "children", "");
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({10, 30}));
+}
+
+TEST_F(ProcessWatchTest, NamesTest) {
+  EXPECT_EQ(List({{}, {"nginx"}, ""}), vector<int>({10, 30}));
+  // Names are compared as truncated by the kernel.
+  EXPECT_EQ(List({{}, {"a-very-long-command"}, ""}), vector<int>({20}));
+  EXPECT_EQ(List({{}, {"worker", "init"}, ""}),
+            vector<int>({1, 10, 20, 30}));
+  EXPECT_TRUE(List({{}, {"ngin"}, ""}).empty());
+}
+
+TEST_F(ProcessWatchTest, CgroupTest) {
+  // With the child groups, and the descendants of the members.
+  EXPECT_EQ(List({{}, {}, "app.slice"}), vector<int>({10, 20, 30}));
+  EXPECT_EQ(List({{}, {}, "app.slice/child"}), vector<int>({20}));
+  EXPECT_EQ(List({{99}, {}, "app.slice/child"}), vector<int>({20, 99}));
+  EXPECT_TRUE(List({{}, {}, "missing.slice"}).empty());
+}
+
+TEST_F(ProcessWatchTest, ActiveTest) {
+  EXPECT_FALSE(ProcessWatch().Active());
+  EXPECT_FALSE(ProcessWatch(procs().string(), cgroups().string(), {}).Active());
+  EXPECT_TRUE(
+      ProcessWatch(procs().string(), cgroups().string(), {{1}, {}, ""})
+          .Active());
+}
+
+TEST(ProcessWatchParseTest, ParsePidsTest) {
+  EXPECT_EQ(ProcessWatch::ParsePids("12"), vector<int>({12}));
+  EXPECT_EQ(ProcessWatch::ParsePids("12,345"), vector<int>({12, 345}));
+  EXPECT_THROW(ProcessWatch::ParsePids(""), std::invalid_argument);
+  EXPECT_THROW(ProcessWatch::ParsePids("12,,3"), std::invalid_argument);
+  EXPECT_THROW(ProcessWatch::ParsePids("12,x"), std::invalid_argument);
+  EXPECT_THROW(ProcessWatch::ParsePids("0"), std::invalid_argument);
+  EXPECT_THROW(ProcessWatch::ParsePids("-3"), std::invalid_argument);
+}
+
+// Against the real /proc, a watch of this process lists it alone.
+TEST(ProcessWatchProcTest, SelfTest) {
+  ProcessWatch watch("/proc", "/sys/fs/cgroup", {{getpid()}, {}, ""});
+  vector<int> pids;
+  watch.List(pids);
+  EXPECT_EQ(pids, vector<int>({getpid()}));
+}
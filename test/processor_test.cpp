@@ -1,12 +1,15 @@
 #include "gtest/gtest.h"
+#include "test_data.h"
 #include "../include/processor.h"
 #include "../include/linux_parser.h"
 
+#include <unistd.h>
+
 #include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
 
-const std::filesystem::path kTestDir("test");
-const std::filesystem::path kTestDataDir("testdata");
-const std::filesystem::path kTestDataDirPath = std::filesystem::current_path() / kTestDir / kTestDataDir;
 
 TEST(CPUUtilizationTest, FakeStatTest) {
   std::filesystem::path file("fake_stat");
@@ -25,3 +28,30 @@ TEST(CPUUtilizationTest, FakeCPUStatTest) {
   const float actual = p.Utilization();
   EXPECT_FLOAT_EQ(actual, expected);
 }
+
+TEST(CPUUtilizationTest, IntervalTest) {
+  std::filesystem::path stat_data_path = kTestDataDirPath / "fake_stat";
+  Processor p{stat_data_path.generic_string()};
+  EXPECT_EQ(p.Counters(), std::make_pair(-1L, -1L));
+  const float lifetime = p.Utilization();
+  const auto [active, total] = p.Counters();
+  // No time passed, the previous value stands.
+  EXPECT_FLOAT_EQ(p.Utilization(), lifetime);
+  p.Restore(active - 50, total - 200);
+  EXPECT_FLOAT_EQ(p.Utilization(), 0.25);
+}
+
+TEST(CPUUtilizationTest, RepeatedSampleTest) {
+  const std::filesystem::path stat_data_path =
+      std::filesystem::temp_directory_path() /
+      ("processor_test_" + std::to_string(getpid()));
+  std::ofstream(stat_data_path) << "cpu  100 0 0 100 0 0 0 0 0 0\n";
+  Processor p{stat_data_path.generic_string()};
+  EXPECT_FLOAT_EQ(p.Utilization(), 0.5);
+  std::ofstream(stat_data_path) << "cpu  200 0 0 100 0 0 0 0 0 0\n";
+  // A second reader of the same collection gets the same sample.
+  EXPECT_FLOAT_EQ(p.Utilization(), 0.5);
+  std::this_thread::sleep_for(kMinSampleInterval);
+  EXPECT_FLOAT_EQ(p.Utilization(), 1.0);
+  std::filesystem::remove(stat_data_path);
+}
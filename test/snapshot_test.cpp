@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/linux_system.h"
+#include "../include/snapshot.h"
+#include "../include/snapshot_system.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using std::filesystem::path;
+
+
+class SnapshotTest : public testing::Test {
+ protected:
+  const std::string name_ = "/monitor-test-" + std::to_string(getpid());
+  LinuxSystem system_{FixtureSystem()};
+};
+
+TEST_F(SnapshotTest, NoCollectorTest) {
+  ASSERT_THROW(SnapshotSystem{name_}, std::runtime_error);
+}
+
+TEST_F(SnapshotTest, SecondPublisherTest) {
+  SnapshotPublisher publisher(name_);
+  ASSERT_THROW(SnapshotPublisher{name_}, std::runtime_error);
+  // The first collector keeps its region.
+  publisher.Publish(system_);
+  SnapshotReader reader(name_);
+  EXPECT_GT(reader.Generation(), 0);
+}
+
+TEST_F(SnapshotTest, AbandonedRegionTest) {
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    // A collector that crashes without removing its region.
+    new SnapshotPublisher(name_);
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_NO_THROW(SnapshotPublisher{name_});
+}
+
+TEST_F(SnapshotTest, SystemTest) {
+  SnapshotPublisher publisher(name_);
+  publisher.Publish(system_);
+  SnapshotSystem snapshot(name_);
+  EXPECT_FLOAT_EQ(snapshot.Cpu().Utilization(), system_.Cpu().Utilization());
+  EXPECT_FLOAT_EQ(snapshot.MemoryUtilization(), system_.MemoryUtilization());
+  EXPECT_EQ(snapshot.UpTime(), 552);
+  EXPECT_EQ(snapshot.TotalProcesses(), 3464);
+  EXPECT_EQ(snapshot.RunningProcesses(), 1);
+  EXPECT_EQ(snapshot.BlockedProcesses(), 0);
+  EXPECT_EQ(snapshot.Kernel(), "5.15.146.1-microsoft-standard-WSL2");
+  EXPECT_EQ(snapshot.OperatingSystem(), "Ubuntu 22.04.4 LTS");
+}
+
+TEST_F(SnapshotTest, ProcessesTest) {
+  SnapshotPublisher publisher(name_);
+  publisher.Publish(system_);
+  SnapshotSystem snapshot(name_);
+  auto& expected = system_.Processes();
+  auto& actual = snapshot.Processes();
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_EQ(actual[i].Pid(), expected[i].Pid());
+    EXPECT_EQ(actual[i].Ppid(), expected[i].Ppid());
+    EXPECT_EQ(actual[i].User(), expected[i].User());
+    EXPECT_EQ(actual[i].Command(), expected[i].Command());
+    EXPECT_FLOAT_EQ(actual[i].CpuUtilization(), expected[i].CpuUtilization());
+    EXPECT_EQ(actual[i].VirtualMemoryKb(), expected[i].VirtualMemoryKb());
+    EXPECT_EQ(actual[i].UpTime(), expected[i].UpTime());
+  }
+  EXPECT_EQ(snapshot.Tree().Children(1), std::vector<int>({75, 78}));
+}
+
+TEST_F(SnapshotTest, LatestSnapshotTest) {
+  SnapshotPublisher publisher(name_);
+  SnapshotSystem snapshot(name_);
+  EXPECT_EQ(snapshot.Processes().size(), 0);
+  publisher.Publish(system_);
+  EXPECT_EQ(snapshot.Processes().size(), 4);
+  system_.SetFilter(ProcessFilter::Compile("user=foo"));
+  publisher.Publish(system_);
+  ASSERT_EQ(snapshot.Processes().size(), 1);
+  EXPECT_EQ(snapshot.Processes()[0].Pid(), 103);
+  EXPECT_EQ(snapshot.Tree().Size(), 1);
+}
+
+// A region written by someone else is read within its bounds.
+TEST_F(SnapshotTest, MalformedSnapshotTest) {
+  SnapshotPublisher publisher(name_);
+  auto data = std::make_unique<SnapshotData>();
+  std::memset(data.get(), 'x', sizeof(SnapshotData));
+  data->num_processes = 1 << 30;
+  publisher.Publish(*data);
+  SnapshotSystem snapshot(name_);
+  auto& processes = snapshot.Processes();
+  ASSERT_EQ(processes.size(), kMaxSnapshotProcesses);
+  EXPECT_EQ(processes[0].User().size(), sizeof(SnapshotProcess::user));
+  EXPECT_EQ(processes[0].Command().size(), sizeof(SnapshotProcess::command));
+  EXPECT_EQ(snapshot.Kernel().size(), sizeof(SnapshotData::kernel));
+  data->num_processes = -1;
+  publisher.Publish(*data);
+  EXPECT_TRUE(snapshot.Processes().empty());
+}
+
+// Only the owner may write to a region a reader trusts.
+TEST_F(SnapshotTest, WritableRegionTest) {
+  SnapshotPublisher publisher(name_);
+  const std::filesystem::path region = "/dev/shm" + name_;
+  std::filesystem::permissions(region, std::filesystem::perms::others_write,
+                               std::filesystem::perm_options::add);
+  ASSERT_THROW(SnapshotReader{name_}, std::runtime_error);
+}
+
+// A reader must never observe a snapshot that is partly from one publication
+// and partly from another, however the writes interleave with its reads.
+TEST_F(SnapshotTest, ConsistentReadsTest) {
+  SnapshotPublisher publisher(name_);
+  SnapshotReader reader(name_);
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    auto data = std::make_unique<SnapshotData>();
+    std::memset(data.get(), 0, sizeof(SnapshotData));
+    for (int i = 1; i <= 20000; ++i) {
+      data->uptime = i;
+      data->total_processes = i;
+      data->num_processes = kMaxSnapshotProcesses;
+      data->processes[kMaxSnapshotProcesses - 1].pid = i;
+      publisher.Publish(*data);
+    }
+    done = true;
+  });
+  auto data = std::make_unique<SnapshotData>();
+  long last = 0;
+  int torn = 0;
+  while (!done) {
+    reader.Read(*data);
+    if (data->total_processes != data->uptime ||
+        data->processes[kMaxSnapshotProcesses - 1].pid != data->uptime ||
+        data->uptime < last) {
+      ++torn;
+    }
+    last = data->uptime;
+  }
+  writer.join();
+  EXPECT_EQ(torn, 0);
+  reader.Read(*data);
+  EXPECT_EQ(data->uptime, 20000);
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/stat_splitter.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using StatSplitter::Fields;
+using StatSplitter::Isa;
+
+namespace {
+const std::vector<Isa> kIsas{Isa::kScalar, Isa::kSse2, Isa::kAvx2};
+
+std::vector<std::string> Split(Isa isa, std::string_view line,
+                               std::size_t maxFields) {
+  Fields fields;
+  std::vector<std::string> split;
+  if (!StatSplitter::Split(isa, line, maxFields, fields)) {
+    split.push_back("<invalid>");
+    return split;
+  }
+  for (std::size_t i = 0; i < fields.count; ++i) {
+    split.emplace_back(fields.Field(line, i));
+  }
+  split.push_back(std::to_string(fields.comm_end));
+  return split;
+}
+
+// A stat-like line: a pid, a command name of random bytes including spaces
+// and parentheses, then fields of varying length and separators.
+std::string RandomLine(std::mt19937& random) {
+  const std::string alphabet = "0123456789abcRSD-() \t\n";
+  std::uniform_int_distribution<int> count(0, 60);
+  std::uniform_int_distribution<int> length(1, 24);
+  std::uniform_int_distribution<int> pick(0, alphabet.size() - 1);
+  std::uniform_int_distribution<int> separators(1, 3);
+  std::string line = std::to_string(random() % 100000) + " (";
+  for (int i = length(random) % 18; i > 0; --i) {
+    line += alphabet[pick(random)];
+  }
+  line += ")";
+  for (int field = count(random); field > 0; --field) {
+    for (int i = separators(random); i > 0; --i) {
+      line += " \t\n"[random() % 3];
+    }
+    for (int i = length(random); i > 0; --i) {
+      line += "0123456789-RS"[random() % 13];
+    }
+  }
+  if (random() % 2) {
+    line += "\n";
+  }
+  return line;
+}
+}  // namespace
+
+TEST(StatSplitterTest, SplitTest) {
+  for (const Isa isa : kIsas) {
+    Fields fields;
+    const std::string line = "42 (a) b (c)) R 7  42 1\n";
+    ASSERT_TRUE(StatSplitter::Split(isa, line, 3, fields));
+    EXPECT_EQ(fields.comm_end, 12);
+    ASSERT_EQ(fields.count, 3);
+    EXPECT_EQ(fields.Field(line, 0), "R");
+    EXPECT_EQ(fields.Field(line, 2), "42");
+    EXPECT_FALSE(StatSplitter::Split(isa, "42 (truncated", 3, fields));
+  }
+}
+
+TEST(StatSplitterTest, FixturesTest) {
+  for (const auto& entry :
+       std::filesystem::directory_iterator(kTestDataDirPath)) {
+    const std::filesystem::path stat = entry.path() / "stat";
+    if (!std::filesystem::exists(stat)) {
+      continue;
+    }
+    std::string line;
+    std::getline(std::ifstream(stat), line);
+    const std::vector<std::string> scalar = Split(Isa::kScalar, line, 64);
+    ASSERT_GT(scalar.size(), 40) << stat;
+    for (const Isa isa : kIsas) {
+      EXPECT_EQ(Split(isa, line, 64), scalar) << stat;
+    }
+  }
+}
+
+// The vector versions agree with the scalar one on random lines, for every
+// number of fields asked for.
+TEST(StatSplitterTest, FuzzTest) {
+  std::mt19937 random(20261019);
+  for (int i = 0; i < 20000; ++i) {
+    const std::string line = RandomLine(random);
+    const std::size_t maxFields = random() % 70;
+    const std::vector<std::string> scalar =
+        Split(Isa::kScalar, line, maxFields);
+    for (const Isa isa : kIsas) {
+      ASSERT_EQ(Split(isa, line, maxFields), scalar) << '"' << line << '"';
+    }
+  }
+}
+
+TEST(StatSplitterTest, SelectedTest) {
+  EXPECT_TRUE(StatSplitter::Supported(Isa::kScalar));
+  EXPECT_TRUE(StatSplitter::Supported(StatSplitter::Selected()));
+}
@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/state_sampler.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using std::filesystem::path;
+
+TEST(RunStatesTest, AddTest) {
+  RunStates states;
+  EXPECT_EQ(states.Samples(), 0);
+  EXPECT_EQ(states.BlockedShare(), -1);
+  for (const char state : {'R', 'S', 'I', 'D', 'D', 'Z', 'T', 't', 'X'}) {
+    states.Add(state);
+  }
+  EXPECT_EQ(states.running, 1);
+  EXPECT_EQ(states.sleeping, 2);
+  EXPECT_EQ(states.blocked, 2);
+  EXPECT_EQ(states.zombie, 1);
+  EXPECT_EQ(states.other, 3);
+  EXPECT_EQ(states.Samples(), 9);
+  EXPECT_FLOAT_EQ(states.BlockedShare(), 2.0 / 9);
+}
+
+// A proc filesystem of processes with a stat file each.
+class StateSamplerTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    ScratchDir::SetUp();
+    SetState(10, "worker", 'R');
+    SetState(20, "a (b) c", 'S');
+  }
+  void SetState(int pid, const std::string& comm, char state) {
+    const path process = dir_ / std::to_string(pid);
+    std::filesystem::create_directories(process);
+    std::ofstream(process / "stat")
+        << pid << " (" << comm << ") " << state
+        << " 1 1 1 0 -1 0 0 0 0 0 1 1 0 0 20 0 1 0 100 4096 1\n";
+  }
+};
+
+TEST_F(StateSamplerTest, ReadStateTest) {
+  const int fd = open((dir_ / "20" / "stat").c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  // After the last parenthesis, and again from the start.
+  EXPECT_EQ(StateSampler::ReadState(fd), 'S');
+  EXPECT_EQ(StateSampler::ReadState(fd), 'S');
+  close(fd);
+  EXPECT_EQ(StateSampler::ReadState(-1), '\0');
+}
+
+TEST_F(StateSamplerTest, StepTest) {
+  StateSampler sampler(dir_.string());
+  sampler.Tick({10, 20, 30});
+  sampler.Step();
+  sampler.Step();
+  // The open file is read again.
+  SetState(20, "a (b) c", 'D');
+  sampler.Step();
+  sampler.Step();
+  // Nothing until the interval ends.
+  EXPECT_EQ(sampler.Get(10).Samples(), 0);
+  sampler.Tick({10, 20, 30});
+  EXPECT_EQ(sampler.Get(10).running, 4);
+  EXPECT_FLOAT_EQ(sampler.Get(10).BlockedShare(), 0);
+  EXPECT_EQ(sampler.Get(20).sleeping, 2);
+  EXPECT_FLOAT_EQ(sampler.Get(20).BlockedShare(), 0.5);
+  // Gone, or never there.
+  EXPECT_EQ(sampler.Get(30).Samples(), 0);
+
+  // Pids that are not handed over again are not sampled.
+  sampler.Tick({20});
+  sampler.Step();
+  sampler.Tick({20});
+  EXPECT_EQ(sampler.Get(10).Samples(), 0);
+  EXPECT_EQ(sampler.Get(20).blocked, 1);
+}
+
+TEST(StateSamplerProcTest, BackgroundTest) {
+  StateSampler sampler("/proc", std::chrono::milliseconds(10));
+  sampler.Start();
+  sampler.Tick({getpid()});
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  sampler.Tick({getpid()});
+  const RunStates states = sampler.Get(getpid());
+  EXPECT_GE(states.Samples(), 3);
+  // A live process is never seen as a zombie or stopped.
+  EXPECT_EQ(states.zombie + states.other, 0);
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "../include/string_table.h"
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+TEST(StringTableTest, InternTest) {
+  StringTable table;
+  const StringTable::Handle first = table.Intern("systemd");
+  const StringTable::Handle second = table.Intern(string("systemd"));
+  const StringTable::Handle other = table.Intern("bash");
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, other);
+  EXPECT_EQ(table.View(first), "systemd");
+  EXPECT_EQ(table.View(other), "bash");
+  EXPECT_EQ(table.Size(), 2);
+  EXPECT_EQ(table.Intern(""), StringTable::kEmpty);
+  EXPECT_EQ(table.View(StringTable::kEmpty), "");
+}
+
+TEST(StringTableTest, NullTerminatedTest) {
+  StringTable table;
+  const StringTable::Handle handle = table.Intern(string("root\0x", 4));
+  EXPECT_EQ(table.View(handle).data()[4], '\0');
+}
+
+TEST(StringTableTest, ReleaseTest) {
+  StringTable table;
+  const StringTable::Handle handle = table.Intern("sshd");
+  table.Retain(handle);
+  table.Release(handle);
+  EXPECT_EQ(table.Size(), 1);
+  EXPECT_EQ(table.View(handle), "sshd");
+  table.Release(handle);
+  EXPECT_EQ(table.Size(), 0);
+  // The freed handle is reused.
+  EXPECT_EQ(table.Intern("cron"), handle);
+}
+
+TEST(StringTableTest, ChunkReuseTest) {
+  StringTable table;
+  vector<StringTable::Handle> handles;
+  for (int i = 0; i < 20000; ++i) {
+    handles.push_back(table.Intern("/usr/bin/worker --id=" + std::to_string(i)));
+  }
+  const std::size_t bytes = table.ArenaBytes();
+  EXPECT_GT(bytes, 64 * 1024);
+  for (int round = 0; round < 5; ++round) {
+    for (const StringTable::Handle handle : handles) {
+      table.Release(handle);
+    }
+    handles.clear();
+    for (int i = 0; i < 20000; ++i) {
+      handles.push_back(
+          table.Intern("/usr/bin/worker --id=" + std::to_string(round) + "-" +
+                       std::to_string(i)));
+    }
+    EXPECT_EQ(table.Size(), 20000);
+    EXPECT_EQ(table.View(handles[12345]),
+              "/usr/bin/worker --id=" + std::to_string(round) + "-12345");
+  }
+  // Churn is served from recycled chunks rather than new ones.
+  EXPECT_LE(table.ArenaBytes(), bytes + 64 * 1024);
+}
+
+TEST(StringTableTest, LongStringTest) {
+  StringTable table;
+  const string value(100 * 1024, 'x');
+  const StringTable::Handle handle = table.Intern(value);
+  const StringTable::Handle small = table.Intern("small");
+  EXPECT_EQ(table.View(handle), value);
+  EXPECT_EQ(table.View(small), "small");
+}
+
+TEST(InternedStringTest, CopyTest) {
+  const std::size_t size = StringTable::Global().Size();
+  {
+    InternedString a("interned-string-test");
+    InternedString b(a);
+    InternedString c("interned-string-test");
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(StringTable::Global().Size(), size + 1);
+    InternedString d(std::move(a));
+    EXPECT_EQ(d.View(), "interned-string-test");
+    EXPECT_EQ(a.Handle(), StringTable::kEmpty);
+    b = InternedString("other-interned-string");
+    EXPECT_EQ(StringTable::Global().Size(), size + 2);
+  }
+  EXPECT_EQ(StringTable::Global().Size(), size);
+}
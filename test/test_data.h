@@ -0,0 +1,68 @@
+#ifndef MONITOR_TEST_DATA_H
+#define MONITOR_TEST_DATA_H
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../include/linux_system.h"
+
+// The fixtures in test/testdata, found from the repository root where the
+// tests run.
+const std::filesystem::path kTestDataDirPath =
+    std::filesystem::current_path() / "test" / "testdata";
+const std::filesystem::path kOSVersionFilePath =
+    kTestDataDirPath / "fake_os_release";
+const std::filesystem::path kkernelInfoFilePath =
+    kTestDataDirPath / "fake_proc_version";
+const std::filesystem::path kEtcPasswdFilePath =
+    kTestDataDirPath / "fake_etc_passwd";
+const std::filesystem::path kMemInfoFilePath =
+    kTestDataDirPath / "recent_meminfo";
+const std::filesystem::path kStatsFilePath = kTestDataDirPath / "recent_stat";
+const std::filesystem::path kUptimeFilePath =
+    kTestDataDirPath / "recent_uptime";
+// An older sample of the same files.
+const std::filesystem::path kFakeMemInfoFilePath =
+    kTestDataDirPath / "fake_meminfo";
+const std::filesystem::path kFakeStatsFilePath = kTestDataDirPath / "fake_stat";
+const std::filesystem::path kFakeUptimeFilePath =
+    kTestDataDirPath / "fake_uptime";
+// The memory of the monitor, as in /proc/self/statm.
+const std::filesystem::path kStatmFilePath = kTestDataDirPath / "fake_statm";
+
+// A system that reads the fixture global files, and the processes in
+// `procsDirPath`.
+inline LinuxSystem FixtureSystem(
+    const std::filesystem::path& procsDirPath = kTestDataDirPath,
+    const std::filesystem::path& memInfoFilePath = kMemInfoFilePath,
+    const std::filesystem::path& statsFilePath = kStatsFilePath,
+    const std::filesystem::path& uptimeFilePath = kUptimeFilePath) {
+  return LinuxSystem(procsDirPath.string(), kTestDataDirPath.string(),
+                     memInfoFilePath.string(), kOSVersionFilePath.string(),
+                     kTestDataDirPath.string(), statsFilePath.string(),
+                     uptimeFilePath.string(), kkernelInfoFilePath.string(),
+                     kEtcPasswdFilePath.string());
+}
+
+// A fixture with an empty directory of its own in `dir_`, removed after each
+// test. The name holds the test and the pid, as the tests may run in
+// parallel processes.
+class ScratchDir : public testing::Test {
+ protected:
+  void SetUp() override {
+    const testing::TestInfo* test =
+        testing::UnitTest::GetInstance()->current_test_info();
+    dir_ = std::filesystem::temp_directory_path() /
+           (std::string(test->test_suite_name()) + "_" + test->name() + "_" +
+            std::to_string(getpid()));
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+  }
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+  std::filesystem::path dir_;
+};
+
+#endif
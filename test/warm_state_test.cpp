@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include "test_data.h"
+#include "../include/linux_parser.h"
+#include "../include/linux_system.h"
+#include "../include/warm_state.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using std::string;
+using std::filesystem::path;
+
+
+static WarmProcess Find(const WarmState& state, int pid) {
+  for (const WarmProcess& process : state.processes) {
+    if (process.pid == pid) {
+      return process;
+    }
+  }
+  return WarmProcess();
+}
+
+class WarmStateTest : public ScratchDir {
+ protected:
+  void SetUp() override {
+    ScratchDir::SetUp();
+    file_ = dir_ / "monitor-state";
+  }
+  LinuxSystem NewSystem() {
+    return FixtureSystem();
+  }
+  path file_;
+};
+
+TEST_F(WarmStateTest, SaveLoadTest) {
+  WarmState state;
+  state.boot_id = "5f0e2f6c";
+  state.time = 1234.5;
+  state.cpu_active_jiffies = 10;
+  state.cpu_total_jiffies = 40;
+  state.passwd_mtime = 99;
+  state.uid_map = {{"0", "root"}, {"1000", "foo"}};
+  state.processes = {{1, 5, 700, 1234.25, "root", "/sbin/init"},
+                     {42, 6, 800, 1234.5, "foo", "bash"},
+                     {43, 7, 900, 1234.5, "foo", "bash"}};
+  ASSERT_TRUE(WarmStart::Save(state, file_));
+  EXPECT_EQ(std::filesystem::status(file_).permissions(),
+            std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+
+  WarmState loaded;
+  ASSERT_TRUE(WarmStart::Load(file_, loaded));
+  EXPECT_EQ(loaded.boot_id, "5f0e2f6c");
+  EXPECT_DOUBLE_EQ(loaded.time, 1234.5);
+  EXPECT_EQ(loaded.cpu_active_jiffies, 10);
+  EXPECT_EQ(loaded.cpu_total_jiffies, 40);
+  EXPECT_EQ(loaded.passwd_mtime, 99);
+  EXPECT_EQ(loaded.uid_map, state.uid_map);
+  ASSERT_EQ(loaded.processes.size(), 3);
+  EXPECT_EQ(loaded.processes[2].pid, 43);
+  EXPECT_EQ(loaded.processes[2].total_ticks, 900);
+  EXPECT_EQ(loaded.processes[2].command, "bash");
+  EXPECT_DOUBLE_EQ(loaded.processes[0].sample_time, 1234.25);
+}
+
+TEST_F(WarmStateTest, CorruptFileTest) {
+  WarmState state;
+  state.processes = {{1, 5, 700, 1234.25, "root", "/sbin/init"}};
+  ASSERT_TRUE(WarmStart::Save(state, file_));
+  std::filesystem::resize_file(file_, std::filesystem::file_size(file_) - 1);
+  EXPECT_FALSE(WarmStart::Load(file_, state));
+  std::ofstream(file_) << "not a state file";
+  EXPECT_FALSE(WarmStart::Load(file_, state));
+  EXPECT_FALSE(WarmStart::Load(file_.string() + ".missing", state));
+}
+
+// Counts that the file cannot hold are rejected before anything is allocated
+// for them.
+TEST_F(WarmStateTest, CorruptCountTest) {
+  // The file ends with the uid map, string and process counts, all 0.
+  ASSERT_TRUE(WarmStart::Save(WarmState(), file_));
+  const auto size = std::filesystem::file_size(file_);
+  for (const auto offset : {size - 12, size - 8, size - 4}) {
+    ASSERT_TRUE(WarmStart::Save(WarmState(), file_));
+    std::fstream file(file_, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    const uint32_t count = 0x7fffffff;
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.close();
+    WarmState state;
+    EXPECT_FALSE(WarmStart::Load(file_, state)) << "offset " << offset;
+  }
+}
+
+TEST_F(WarmStateTest, DefaultPathTest) {
+  const char* previous = std::getenv("XDG_RUNTIME_DIR");
+  setenv("XDG_RUNTIME_DIR", "/run/user/1000", 1);
+  EXPECT_EQ(WarmStart::DefaultPath(), path("/run/user/1000/monitor-state"));
+  unsetenv("XDG_RUNTIME_DIR");
+  EXPECT_TRUE(WarmStart::DefaultPath().empty());
+  if (previous != nullptr) {
+    setenv("XDG_RUNTIME_DIR", previous, 1);
+  }
+}
+
+TEST_F(WarmStateTest, CaptureTest) {
+  LinuxSystem system = NewSystem();
+  system.Processes();
+  const WarmState state = system.Capture();
+  EXPECT_EQ(state.boot_id, "5f0e2f6c-6a43-4c7a-9d59-0c6b2a6e1d3a");
+  EXPECT_EQ(state.processes.size(), 4);
+  EXPECT_EQ(Find(state, 103).user, "foo");
+  EXPECT_EQ(Find(state, 1).command, "/sbin/init");
+  EXPECT_EQ(state.uid_map.at("0"), "root");
+  EXPECT_GE(state.cpu_total_jiffies, -1);
+}
+
+TEST_F(WarmStateTest, RestoreTest) {
+  LinuxSystem first = NewSystem();
+  first.Processes();
+  WarmState state = first.Capture();
+  // Saved identities are reused without reading the status and cmdline
+  // files, unless the pid now belongs to another process.
+  for (WarmProcess& process : state.processes) {
+    process.total_ticks = 0;
+    process.command = "warm " + std::to_string(process.pid);
+    if (process.pid == 75) {
+      process.start_time += 1;
+    }
+  }
+  state.time -= 1;
+  LinuxSystem second = NewSystem();
+  ASSERT_TRUE(second.Restore(state));
+  for (Process& process : second.Processes()) {
+    if (process.Pid() == 75) {
+      EXPECT_EQ(process.Command().rfind("snapfuse", 0), 0);
+    } else {
+      EXPECT_EQ(process.Command(), "warm " + std::to_string(process.Pid()));
+    }
+  }
+}
+
+TEST_F(WarmStateTest, RejectTest) {
+  LinuxSystem first = NewSystem();
+  first.Processes();
+  WarmState state = first.Capture();
+  LinuxSystem second = NewSystem();
+  state.boot_id = "another boot";
+  EXPECT_FALSE(second.Restore(state));
+  state = first.Capture();
+  state.time -= WarmStart::kMaxAgeSeconds + 1;
+  EXPECT_FALSE(second.Restore(state));
+  state = first.Capture();
+  state.time += 60;
+  EXPECT_FALSE(second.Restore(state));
+}